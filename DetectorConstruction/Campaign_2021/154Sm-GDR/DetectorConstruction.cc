@@ -20,7 +20,10 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "DetectorConstruction.hh"
 #include "DetectorConstructionConfig.hh"
+#include "DetectorConstructionFactory.hh"
 #include "utrConfig.h"
+#include "utrBiasingTools.hh"
+#include "utrRegionTools.hh"
 
 #include "G4PhysicalConstants.hh"
 #include "G4SystemOfUnits.hh"
@@ -51,6 +54,7 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "EnergyDepositionSD.hh"
 #include "G4SDManager.hh"
 #include "ParticleSD.hh"
+#include "PhaseSpaceSD.hh"
 #include "SecondarySD.hh"
 
 #include <string>
@@ -215,6 +219,10 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
 
   const auto collimatorRoomCutoffPoint = collimatorRoomCollimatorToTargetPos + collimatorRoomCollimatorLength + 100. * mm; // Just some extra space
 
+  const auto phaseSpacePlaneToCollimator = 1. * mm; // Arbitrary, between the collimator and the first lead wall
+  const auto phaseSpacePlaneThickness = 1. * um; // Arbitrary, thin enough to not change the beam
+  const auto phaseSpacePlaneRadius = collimatorRoomCollimatorWidth / 2.; // Covers the downstream face of the collimator
+
   // --------------- Downstream ---------------
 
   const auto utrDownstreamWallToTargetPos = utrRoomLength - utrUpstreamWallToTargetPos;
@@ -301,11 +309,13 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
 
   auto *utrFloorSolid = new G4Box("utrFloorSolid", worldX / 2., utrFloorThickness / 2., worldZ / 2.);
   auto *utrFloorLogical = new G4LogicalVolume(utrFloorSolid, nist->FindOrBuildMaterial("G4_CONCRETE"), "utrFloorLogical");
+  utrRegionTools::addLogicalVolume("infrastructure", utrFloorLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, -(utrBeamLineHeight + utrFloorThickness / 2.), 0), utrFloorLogical, "utrFloor", worldLogical, false, 0);
   utrFloorLogical->SetVisAttributes(grey);
 
   auto *utrSideWallSolid = new G4Box("utrSideWallSolid", utrSideWallThickness / 2., utrRoomHeight / 2., utrRoomLength / 2.);
   auto *utrSideWallLogical = new G4LogicalVolume(utrSideWallSolid, nist->FindOrBuildMaterial("G4_CONCRETE"), "utrSideWallLogical");
+  utrRegionTools::addLogicalVolume("infrastructure", utrSideWallLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(-(utrBeamLineToSideWall + utrSideWallThickness / 2.), utrRoomHeight / 2. - utrBeamLineHeight, utrRoomLength / 2. - utrUpstreamWallToTargetPos), utrSideWallLogical, "utrSideWall", worldLogical, false, 0);
   auto utrSideWallVis = G4VisAttributes(grey);
   utrSideWallVis.SetForceWireframe(true);
@@ -315,6 +325,7 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
   auto *utrUpstreamWallSolidHole = new G4Tubs("utrUpstreamWallSolidHole", 0., utrUpstreamWallHoleAperture / 2., utrUpstreamWallThickness / 2. + subtractionSolidBuffer, 0., twopi);
   auto *utrUpstreamWallSolid = new G4SubtractionSolid("utrUpstreamWallSolid", utrUpstreamWallSolidBox, utrUpstreamWallSolidHole, nullptr, G4ThreeVector(0, -(utrRoomHeight / 2. - utrBeamLineHeight), 0));
   auto *utrUpstreamWallLogical = new G4LogicalVolume(utrUpstreamWallSolid, nist->FindOrBuildMaterial("G4_CONCRETE"), "utrUpstreamWallLogical");
+  utrRegionTools::addLogicalVolume("infrastructure", utrUpstreamWallLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, utrRoomHeight / 2. - utrBeamLineHeight, -(utrUpstreamWallToTargetPos + utrUpstreamWallThickness / 2.)), utrUpstreamWallLogical, "utrUpstreamWall", worldLogical, false, 0);
   utrUpstreamWallLogical->SetVisAttributes(transparentGrey);
 
@@ -322,6 +333,7 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
   auto *utrDownstreamWallSolidHole = new G4Tubs("utrDownstreamWallSolidHole", 0., utrDownstreamWallHoleAperture / 2., utrDownstreamWallThickness / 2. + subtractionSolidBuffer, 0., twopi);
   auto *utrDownstreamWallSolid = new G4SubtractionSolid("utrDownstreamWallSolid", utrDownstreamWallSolidBox, utrDownstreamWallSolidHole, nullptr, G4ThreeVector(0, -(utrRoomHeight / 2. - utrBeamLineHeight), 0));
   auto *utrDownstreamWallLogical = new G4LogicalVolume(utrDownstreamWallSolid, nist->FindOrBuildMaterial("G4_CONCRETE"), "utrDownstreamWallLogical");
+  utrRegionTools::addLogicalVolume("infrastructure", utrDownstreamWallLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, utrRoomHeight / 2. - utrBeamLineHeight, utrDownstreamWallToTargetPos + utrDownstreamWallThickness / 2.), utrDownstreamWallLogical, "utrDownstreamWall", worldLogical, false, 0);
   utrDownstreamWallLogical->SetVisAttributes(transparentGrey);
 
@@ -341,15 +353,25 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
   auto *collimatorSolidSubstractionHole = new G4Tubs("collimatorSolidSubstractionHole", 0., collimatorRoomCollimatorAperture / 2., collimatorRoomCollimatorLength / 2. + subtractionSolidBuffer, 0., twopi);
   auto *collimatorSolid = new G4SubtractionSolid("collimatorSolid", collimatorSolidSubstractionBox, collimatorSolidSubstractionHole);
   auto *collimatorLogical = new G4LogicalVolume(collimatorSolid, nist->FindOrBuildMaterial("G4_Pb"), "collimatorLogical");
+  utrRegionTools::addLogicalVolume("shielding", collimatorLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -(collimatorRoomCollimatorToTargetPos + collimatorRoomCollimatorLength / 2.)), collimatorLogical, "collimator", worldLogical, false, 0);
   collimatorLogical->SetVisAttributes(green);
 
+  // --------------- Phase-Space Plane ---------------
+  // Records the collimated beam for a two-stage simulation, if a phase-space file is given with /utr/phaseSpace/record (see PhaseSpaceSD)
+
+  auto *phaseSpacePlaneSolid = new G4Tubs("phaseSpacePlaneSolid", 0., phaseSpacePlaneRadius, phaseSpacePlaneThickness / 2., 0., twopi);
+  auto *phaseSpacePlaneLogical = new G4LogicalVolume(phaseSpacePlaneSolid, nist->FindOrBuildMaterial("G4_AIR"), "phaseSpacePlaneLogical");
+  new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -(collimatorRoomCollimatorToTargetPos - phaseSpacePlaneToCollimator - phaseSpacePlaneThickness / 2.)), phaseSpacePlaneLogical, "phaseSpacePlane", worldLogical, false, 0);
+  phaseSpacePlaneLogical->SetVisAttributes(invisible);
+
   // --------------- Collimator Room Pb Walls ---------------
 
   auto *collimatorRoomFirstLeadWallSolidBox = new G4Box("collimatorRoomFirstLeadWallSolidBox", collimatorRoomFirstLeadWallWidth / 2., collimatorRoomFirstLeadWallHeight / 2., collimatorRoomFirstLeadWallLength / 2.);
   auto *collimatorRoomFirstLeadWallSolidHole = new G4Tubs("collimatorRoomFirstLeadWallSolidHole", 0., collimatorRoomFirstLeadWallHoleAperture / 2., collimatorRoomFirstLeadWallLength / 2. + subtractionSolidBuffer, 0., twopi);
   auto *collimatorRoomFirstLeadWallSolid = new G4SubtractionSolid("collimatorRoomFirstLeadWallSolid", collimatorRoomFirstLeadWallSolidBox, collimatorRoomFirstLeadWallSolidHole);
   auto *collimatorRoomFirstLeadWallLogical = new G4LogicalVolume(collimatorRoomFirstLeadWallSolid, nist->FindOrBuildMaterial("G4_Pb"), "collimatorRoomFirstLeadWallLogical");
+  utrRegionTools::addLogicalVolume("shielding", collimatorRoomFirstLeadWallLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -(collimatorRoomFirstLeadWallToTargetPos + collimatorRoomFirstLeadWallLength / 2.)), collimatorRoomFirstLeadWallLogical, "collimatorRoomFirstLeadWall", worldLogical, false, 0);
   collimatorRoomFirstLeadWallLogical->SetVisAttributes(green);
 
@@ -357,6 +379,7 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
   auto *collimatorRoomSecondLeadWallSolidHole = new G4Tubs("collimatorRoomSecondLeadWallSolidHole", 0., collimatorRoomSecondLeadWallHoleAperture / 2., collimatorRoomSecondLeadWallLength / 2. + subtractionSolidBuffer, 0., twopi);
   auto *collimatorRoomSecondLeadWallSolid = new G4SubtractionSolid("collimatorRoomSecondLeadWallSolid", collimatorRoomSecondLeadWallSolidBox, collimatorRoomSecondLeadWallSolidHole);
   auto *collimatorRoomSecondLeadWallLogical = new G4LogicalVolume(collimatorRoomSecondLeadWallSolid, nist->FindOrBuildMaterial("G4_Pb"), "collimatorRoomSecondLeadWallLogical");
+  utrRegionTools::addLogicalVolume("shielding", collimatorRoomSecondLeadWallLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -(collimatorRoomSecondLeadWallToTargetPos + collimatorRoomSecondLeadWallLength / 2.)), collimatorRoomSecondLeadWallLogical, "collimatorRoomSecondLeadWall", worldLogical, false, 0);
   collimatorRoomSecondLeadWallLogical->SetVisAttributes(green);
 
@@ -366,6 +389,7 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
   auto *utrFirstLeadWallSolidHole = new G4Tubs("utrFirstLeadWallSolidHole", 0., utrFirstLeadWallHoleAperture / 2., utrFirstLeadWallLength / 2. + subtractionSolidBuffer, 0., twopi);
   auto *utrFirstLeadWallSolid = new G4SubtractionSolid("utrFirstLeadWallSolid", utrFirstLeadWallSolidBox, utrFirstLeadWallSolidHole);
   auto *utrFirstLeadWallLogical = new G4LogicalVolume(utrFirstLeadWallSolid, nist->FindOrBuildMaterial("G4_Pb"), "utrFirstLeadWallLogical");
+  utrRegionTools::addLogicalVolume("shielding", utrFirstLeadWallLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -(utrFirstLeadWallToTargetPos + utrFirstLeadWallLength / 2.)), utrFirstLeadWallLogical, "utrFirstLeadWall", worldLogical, false, 0);
   utrFirstLeadWallLogical->SetVisAttributes(green);
 
@@ -373,6 +397,7 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
   auto *utrSecondLeadWallSolidHole = new G4Box("utrSecondLeadWallSolidHole", utrSecondLeadWallHoleSize / 2., utrSecondLeadWallHoleSize / 2., utrSecondLeadWallLength / 2. + subtractionSolidBuffer);
   auto *utrSecondLeadWallSolid = new G4SubtractionSolid("utrSecondLeadWallSolid", utrSecondLeadWallSolidBox, utrSecondLeadWallSolidHole);
   auto *utrSecondLeadWallLogical = new G4LogicalVolume(utrSecondLeadWallSolid, nist->FindOrBuildMaterial("G4_Pb"), "utrSecondLeadWallLogical");
+  utrRegionTools::addLogicalVolume("shielding", utrSecondLeadWallLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -(utrSecondLeadWallToTargetPos + utrSecondLeadWallLength / 2.)), utrSecondLeadWallLogical, "utrSecondLeadWall", worldLogical, false, 0);
   utrSecondLeadWallLogical->SetVisAttributes(green);
 
@@ -382,16 +407,19 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
   auto *activationTargetHolderSolidGroove = new G4Tubs("activationTargetHolderSolidGroove", 0., activationTargetHolderGrooveDiameter / 2., activationTargetHolderGrooveLength / 2., 0., twopi);
   auto *activationTargetHolderSolid = new G4SubtractionSolid("activationTargetHolderSolid", activationTargetHolderSolidBox, activationTargetHolderSolidGroove, nullptr, G4ThreeVector(0., activationTargetHolderHeight / 2. + activationTargetHolderGrooveDiameter / 2. - activationTargetHolderGrooveDepth, 0.));
   auto *activationTargetHolderLogical = new G4LogicalVolume(activationTargetHolderSolid, nist->FindOrBuildMaterial("G4_POLYETHYLENE"), "activationTargetHolderLogical");
+  utrRegionTools::addLogicalVolume("infrastructure", activationTargetHolderLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, -(activationTargetHolderToBeamLine + activationTargetHolderHeight / 2.), activationTargetHolderToTargetPos + activationTargetHolderLength / 2.), activationTargetHolderLogical, "activationTargetHolder", worldLogical, false, 0);
 
   auto *activationTargetHolderBaseRodSolid = new G4Tubs("activationTargetHolderBaseRodSolid", 0., activationTargetHolderBaseRodDiameter / 2., activationTargetHolderBaseRodHeight / 2., 0., twopi);
   auto *activationTargetHolderBaseRodLogical = new G4LogicalVolume(activationTargetHolderBaseRodSolid, nist->FindOrBuildMaterial("G4_Al"), "activationTargetHolderBaseRodLogical");
+  utrRegionTools::addLogicalVolume("infrastructure", activationTargetHolderBaseRodLogical);
   new G4PVPlacement(new G4RotationMatrix(G4ThreeVector(1., 0., 0.), 90. * degree), G4ThreeVector(0, -(activationTargetHolderToBeamLine + activationTargetHolderHeight + activationTargetHolderBaseRodHeight / 2.), activationTargetHolderToTargetPos + activationTargetHolderLength / 2.), activationTargetHolderBaseRodLogical, "activationTargetHolderBaseRod", worldLogical, false, 0);
 
   // --------------- Beam Dump ---------------
 
   auto *beamDumpSolid = new G4Box("beamDumpSolid", beamDumpWidth / 2., beamDumpHeight / 2., beamDumpLength / 2.);
   auto *beamDumpLogical = new G4LogicalVolume(beamDumpSolid, nist->FindOrBuildMaterial("G4_Pb"), "beamDumpLogical");
+  utrRegionTools::addLogicalVolume("shielding", beamDumpLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, 0, beamDumpToTargetPos + beamDumpLength / 2.), beamDumpLogical, "beamDump", worldLogical, false, 0);
   beamDumpLogical->SetVisAttributes(green);
 
@@ -402,6 +430,7 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
 
   auto *beamPipeSolid = new G4Tubs("beamPipeSolid", 0., beamPipeOuterDiameter / 2., beamPipeLength / 2., 0., twopi);
   auto *beamPipeLogical = new G4LogicalVolume(beamPipeSolid, nist->FindOrBuildMaterial("G4_PLEXIGLASS"), "beamPipeLogical");
+  utrRegionTools::addLogicalVolume("infrastructure", beamPipeLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, 0, beamPipeZ), beamPipeLogical, "beamPipe", worldLogical, false, 0);
 
   auto *beamPipeVacuumSolid = new G4Tubs("beamPipeVacuumSolid", 0., beamPipeInnerDiameter / 2., beamPipeLength / 2., 0., twopi);
@@ -413,16 +442,19 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
 
   auto *beamPipeUpstreamCapSolid = new G4Tubs("beamPipeUpstreamCapSolid", beamPipeOuterDiameter / 2., beamPipeUpstreamCapOuterDiameter / 2., beamPipeUpstreamCapLength / 2., 0., twopi);
   auto *beamPipeUpstreamCapLogical = new G4LogicalVolume(beamPipeUpstreamCapSolid, nist->FindOrBuildMaterial("G4_PLEXIGLASS"), "beamPipeUpstreamCapLogical");
+  utrRegionTools::addLogicalVolume("infrastructure", beamPipeUpstreamCapLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, 0, beamPipeZ - (beamPipeLength / 2. - beamPipeUpstreamCapLength / 2.)), beamPipeUpstreamCapLogical, "beamPipeUpstreamCap", worldLogical, false, 0);
 
   auto *beamPipeUpstreamCapLidSolid = new G4Tubs("beamPipeUpstreamCapLidSolid", 0., beamPipeUpstreamCapOuterDiameter / 2., beamPipeUpstreamCapLidThickness / 2., 0., twopi);
   auto *beamPipeUpstreamCapLidLogical = new G4LogicalVolume(beamPipeUpstreamCapLidSolid, nist->FindOrBuildMaterial("G4_PLEXIGLASS"), "beamPipeUpstreamCapLidLogical");
+  utrRegionTools::addLogicalVolume("infrastructure", beamPipeUpstreamCapLidLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, 0, beamPipeZ - (beamPipeLength / 2. + beamPipeUpstreamCapLidThickness / 2.)), beamPipeUpstreamCapLidLogical, "beamPipeUpstreamCapLid", worldLogical, false, 0);
 
   // Insert pipe
 
   auto *beamPipeInsertPipeLidSolid = new G4Tubs("beamPipeInsertPipeLidSolid", 0., beamPipeInsertPipeLidOuterDiameter / 2., beamPipeInsertPipeLidThickness / 2., 0., twopi);
   auto *beamPipeInsertPipeLidLogical = new G4LogicalVolume(beamPipeInsertPipeLidSolid, nist->FindOrBuildMaterial("G4_PLEXIGLASS"), "beamPipeInsertPipeLidLogical");
+  utrRegionTools::addLogicalVolume("infrastructure", beamPipeInsertPipeLidLogical);
   new G4PVPlacement(nullptr, G4ThreeVector(0, 0, beamPipeZ + (beamPipeLength + beamPipeInsertPipeLidThickness) / 2.), beamPipeInsertPipeLidLogical, "beamPipeInsertPipeLid", worldLogical, false, 0);
 
   auto *beamPipeInsertPipeSolid = new G4Tubs("beamPipeInsertPipeSolid", beamPipeInsertPipeInnerDiameter / 2., beamPipeInnerDiameter / 2., beamPipeInsertPipeMainLength / 2., 0., twopi);
@@ -475,7 +507,9 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
 #endif
 
   // --------------- Targets ---------------
-  // TARGET variable content is supplied by the cmake variable TARGET supplied via the -DTARGET=VALUE argument to cmake
+  // TARGET is supplied at runtime via the 'utr --geometry-parameter TARGET=VALUE' argument,
+  // its default TARGET_DEFAULT by the cmake variable TARGET supplied via the -DTARGET=VALUE argument to cmake
+  const string TARGET = DetectorConstructionFactory::GetParameter("TARGET", TARGET_DEFAULT);
   // Geometric beam widening from 8mm collimator to target position:
   // From H.R. Weller et al. Prog. Part. Nucl. Phys. 62, 257 (2009): "collimator is located about 60 m away from the collision point."
   // From U. Friman-Gayer and S. Finch private communication: "It is 53 m from the beam collision point to collimator"
@@ -513,6 +547,7 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
     auto *target154SmBothContainersIntermediateSolid = new G4SubtractionSolid("target154SmBothContainersIntermediateSolid", target154SmBothContainersNoLidRecessSolid, target154SmContainerLidRecessSolid, nullptr, G4ThreeVector(0, 0, target154SmBothContainersLength / 2.));
     auto *target154SmBothContainersSolid = new G4SubtractionSolid("target154SmBothContainersSolid", target154SmBothContainersIntermediateSolid, target154SmContainerLidRecessSolid, nullptr, G4ThreeVector(0, 0, -target154SmBothContainersLength / 2.));
     auto *target154SmBothContainersLogical = new G4LogicalVolume(target154SmBothContainersSolid, nist->FindOrBuildMaterial("G4_POLYETHYLENE"), "target154SmBothContainersLogical");
+    utrRegionTools::addLogicalVolume("target", target154SmBothContainersLogical);
     new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -beamPipeZ), target154SmBothContainersLogical, "target154SmBothContainers", beamPipeVacuumLogical, false, 0);
     target154SmBothContainersLogical->SetVisAttributes(lightGrey);
 
@@ -520,6 +555,7 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
     auto *target154SmFirstMaterialLogical = new G4LogicalVolume(target154SmFirstMaterialSolid, target154SmMaterial, "target154SmFirstMaterialLogical");
     new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -(target154SmContainerInnerLength / 2. + target154SmContainerWallThickness)), target154SmFirstMaterialLogical, "target154SmFirstMaterial", target154SmBothContainersLogical, false, 0);
     target154SmFirstMaterialLogical->SetVisAttributes(yellow);
+    utrBiasingTools::addTargetVolume(target154SmFirstMaterialLogical);
 
     auto *target154SmFirstMaterialIrradiatedSolid = new G4Tubs("target154SmFirstMaterialIrradiatedSolid", 0, std::min(beamDiameterAtTargetPos, target154SmContainerInnerDiameter) / 2., target154SmContainerInnerLength / 2., 0., twopi);
     auto *target154SmFirstMaterialIrradiatedLogical = new G4LogicalVolume(target154SmFirstMaterialIrradiatedSolid, target154SmMaterial, "target154SmFirstMaterialIrradiatedLogical");
@@ -530,6 +566,7 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
     auto *target154SmSecondMaterialLogical = new G4LogicalVolume(target154SmSecondMaterialSolid, target154SmMaterial, "target154SmSecondMaterialLogical");
     new G4PVPlacement(nullptr, G4ThreeVector(0, 0, target154SmContainerInnerLength / 2. + target154SmContainerWallThickness), target154SmSecondMaterialLogical, "target154SmSecondMaterial", target154SmBothContainersLogical, false, 0);
     target154SmSecondMaterialLogical->SetVisAttributes(yellow);
+    utrBiasingTools::addTargetVolume(target154SmSecondMaterialLogical);
 
     auto *target154SmSecondMaterialIrradiatedSolid = new G4Tubs("target154SmSecondMaterialIrradiatedSolid", 0, std::min(beamDiameterAtTargetPos, target154SmContainerInnerDiameter) / 2., target154SmContainerInnerLength / 2., 0., twopi);
     auto *target154SmSecondMaterialIrradiatedLogical = new G4LogicalVolume(target154SmSecondMaterialIrradiatedSolid, target154SmMaterial, "target154SmSecondMaterialIrradiatedLogical");
@@ -558,6 +595,7 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
     auto *target140CeContainerLidRecessSolid = new G4Tubs("target140CeContainerLidRecessSolid", 0, target140CeContainerLidRecessInnerDiameter / 2., target140CeContainerWallThickness, 0., twopi);
     auto *target140CeContainerSolid = new G4SubtractionSolid("target140CeContainerSolid", target140CeContainerNoLidRecessSolid, target140CeContainerLidRecessSolid, nullptr, G4ThreeVector(0, 0, target140CeContainerLength / 2.));
     auto *target140CeContainerLogical = new G4LogicalVolume(target140CeContainerSolid, nist->FindOrBuildMaterial("G4_POLYETHYLENE"), "target140CeContainerLogical"); // Polyethylene is an assumption
+    utrRegionTools::addLogicalVolume("target", target140CeContainerLogical);
     new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -beamPipeZ), target140CeContainerLogical, "target140CeContainer", beamPipeVacuumLogical, false, 0);
     target140CeContainerLogical->SetVisAttributes(lightGrey);
 
@@ -565,6 +603,7 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
     auto *target140CeMaterialLogical = new G4LogicalVolume(target140CeMaterialSolid, target140CeMaterial, "target140CeMaterialLogical");
     new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -target140CeContainerWallThickness / 2), target140CeMaterialLogical, "target140CeMaterial", target140CeContainerLogical, false, 0);
     target140CeMaterialLogical->SetVisAttributes(yellow);
+    utrBiasingTools::addTargetVolume(target140CeMaterialLogical);
 
     auto *target140CeMaterialIrradiatedSolid = new G4Tubs("target140CeMaterialIrradiatedSolid", 0, std::min(beamDiameterAtTargetPos, target140CeContainerInnerDiameter) / 2., target140CeContainerInnerLength / 2., 0., twopi);
     auto *target140CeMaterialIrradiatedLogical = new G4LogicalVolume(target140CeMaterialIrradiatedSolid, target140CeMaterial, "target140CeMaterialIrradiatedLogical");
@@ -581,8 +620,10 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
 
     auto *targetNatCMaterialSolid = new G4Tubs("targetNatCMaterialSolid", 0, targetNatCDiameter / 2., targetNatCLength / 2., 0., twopi);
     auto *targetNatCMaterialLogical = new G4LogicalVolume(targetNatCMaterialSolid, targetNatCMaterial, "targetNatCMaterialLogical");
+    utrRegionTools::addLogicalVolume("target", targetNatCMaterialLogical);
     new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -beamPipeZ), targetNatCMaterialLogical, "targetNatCMaterial", beamPipeVacuumLogical, false, 0);
     targetNatCMaterialLogical->SetVisAttributes(yellow);
+    utrBiasingTools::addTargetVolume(targetNatCMaterialLogical);
 
     auto *targetNatCMaterialIrradiatedSolid = new G4Tubs("targetNatCMaterialIrradiatedSolid", 0, std::min(beamDiameterAtTargetPos, targetNatCDiameter) / 2., targetNatCLength / 2., 0., twopi);
     auto *targetNatCMaterialIrradiatedLogical = new G4LogicalVolume(targetNatCMaterialIrradiatedSolid, targetNatCMaterial, "targetNatCMaterialIrradiatedLogical");
@@ -599,8 +640,10 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
 
     auto *targetNatCXLMaterialSolid = new G4Tubs("targetNatCXLMaterialSolid", 0, targetNatCXLDiameter / 2., targetNatCXLLength / 2., 0., twopi);
     auto *targetNatCXLMaterialLogical = new G4LogicalVolume(targetNatCXLMaterialSolid, targetNatCXLMaterial, "targetNatCXLMaterialLogical");
+    utrRegionTools::addLogicalVolume("target", targetNatCXLMaterialLogical);
     new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -beamPipeZ), targetNatCXLMaterialLogical, "targetNatCXLMaterial", beamPipeVacuumLogical, false, 0);
     targetNatCXLMaterialLogical->SetVisAttributes(yellow);
+    utrBiasingTools::addTargetVolume(targetNatCXLMaterialLogical);
 
     auto *targetNatCXLMaterialIrradiatedSolid = new G4Tubs("targetNatCXLMaterialIrradiatedSolid", 0, std::min(beamDiameterAtTargetPos, targetNatCXLDiameter) / 2., targetNatCXLLength / 2., 0., twopi);
     auto *targetNatCXLMaterialIrradiatedLogical = new G4LogicalVolume(targetNatCXLMaterialIrradiatedSolid, targetNatCXLMaterial, "targetNatCXLMaterialIrradiatedLogical");
@@ -619,8 +662,10 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
 
     auto *targetNatSiMaterialSolid = new G4Tubs("targetNatSiMaterialSolid", 0, targetNatSiDiameter / 2., targetNatSiLength / 2., 0., twopi);
     auto *targetNatSiMaterialLogical = new G4LogicalVolume(targetNatSiMaterialSolid, targetNatSiMaterial, "targetNatSiMaterialLogical");
+    utrRegionTools::addLogicalVolume("target", targetNatSiMaterialLogical);
     new G4PVPlacement(nullptr, G4ThreeVector(0, 0, -beamPipeZ), targetNatSiMaterialLogical, "targetNatSiMaterial", beamPipeVacuumLogical, false, 0);
     targetNatSiMaterialLogical->SetVisAttributes(yellow);
+    utrBiasingTools::addTargetVolume(targetNatSiMaterialLogical);
 
     auto *targetNatSiMaterialIrradiatedSolid = new G4Tubs("targetNatSiMaterialIrradiatedSolid", 0, std::min(beamDiameterAtTargetPos, targetNatSiDiameter) / 2., targetNatSiLength / 2., 0., twopi);
     auto *targetNatSiMaterialIrradiatedLogical = new G4LogicalVolume(targetNatSiMaterialIrradiatedSolid, targetNatSiMaterial, "targetNatSiMaterialIrradiatedLogical");
@@ -673,4 +718,8 @@ void DetectorConstruction::ConstructSDandField() {
   ZeroDegreeSD->SetDetectorID(0);
   SetSensitiveDetector("ZeroDegree", ZeroDegreeSD, true);
 #endif
+
+  PhaseSpaceSD *phaseSpaceSD = new PhaseSpaceSD("PhaseSpace", "PhaseSpace");
+  G4SDManager::GetSDMpointer()->AddNewDetector(phaseSpaceSD);
+  SetSensitiveDetector("phaseSpacePlaneLogical", phaseSpaceSD, true);
 }
@@ -5,4 +5,4 @@
 #include <string>
 using std::string;
 
-const string TARGET = "${TARGET}";
+const string TARGET_DEFAULT = "${TARGET}";
@@ -27,6 +27,7 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
  */
 
 #include "DetectorConstruction.hh"
+#include "DetectorConstructionFactory.hh"
 
 // Materials
 #include "G4Material.hh"
@@ -138,9 +139,15 @@ G4VPhysicalVolume *DetectorConstruction::Construct() {
 
 #ifdef USE_TARGETS
   auto rotation = new G4RotationMatrix();
+  // The cmake option ROTATE_TARGET only sets the default, which can be changed with 'utr --geometry-parameter ROTATE_TARGET=true'
 #ifdef ROTATE_TARGET
-  rotation->rotateY(180. * deg);
+  const bool rotateTargetDefault = true;
+#else
+  const bool rotateTargetDefault = false;
 #endif
+  if (DetectorConstructionFactory::GetBoolParameter("ROTATE_TARGET", rotateTargetDefault)) {
+    rotation->rotateY(180. * deg);
+  }
   Sn112116_Target Sn112116_Target(World_Logical);
   Sn112116_Target.Construct(rotation, G4ThreeVector(0., 0., 0.));
 #endif
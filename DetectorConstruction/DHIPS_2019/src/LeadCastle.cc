@@ -14,6 +14,7 @@
 
 #include "LeadCastle.hh"
 #include "Vacuum.hh"
+#include "utrRegionTools.hh"
 
 LeadCastle::LeadCastle(G4LogicalVolume *World_Log) : World_Logical(World_Log) {}
 
@@ -43,6 +44,7 @@ void LeadCastle::ConstructIronShield(G4ThreeVector local_coordinates) {
 
   IronShield1_Solid = new G4Box("IronShield1_Solid", 10 * cm, 25 * cm, (6 * block_z) * 0.5);
   IronShield1_Logical = new G4LogicalVolume(IronShield1_Solid, Fe, "IronShield1_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", IronShield1_Logical);
   IronShield1_Logical->SetVisAttributes(IronShieldvis);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(25. * cm, 0, 0), IronShield1_Logical, "IronShield1", World_Logical, 0, 0);
@@ -54,6 +56,7 @@ void LeadCastle::ConstructIronShield(G4ThreeVector local_coordinates) {
 
   IronShield2_Solid = new G4Box("IronShield2_Solid", 15 * cm, 5 * cm, (6 * block_z) * 0.5);
   IronShield2_Logical = new G4LogicalVolume(IronShield2_Solid, Fe, "IronShield2_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", IronShield2_Logical);
   IronShield2_Logical->SetVisAttributes(IronShieldvis);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(0., 20. * cm, 0), IronShield2_Logical, "IronShield2", World_Logical, 0, 0);
@@ -65,6 +68,7 @@ void LeadCastle::ConstructIronShield(G4ThreeVector local_coordinates) {
 
   IronShield3_Solid = new G4Box("IronShield3_Solid", 10 * cm, 25 * cm, (6 * block_z) * 0.5);
   IronShield3_Logical = new G4LogicalVolume(IronShield3_Solid, Fe, "IronShield3_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", IronShield3_Logical);
   IronShield3_Logical->SetVisAttributes(IronShieldvis);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(-25. * cm, 0., 0), IronShield3_Logical, "IronShield3", World_Logical, 0, 0);
@@ -76,6 +80,7 @@ void LeadCastle::ConstructIronShield(G4ThreeVector local_coordinates) {
 
   IronShield4_Solid = new G4Box("IronShield4_Solid", 15 * cm, 5 * cm, (6 * block_z) * 0.5);
   IronShield4_Logical = new G4LogicalVolume(IronShield4_Solid, Fe, "block24_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", IronShield4_Logical);
   IronShield4_Logical->SetVisAttributes(IronShieldvis);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(0., -20. * cm, 0), IronShield4_Logical, "IronShield4", World_Logical, 0, 0);
@@ -114,6 +119,7 @@ void LeadCastle::ConstructCollimator(G4ThreeVector local_coordinates) {
   }
   G4Box *Collimator_Lead_Top_Bottom_Solid = new G4Box("Collimator_Lead_Top_Bottom_Solid", block_small_x * 0.5, (25 * cm - block_y * 0.5) * 0.5, 4 * 0.5 * block_z);
   G4LogicalVolume *Collimator_Lead_Top_Bottom_Logical = new G4LogicalVolume(Collimator_Lead_Top_Bottom_Solid, Pb, "Collimator_Lead_Top_Bottom_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", Collimator_Lead_Top_Bottom_Logical);
   Collimator_Lead_Top_Bottom_Logical->SetVisAttributes(grey);
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(0., block_y * 0.5 + (25 * cm - block_y * 0.5) * 0.5, 3 * block_z), Collimator_Lead_Top_Bottom_Logical, "Collimator_Lead_Top", World_Logical, 0, 0);
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(0., -block_y * 0.5 - (25 * cm - block_y * 0.5) * 0.5, 3 * block_z), Collimator_Lead_Top_Bottom_Logical, "Collimator_Lead_Bottom", World_Logical, 0, 0);
@@ -126,6 +132,7 @@ void LeadCastle::ConstructLeadShield(G4ThreeVector local_coordinates) {
 
   LeadCeiling_Solid = new G4Box("LeadCeiling_Solid", 180 * cm, 10 * cm, 120 * cm);
   LeadCeiling_Logical = new G4LogicalVolume(LeadCeiling_Solid, Pb, "LeadCeiling_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", LeadCeiling_Logical);
   LeadCeiling_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(0., +35. * cm, 0.), LeadCeiling_Logical, "LeadCeiling", World_Logical, 0, 0);
@@ -137,6 +144,7 @@ void LeadCastle::ConstructLeadShield(G4ThreeVector local_coordinates) {
 
   LeadFloor_Solid = new G4Box("LeadFloor_Solid", 180 * cm, 10 * cm, 120 * cm);
   LeadFloor_Logical = new G4LogicalVolume(LeadFloor_Solid, Pb, "LeadFloor_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", LeadFloor_Logical);
   LeadFloor_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(0., -35. * cm, 0.), LeadFloor_Logical, "LeadFloor", World_Logical, 0, 0);
@@ -148,6 +156,7 @@ void LeadCastle::ConstructLeadShield(G4ThreeVector local_coordinates) {
 
   LeadBackWall_Solid = new G4Box("LeadBackWall_Solid", 160 * cm, 25 * cm, 10 * cm);
   LeadBackWall_Logical = new G4LogicalVolume(LeadBackWall_Solid, Pb, "LeadBackWall_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", LeadBackWall_Logical);
   LeadBackWall_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(0., 0., 110. * cm), LeadBackWall_Logical, "LeadBackWall", World_Logical, 0, 0);
@@ -159,6 +168,7 @@ void LeadCastle::ConstructLeadShield(G4ThreeVector local_coordinates) {
 
   LeadRightWall_Solid = new G4Box("LeadRightWall_Solid", 10 * cm, 25 * cm, 120 * cm);
   LeadRightWall_Logical = new G4LogicalVolume(LeadRightWall_Solid, Pb, "LeadRightWall_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", LeadRightWall_Logical);
   LeadRightWall_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(-170 * cm, 0., 0), LeadRightWall_Logical, "LeadRightWall", World_Logical, 0, 0);
@@ -170,6 +180,7 @@ void LeadCastle::ConstructLeadShield(G4ThreeVector local_coordinates) {
 
   LeadLeftCollimator_Solid = new G4Box("LeadLeftCollimator_Solid", 10 * cm, 25 * cm, 28.5 * cm);
   LeadLeftCollimator_Logical = new G4LogicalVolume(LeadLeftCollimator_Solid, Pb, "LeadLeftCollimator_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", LeadLeftCollimator_Logical);
   LeadLeftCollimator_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(45. * cm, 0., -95 * cm + 28.5 * cm), LeadLeftCollimator_Logical, "LeadLeftCollimator", World_Logical, 0, 0);
@@ -181,6 +192,7 @@ void LeadCastle::ConstructLeadShield(G4ThreeVector local_coordinates) {
 
   LeadRightCollimator_Solid = new G4Box("LeadRightCollimator_Solid", 10 * cm, 25 * cm, 28.5 * cm);
   LeadRightCollimator_Logical = new G4LogicalVolume(LeadRightCollimator_Solid, Pb, "block31_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", LeadRightCollimator_Logical);
   LeadRightCollimator_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(-45 * cm, 0., -66.5 * cm), LeadRightCollimator_Logical, "LeadRightCollimator", World_Logical, 0, 0);
@@ -192,6 +204,7 @@ void LeadCastle::ConstructLeadShield(G4ThreeVector local_coordinates) {
 
   LeadCastleGate_Solid = new G4Box("LeadCastleGate_Solid", 52.5 * cm, 25 * cm, 15 * cm);
   LeadCastleGate_Logical = new G4LogicalVolume(LeadCastleGate_Solid, Pb, "block73_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", LeadCastleGate_Logical);
   LeadCastleGate_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(107.5 * cm, 0, -53 * cm), LeadCastleGate_Logical, "LeadCastleGate", World_Logical, 0, 0);
@@ -203,6 +216,7 @@ void LeadCastle::ConstructLeadShield(G4ThreeVector local_coordinates) {
 
   LeadCastle_LeftWall_Solid = new G4Box("LeadCastle_LeftWall_Solid", 10 * cm, 25 * cm, 93.5 * cm);
   LeadCastle_LeftWall_Logical = new G4LogicalVolume(LeadCastle_LeftWall_Solid, Pb, "LeadCastle_LeftWall_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", LeadCastle_LeftWall_Logical);
   LeadCastle_LeftWall_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(170. * cm, 0., 26.5 * cm), LeadCastle_LeftWall_Logical, "LeadCastle_LeftWall", World_Logical, 0, 0);
@@ -213,6 +227,7 @@ void LeadCastle::ConstructLeadShield(G4ThreeVector local_coordinates) {
 
   G4Box *LeadDownstream_Pol_Solid = new G4Box("LeadDownstream_Pol_Solid", 14. * cm, 25 * cm, LeadDownstream_Pol_Z);
   G4LogicalVolume *LeadDownstream_Pol_Logical = new G4LogicalVolume(LeadDownstream_Pol_Solid, Pb, "LeadDownstream_Pol_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", LeadDownstream_Pol_Logical);
   LeadDownstream_Pol_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(26.5 * cm, 0, 120 * cm - 20 * cm - LeadDownstream_Pol_Z), LeadDownstream_Pol_Logical, "LeadDownstream_Pol", World_Logical, 0, 0);
@@ -224,12 +239,14 @@ void LeadCastle::ConstructLeadShield(G4ThreeVector local_coordinates) {
 
   G4Box *UpstreamDet1_Solid = new G4Box("UpstreamDet1_Solid", UpstreamDet1_X, 25 * cm, UpstreamDet1_Z);
   G4LogicalVolume *UpstreamDet1_Logical = new G4LogicalVolume(UpstreamDet1_Solid, Pb, "UpstreamDet1_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", UpstreamDet1_Logical);
   UpstreamDet1_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(-0.5 * block_small_x - UpstreamDet1_X, 0, -UpstreamDet1_Z + 10 * cm * sin(g1_phi) * 0.5), UpstreamDet1_Logical, "LeadUpstreamDet1", World_Logical, 0, 0);
 
   G4Box *DownstreamDet1_Solid = new G4Box("DownstreamDet1_Solid", UpstreamDet1_X, 25 * cm, block_z * 0.5 * 4 + 1.131 * cm - 2 * cm);
   G4LogicalVolume *DownstreamDet1_Logical = new G4LogicalVolume(DownstreamDet1_Solid, Pb, "DownstreamDet1_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", DownstreamDet1_Logical);
   DownstreamDet1_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(-0.5 * block_small_x - UpstreamDet1_X, 0, UpstreamDet1_Z + 10 * cm * sin(g1_phi) + 15.8 * cm * 2), DownstreamDet1_Logical, "LeadDownstreamDet1", World_Logical, 0, 0);
@@ -271,6 +288,7 @@ void LeadCastle::ConstructLeadCollimator(G4ThreeVector local_coordinates, BGO *B
   G4SubtractionSolid *LeadCollimator_Pol_Det2_Solid = new G4SubtractionSolid("LeadCollimator_Pol_Det2_Solid", Det2_Pol_BGO_Solid, BGO2_Case, &RotationDet2_Y, TranslationDet2);
 
   G4LogicalVolume *LeadCollimator_Pol_Det2_Logical = new G4LogicalVolume(LeadCollimator_Pol_Det2_Solid, Pb, "LeadCollimator_Pol_Det2_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", LeadCollimator_Pol_Det2_Logical);
   LeadCollimator_Pol_Det2_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + G4ThreeVector(261 * mm, 0, 0), LeadCollimator_Pol_Det2_Logical, "LeadCollimator_Pol_Det2", World_Logical, 0, 0);
@@ -286,6 +304,7 @@ void LeadCastle::ConstructLeadCollimator(G4ThreeVector local_coordinates, BGO *B
   G4SubtractionSolid *Det1_Box_Filter_Solid = new G4SubtractionSolid("Det1_Box_Filter_Solid", LeadCollimator_Det1_Solid, FilterHole_Solid, &RotationDet1_Y, G4ThreeVector());
   G4SubtractionSolid *Det1_Complete_Solid = new G4SubtractionSolid("Det1_Complete_Solid", Det1_Box_Filter_Solid, BGO1->Get_CaseFilled_Solid(), &RotationDet1_Y, G4ThreeVector());
   G4LogicalVolume *Det1_Complete_Logical = new G4LogicalVolume(Det1_Complete_Solid, Pb, "Det1_Complete_Logical", 0, 0, 0);
+  utrRegionTools::addLogicalVolume("shielding", Det1_Complete_Logical);
   Det1_Complete_Logical->SetVisAttributes(grey);
 
   new G4PVPlacement(0, local_coordinates + TranslationDet1, Det1_Complete_Logical, "LeadCollimator_Det1", World_Logical, 0, 0);
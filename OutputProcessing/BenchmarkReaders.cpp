@@ -0,0 +1,231 @@
+// BenchmarkReaders compares the speed of the ways to read utr output trees in the output processing codes:
+// Reading entry by entry with all branches active (like the codes did before BulkReader), entry by entry with only
+// the required branches active, and in blocks with BulkReader.
+
+#include <argp.h>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+
+#include <TFile.h>
+#include <TRandom3.h>
+#include <TTree.h>
+
+#include "BulkReader.hh"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+static char doc[] = "BenchmarkReaders";
+static char args_doc[] = "Measure the number of entries per second that can be read from a utr output file";
+
+struct arguments {
+  const char *filename;
+  long nentries;
+  bool float_columns;
+  bool keep;
+
+  arguments() : filename("benchmarkReaders.root"), nentries(10000000), float_columns(false), keep(false){};
+};
+
+static struct argp_option options[] = {
+    {0, 'o', "FILENAME", 0, "Name of the test file (default: 'benchmarkReaders.root')"},
+    {0, 'n', "NENTRIES", 0, "Number of entries in the test file (default: 10000000)"},
+    {0, 'f', 0, 0, "Write int and float columns like EVENT_INT_COLUMNS and EVENT_FLOAT_COLUMNS (default: double columns)"},
+    {0, 'k', 0, 0, "Keep the test file (default: delete it)"},
+    {0, 0, 0, 0, 0}};
+
+static error_t parse_opt(int key, char *arg, struct argp_state *state) {
+
+  struct arguments *args = (struct arguments *)state->input;
+
+  switch (key) {
+    case ARGP_KEY_ARG:
+      break;
+    case 'o':
+      args->filename = arg;
+      break;
+    case 'n':
+      args->nentries = atol(arg);
+      break;
+    case 'f':
+      args->float_columns = true;
+      break;
+    case 'k':
+      args->keep = true;
+      break;
+    case ARGP_KEY_END:
+      break;
+    default:
+      return ARGP_ERR_UNKNOWN;
+  }
+
+  return 0;
+}
+
+static struct argp argp = {options, parse_opt, args_doc, doc, 0, 0, 0};
+
+const unsigned int maxid = 12;
+
+// Writes a tree with the columns of a typical utr output file, of which only 'event', 'edep' and 'volume' are read
+void writeFile(const arguments &args) {
+  TFile file(args.filename, "RECREATE");
+  TTree tree("utr", "utr");
+
+  double event_d, edep_d, volume_d, particle_d, ekin_d, posx_d, posy_d, posz_d;
+  int event_i, volume_i, particle_i;
+  float edep_f, ekin_f, posx_f, posy_f, posz_f;
+  if (args.float_columns) {
+    tree.Branch("event", &event_i, "event/I");
+    tree.Branch("edep", &edep_f, "edep/F");
+    tree.Branch("volume", &volume_i, "volume/I");
+    tree.Branch("particle", &particle_i, "particle/I");
+    tree.Branch("ekin", &ekin_f, "ekin/F");
+    tree.Branch("posx", &posx_f, "posx/F");
+    tree.Branch("posy", &posy_f, "posy/F");
+    tree.Branch("posz", &posz_f, "posz/F");
+  } else {
+    tree.Branch("event", &event_d, "event/D");
+    tree.Branch("edep", &edep_d, "edep/D");
+    tree.Branch("volume", &volume_d, "volume/D");
+    tree.Branch("particle", &particle_d, "particle/D");
+    tree.Branch("ekin", &ekin_d, "ekin/D");
+    tree.Branch("posx", &posx_d, "posx/D");
+    tree.Branch("posy", &posy_d, "posy/D");
+    tree.Branch("posz", &posz_d, "posz/D");
+  }
+
+  TRandom3 random(0);
+  event_d = 0.;
+  for (long i = 0; i < args.nentries; ++i) {
+    if (random.Rndm() < 0.5) {
+      event_d += 1.;
+    }
+    edep_d = random.Uniform(0., 10.);
+    volume_d = (double)random.Integer(maxid + 1);
+    particle_d = 22.;
+    ekin_d = random.Uniform(0., 10.);
+    posx_d = random.Gaus(0., 10.);
+    posy_d = random.Gaus(0., 10.);
+    posz_d = random.Gaus(0., 10.);
+
+    event_i = (int)event_d;
+    volume_i = (int)volume_d;
+    particle_i = (int)particle_d;
+    edep_f = (float)edep_d;
+    ekin_f = (float)ekin_d;
+    posx_f = (float)posx_d;
+    posy_f = (float)posy_d;
+    posz_f = (float)posz_d;
+    tree.Fill();
+  }
+  tree.Write();
+  file.Close();
+}
+
+// Runs 'read' on a freshly opened tree, prints the speed and returns the checksum computed by 'read'
+template <typename F> double measure(const arguments &args, const string &name, F read) {
+  TFile file(args.filename);
+  TTree *tree = (TTree *)file.Get("utr");
+
+  const auto start = std::chrono::steady_clock::now();
+  const double checksum = read(*tree);
+  const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+  cout << name << ": " << seconds.count() << " s, " << (double)tree->GetEntries() / seconds.count() << " entries/s (checksum " << checksum << ")" << endl;
+  return checksum;
+}
+
+// All readers sum up the energy depositions of all entries in valid volumes and count the events
+int main(int argc, char *argv[]) {
+  struct arguments args;
+  argp_parse(&argp, argc, argv, 0, 0, &args);
+
+  cout << "Writing " << args.nentries << " entries to " << args.filename << " ..." << endl;
+  writeFile(args);
+
+  const double checksum_all = measure(args, "GetEntry, all branches", [](TTree &tree) {
+    BranchReader edep, volume, event;
+    edep.Connect(tree, "edep");
+    volume.Connect(tree, "volume");
+    event.Connect(tree, "event");
+    double sum = 0., lastEvent = -1.;
+    for (long i = 0; i < tree.GetEntries(); ++i) {
+      tree.GetEntry(i);
+      if ((unsigned int)volume.Get() <= maxid) {
+        sum += edep.Get();
+      }
+      if (event.Get() != lastEvent) {
+        sum += 1.;
+        lastEvent = event.Get();
+      }
+    }
+    return sum;
+  });
+
+  const double checksum_pruned = measure(args, "GetEntry, pruned branches", [](TTree &tree) {
+    tree.SetBranchStatus("*", false);
+    tree.SetBranchStatus("edep", true);
+    tree.SetBranchStatus("volume", true);
+    tree.SetBranchStatus("event", true);
+    BranchReader edep, volume, event;
+    edep.Connect(tree, "edep");
+    volume.Connect(tree, "volume");
+    event.Connect(tree, "event");
+    double sum = 0., lastEvent = -1.;
+    for (long i = 0; i < tree.GetEntries(); ++i) {
+      tree.GetEntry(i);
+      if ((unsigned int)volume.Get() <= maxid) {
+        sum += edep.Get();
+      }
+      if (event.Get() != lastEvent) {
+        sum += 1.;
+        lastEvent = event.Get();
+      }
+    }
+    return sum;
+  });
+
+  bool bulk = false;
+  const double checksum_bulk = measure(args, "BulkReader", [&bulk](TTree &tree) {
+    BulkReader reader;
+    reader.Connect(tree, {"edep", "volume", "event"});
+    double sum = 0., lastEvent = -1.;
+    const long nentries = tree.GetEntries();
+    for (long blockStart = 0; blockStart < nentries;) {
+      const long blockSize = reader.Read(blockStart);
+      if (blockSize <= 0) {
+        break;
+      }
+      const double *edeps = reader.Column(0);
+      const double *volumes = reader.Column(1);
+      const double *events = reader.Column(2);
+      for (long i = 0; i < blockSize; ++i) {
+        if ((unsigned int)volumes[i] <= maxid) {
+          sum += edeps[i];
+        }
+        if (events[i] != lastEvent) {
+          sum += 1.;
+          lastEvent = events[i];
+        }
+      }
+      blockStart += blockSize;
+    }
+    bulk = reader.IsBulk();
+    return sum;
+  });
+  cout << "BulkReader used ROOT's bulk I/O interface: " << (bulk ? "yes" : "no (fallback)") << endl;
+
+  if (!args.keep) {
+    remove(args.filename);
+  }
+
+  if (checksum_all != checksum_pruned || checksum_all != checksum_bulk) {
+    cout << "Error! The readers returned different checksums." << endl;
+    return 1;
+  }
+  return 0;
+}
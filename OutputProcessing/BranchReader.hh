@@ -0,0 +1,83 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+// BranchReader reads a branch of a utr output tree as a double, regardless of whether it was
+// written as a double column (default), a float column (EVENT_FLOAT_COLUMNS) or an int column
+// (EVENT_INT_COLUMNS). This way, the output processing codes understand all output schemas.
+
+#include <string>
+
+#include <TLeaf.h>
+#include <TTree.h>
+
+class BranchReader {
+  public:
+  // Sets the branch address of the branch 'name' in 'tree' (which may also be a TChain).
+  // Returns false if the branch does not exist or has an unsupported type.
+  bool Connect(TTree &tree, const std::string &name) {
+    TLeaf *leaf = tree.GetLeaf(name.c_str());
+    if (leaf == nullptr) {
+      return false;
+    }
+    const std::string typeName = leaf->GetTypeName();
+    if (typeName == "Double_t") {
+      type = DOUBLE;
+      tree.SetBranchAddress(name.c_str(), &value.d);
+    } else if (typeName == "Float_t") {
+      type = FLOAT;
+      tree.SetBranchAddress(name.c_str(), &value.f);
+    } else if (typeName == "Int_t") {
+      type = INT;
+      tree.SetBranchAddress(name.c_str(), &value.i);
+    } else if (typeName == "Short_t") {
+      type = SHORT;
+      tree.SetBranchAddress(name.c_str(), &value.s);
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  // Value of the branch in the entry that was last read with tree.GetEntry()
+  double Get() const {
+    switch (type) {
+      case FLOAT:
+        return static_cast<double>(value.f);
+      case INT:
+        return static_cast<double>(value.i);
+      case SHORT:
+        return static_cast<double>(value.s);
+      case DOUBLE:
+      default:
+        return value.d;
+    }
+  }
+
+  private:
+  enum branch_type { DOUBLE, FLOAT, INT, SHORT };
+  branch_type type = DOUBLE;
+  union {
+    Double_t d;
+    Float_t f;
+    Int_t i;
+    Short_t s;
+  } value = {0.};
+};
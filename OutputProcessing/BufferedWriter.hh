@@ -0,0 +1,93 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+// BufferedWriter formats numbers with std::to_chars into a large buffer and writes it to a file in big chunks,
+// instead of formatting every value with an std::ostream and flushing the stream for every line.
+// The text is the same as the one of an std::ostream with the corresponding format flags.
+
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class BufferedWriter {
+  public:
+  BufferedWriter(const std::string &filename, const size_t chunkSize = 1 << 22) : file(fopen(filename.c_str(), "wb")), chunk(chunkSize) { buffer.reserve(chunkSize + maxValueLength); }
+  ~BufferedWriter() { Close(); }
+  BufferedWriter(const BufferedWriter &) = delete;
+  BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+  bool IsOpen() const { return file != nullptr; }
+
+  // Same as 'stream << std::scientific << std::setprecision(precision) << value'
+  void Scientific(const double value, const int precision) { Append(value, std::chars_format::scientific, precision); }
+
+  // Same as 'stream << std::setprecision(precision) << value' with the default floating point format
+  void General(const double value, const int precision = 6) { Append(value, std::chars_format::general, precision); }
+
+  void Char(const char c) {
+    buffer.push_back(c);
+    if (buffer.size() >= chunk) {
+      Flush();
+    }
+  }
+
+  // Appends raw bytes, for example for binary output
+  void Bytes(const char *data, const size_t size) {
+    buffer.insert(buffer.end(), data, data + size);
+    if (buffer.size() >= chunk) {
+      Flush();
+    }
+  }
+
+  void Flush() {
+    if (file != nullptr && !buffer.empty()) {
+      fwrite(buffer.data(), 1, buffer.size(), file);
+    }
+    buffer.clear();
+  }
+
+  void Close() {
+    Flush();
+    if (file != nullptr) {
+      fclose(file);
+      file = nullptr;
+    }
+  }
+
+  private:
+  // Longest possible output of std::to_chars for a double with a precision below 30
+  static constexpr size_t maxValueLength = 64;
+
+  void Append(const double value, const std::chars_format format, const int precision) {
+    const size_t size = buffer.size();
+    buffer.resize(size + maxValueLength);
+    const std::to_chars_result result = std::to_chars(buffer.data() + size, buffer.data() + buffer.size(), value, format, precision);
+    buffer.resize((size_t)(result.ptr - buffer.data()));
+    if (buffer.size() >= chunk) {
+      Flush();
+    }
+  }
+
+  FILE *file;
+  size_t chunk;
+  std::vector<char> buffer;
+};
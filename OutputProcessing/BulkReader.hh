@@ -0,0 +1,201 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+// BulkReader reads blocks of consecutive entries of a few branches of a utr output tree (or a TChain of them) into
+// contiguous arrays of doubles, so that the output processing codes can loop over thousands of values at once instead
+// of calling TTree::GetEntry() for every entry. All other branches of the tree are deactivated and never decompressed.
+//
+// If ROOT's bulk I/O interface supports a branch (a single leaf of a basic type, like all utr output columns), the
+// baskets are deserialized as a whole and converted in a tight loop. Otherwise, BulkReader falls back to reading the
+// block entry by entry with a BranchReader. Both ways give the same values.
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <RConfig.hpp>
+#include <TBranch.h>
+#include <TBufferFile.h>
+#include <TLeaf.h>
+#include <TTree.h>
+
+#include "BranchReader.hh"
+
+class BulkReader {
+  public:
+  // Maximum number of entries in a block which is read entry by entry
+  static constexpr long fallbackBlockSize = 4096;
+
+  // Deactivates all branches of 'tree' except for 'names', which are the columns of the blocks in this order.
+  // Returns false if a branch does not exist or has an unsupported type.
+  bool Connect(TTree &tree, const std::vector<std::string> &names) {
+    inputTree = &tree;
+    columns.clear();
+    columns.resize(names.size());
+    tree.SetBranchStatus("*", false);
+    for (size_t i = 0; i < names.size(); ++i) {
+      TLeaf *leaf = tree.GetLeaf(names[i].c_str());
+      if (leaf == nullptr) {
+        return false;
+      }
+      tree.SetBranchStatus(names[i].c_str(), true);
+      if (!columns[i].fallbackReader.Connect(tree, names[i])) {
+        return false;
+      }
+      columns[i].name = names[i];
+      columns[i].serialized.reset(new TBufferFile(TBuffer::kWrite, 32 * 1024));
+      columns[i].typeName = leaf->GetTypeName();
+    }
+    return true;
+  }
+
+  // Reads the block of entries that starts at 'entry'. Returns the number of entries in the block, which is 0 if
+  // 'entry' is beyond the end of the tree. The values are accessible via Column() until the next call.
+  // A block never extends beyond the end of a file in a TChain.
+  long Read(const long entry) {
+    const Long64_t localEntry = inputTree->LoadTree(entry);
+    if (localEntry < 0) {
+      return 0;
+    }
+    TTree *currentTree = inputTree->GetTree();
+    const long treeOffset = entry - (long)localEntry;
+    long end = treeOffset + (long)currentTree->GetEntries();
+
+    if (useBulk) {
+      for (auto &column : columns) {
+        if (!ReadBasket(column, currentTree, inputTree->GetTreeNumber(), localEntry)) {
+          useBulk = false;
+          break;
+        }
+        end = std::min(end, treeOffset + (long)(column.basketFirst + column.basketSize));
+      }
+    }
+    if (useBulk) {
+      for (auto &column : columns) {
+        column.data = column.basket.data() + (localEntry - column.basketFirst);
+      }
+      return end - entry;
+    }
+
+    // Fall back to reading entry by entry
+    end = std::min(end, entry + fallbackBlockSize);
+    for (auto &column : columns) {
+      column.basket.resize((size_t)(end - entry));
+      column.basketTreeNumber = -1;
+    }
+    for (long i = entry; i < end; ++i) {
+      inputTree->GetEntry(i);
+      for (auto &column : columns) {
+        column.basket[(size_t)(i - entry)] = column.fallbackReader.Get();
+      }
+    }
+    for (auto &column : columns) {
+      column.data = column.basket.data();
+    }
+    return end - entry;
+  }
+
+  // Values of the column with the given index (see Connect()) in the last block
+  const double *Column(const size_t index) const { return columns[index].data; }
+
+  // Whether the baskets are read with ROOT's bulk I/O interface so far
+  bool IsBulk() const { return useBulk; }
+
+  private:
+  struct ColumnBuffer {
+    std::string name;
+    std::string typeName;
+    BranchReader fallbackReader;
+    std::unique_ptr<TBufferFile> serialized; // TBufferFile can not be copied or moved
+    std::vector<double> basket; // Converted values of the last basket
+    // Number of the file in a TChain (0 for a TTree) the last basket belongs to. The TTree pointer can not be used, because
+    // a TChain deletes the tree of a file when it loads the next one, whose tree may get the same address.
+    Int_t basketTreeNumber = -1;
+    Long64_t basketFirst = 0; // Local entry number of the first value in the basket
+    Long64_t basketSize = 0;
+    const double *data = nullptr;
+  };
+
+  // Reads and converts the basket of 'column' that contains the local entry 'localEntry' of 'tree', the file with the
+  // number 'treeNumber', unless it is already in the buffer. Returns false if the bulk I/O interface does not support the
+  // branch.
+  bool ReadBasket(ColumnBuffer &column, TTree *tree, const Int_t treeNumber, const Long64_t localEntry) {
+    if (column.basketTreeNumber == treeNumber && localEntry >= column.basketFirst && localEntry < column.basketFirst + column.basketSize) {
+      return true;
+    }
+    TBranch *branch = tree->GetBranch(column.name.c_str());
+    if (branch == nullptr) {
+      return false;
+    }
+    const Int_t size = branch->GetBulkRead().GetEntriesSerialized(localEntry, *column.serialized);
+    if (size <= 0) {
+      return false;
+    }
+    // The bulk interface always returns a complete basket
+    const Long64_t first = branch->GetBasketEntry()[branch->GetReadBasket()];
+    if (localEntry < first || localEntry >= first + size) {
+      return false;
+    }
+
+    column.basket.resize((size_t)size);
+    const char *serialized = column.serialized->GetCurrent();
+    if (column.typeName == "Double_t") {
+      Convert<Double_t, ULong64_t>(serialized, size, column.basket.data());
+    } else if (column.typeName == "Float_t") {
+      Convert<Float_t, UInt_t>(serialized, size, column.basket.data());
+    } else if (column.typeName == "Int_t") {
+      Convert<Int_t, UInt_t>(serialized, size, column.basket.data());
+    } else if (column.typeName == "Short_t") {
+      Convert<Short_t, UShort_t>(serialized, size, column.basket.data());
+    } else {
+      return false;
+    }
+    column.basketTreeNumber = treeNumber;
+    column.basketFirst = first;
+    column.basketSize = size;
+    return true;
+  }
+
+  // Converts n serialized (big endian) values of type T to doubles. The loop has no branches, so it can be vectorized.
+  template <typename T, typename U> static void Convert(const char *serialized, const Int_t n, double *values) {
+    static_assert(sizeof(T) == sizeof(U), "Size of value and raw type must be the same");
+    for (Int_t i = 0; i < n; ++i) {
+      U raw;
+      std::memcpy(&raw, serialized + (size_t)i * sizeof(U), sizeof(U));
+#ifdef R__BYTESWAP
+      raw = ByteSwap(raw);
+#endif
+      T value;
+      std::memcpy(&value, &raw, sizeof(T));
+      values[i] = static_cast<double>(value);
+    }
+  }
+
+  static UShort_t ByteSwap(const UShort_t raw) { return __builtin_bswap16(raw); }
+  static UInt_t ByteSwap(const UInt_t raw) { return __builtin_bswap32(raw); }
+  static ULong64_t ByteSwap(const ULong64_t raw) { return __builtin_bswap64(raw); }
+
+  TTree *inputTree = nullptr;
+  std::vector<ColumnBuffer> columns;
+  bool useBulk = true;
+};
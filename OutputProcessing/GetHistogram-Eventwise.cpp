@@ -19,8 +19,10 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <argp.h>
+#include <cerrno>
 #include <dirent.h>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <stdlib.h>
 #include <string>
@@ -85,6 +87,19 @@ struct arguments {
 };
 
 // Function to parse a single option
+// Parses the argument of --threads. Only non-negative integers are accepted, since atoi would turn a
+// negative or non-numeric argument into a huge number of threads or into 0 (the number of cpu cores).
+static bool parseThreads(const char *arg, unsigned int &threads) {
+  char *end;
+  errno = 0;
+  const long value = strtol(arg, &end, 10);
+  if (end == arg || *end != '\0' || errno != 0 || value < 0 || value > std::numeric_limits<int>::max()) {
+    return false;
+  }
+  threads = (unsigned int)value;
+  return true;
+}
+
 static error_t parse_opt(int key, char *arg, struct argp_state *state) {
   // Get the input argument from argp_parse, which is a pointer to the arguments structure
   struct arguments *arguments = (struct arguments *)state->input;
@@ -127,7 +142,9 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
       arguments->verbose = false;
       break;
     case 'T':
-      arguments->threads = (unsigned int)atoi(arg);
+      if (!parseThreads(arg, arguments->threads)) {
+        argp_error(state, "invalid number of threads '%s', expected a non-negative integer (0 for the number of cpu cores)", arg);
+      }
       break;
     case ARGP_KEY_ARG:
       cerr << "> Error: getHistogram-Eventwise takes only options and no arguments!" << endl;
@@ -143,6 +160,53 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
 
 static struct argp argp = {options, parse_opt, args_doc, doc};
 
+// Fills the histograms from the sparse eventwise layout of utr (build option EVENT_EVENTWISE_SPARSE), in which each entry
+// contains the IDs of the detectors that were hit ('detector') and their energy depositions ('edep') as vectors.
+// All histograms, i.e. det0 ... det<MAXID> followed by the addback histograms, are filled in a single pass over the data.
+// Each processing slot fills its own copies of the templates, which are merged at the end.
+// The type T of the energy depositions is double by default and float if utr was built with EVENT_FLOAT_COLUMNS.
+template <typename T>
+vector<TH1D> fillSparseHistograms(ROOT::RDataFrame &df, const vector<TH1D> &templates, const unsigned int nhistograms, const int addback) {
+  const unsigned int nslots = df.GetNSlots();
+  const size_t nclovers = templates.size() - nhistograms;
+  vector<vector<TH1D>> slotHist(nslots, templates);
+  vector<vector<double>> slotAddbackBuffer(nslots, vector<double>(nclovers, 0.));
+
+  df.ForeachSlot(
+      [&](unsigned int slot, const ROOT::RVec<int> &detectors, const ROOT::RVec<T> &edeps) {
+        vector<TH1D> &hist = slotHist[slot];
+        vector<double> &addbackBuffer = slotAddbackBuffer[slot];
+        for (size_t i = 0; i < detectors.size(); ++i) {
+          if (detectors[i] < 0 || static_cast<unsigned int>(detectors[i]) >= nhistograms) {
+            continue;
+          }
+          const double e = static_cast<double>(edeps[i]);
+          hist[static_cast<size_t>(detectors[i])].Fill(e);
+          if (nclovers > 0 && detectors[i] >= addback) {
+            const size_t clover = static_cast<size_t>((detectors[i] - addback) / 4);
+            if (clover < nclovers) {
+              addbackBuffer[clover] += e;
+            }
+          }
+        }
+        for (size_t clover = 0; clover < nclovers; ++clover) {
+          if (addbackBuffer[clover] > 0.) {
+            hist[nhistograms + clover].Fill(addbackBuffer[clover]);
+            addbackBuffer[clover] = 0.;
+          }
+        }
+      },
+      {"detector", "edep"});
+
+  vector<TH1D> hist = slotHist[0];
+  for (unsigned int slot = 1; slot < nslots; ++slot) {
+    for (size_t i = 0; i < hist.size(); ++i) {
+      hist[i].Add(&slotHist[slot][i]);
+    }
+  }
+  return hist;
+}
+
 int main(int argc, char *argv[]) {
 
   struct arguments arguments;
@@ -237,51 +301,98 @@ int main(int argc, char *argv[]) {
 
   auto df = ROOT::RDataFrame(fileChain);
 
-  vector<ROOT::RDF::RResultPtr<TH1D>> histPtr(arguments.nhistograms);
-  stringstream histname, histtitle;
-
-  for (unsigned int i = 0; i < arguments.nhistograms; ++i) {
-    histname << "det" << i;
-    histtitle << "Energy deposition in Detector " << i;
-    // Choice of proper data type in TH1 is VERY important here! A TH1F for example uses Floats as the datatype for the bin contents, limiting their precision to about 7 digits.
-    // With this precision at a bin content of 1.67772e+07 an incrementation by one gets lost in precision, leaving the value effectively unchanged.
-    // Hence the fill() method would fail unnoticed for (Float) bins as soon as they reach this content, effectively limiting the bin's content to this value (although the Float
-    // datatype could handle much higher values, just not with the needed precision on integer basis).
-    // Hence a TH1D is used: The Double datatype has a precision of about 14 digits (more digits than an Integer can store), and the incrementation by one gets lost at
-    // a bin content of about 9.0e+15, which should suffice for all (utr) cases (one could also implement throwing an exception if a bin passes some threshold after filling).
-
-    histPtr[i] = df
-                     .Filter([](double e) { return e > 0.; }, {"det" + std::to_string(i)})
-                     .Histo1D(TH1D(histname.str().c_str(), histtitle.str().c_str(), nbins, emin, eMax), "det" + std::to_string(i));
-    histname.str("");
-    histtitle.str("");
-  }
+  vector<TH1D> hist;
+
+  if (fileChain.GetBranch("detector") != nullptr) {
+    // Sparse layout: Book the same histograms as for the dense layout below, and fill them in a single pass
+    TH1::AddDirectory(false);
+    vector<TH1D> templates;
+    for (unsigned int i = 0; i < arguments.nhistograms; ++i) {
+      templates.push_back(TH1D(("det" + std::to_string(i)).c_str(), ("Energy deposition in Detector " + std::to_string(i)).c_str(), nbins, emin, eMax));
+    }
+    if (arguments.addback >= 0) {
+      int clover = 1;
+      for (unsigned int i = static_cast<unsigned int>(arguments.addback); i + 3 < arguments.nhistograms; i += 4) {
+        templates.push_back(TH1D(("addback" + std::to_string(clover)).c_str(), ("Addback energy deposition in clover detector " + std::to_string(clover)).c_str(), nbins, emin, eMax));
+        clover++;
+      }
+    }
+
+    vector<TH1D> sparseHist;
+    if (df.GetColumnType("edep").find("float") != string::npos) {
+      sparseHist = fillSparseHistograms<float>(df, templates, arguments.nhistograms, arguments.addback);
+    } else {
+      sparseHist = fillSparseHistograms<double>(df, templates, arguments.nhistograms, arguments.addback);
+    }
+
+    hist.resize(sparseHist.size() + 1); // +1 For sum histogram
+    hist[arguments.nhistograms] = TH1D("sum", "Sum spectrum of all detectors", nbins, emin, eMax);
+    for (unsigned int i = 0; i < arguments.nhistograms; ++i) {
+      hist[i] = sparseHist[i];
+      hist[arguments.nhistograms].Add(&(hist[i]));
+    }
+    for (unsigned int i = arguments.nhistograms + 1; i < hist.size(); ++i) {
+      hist[i] = sparseHist[i - 1];
+    }
+  } else {
+    // The det<N> columns are double columns by default and float columns if utr was built with EVENT_FLOAT_COLUMNS.
+    // Float columns are converted to double columns det<N>_d, so that the same histograms can be booked for both.
+    ROOT::RDF::RNode node = df;
+    vector<string> columns(arguments.nhistograms);
+    for (unsigned int i = 0; i < arguments.nhistograms; ++i) {
+      columns[i] = "det" + std::to_string(i);
+      if (df.GetColumnType(columns[i]) == "Float_t") {
+        node = node.Define(columns[i] + "_d", [](float e) { return static_cast<double>(e); }, {columns[i]});
+        columns[i] += "_d";
+      }
+    }
 
-  if (arguments.addback >= 0) {
-    int clover = 1;
-    for (unsigned int i = static_cast<unsigned int>(arguments.addback); i + 3 < arguments.nhistograms; i += 4) {
-      histname << "addback" << clover;
-      histtitle << "Addback energy deposition in clover detector " << clover;
-      histPtr.push_back(
-          df.Define("ADDBACK" + std::to_string(clover),
-                    [](double e1, double e2, double e3, double e4) { return e1 + e2 + e3 + e4; },
-                    {"det" + std::to_string(i), "det" + std::to_string(i + 1), "det" + std::to_string(i + 2), "det" + std::to_string(i + 3)})
-              .Filter([](double e) { return e > 0.; }, {"ADDBACK" + std::to_string(clover)})
-              .Histo1D(TH1D(histname.str().c_str(), histtitle.str().c_str(), nbins, emin, eMax), "ADDBACK" + std::to_string(clover)));
+    vector<ROOT::RDF::RResultPtr<TH1D>> histPtr(arguments.nhistograms);
+    stringstream histname, histtitle;
+
+    for (unsigned int i = 0; i < arguments.nhistograms; ++i) {
+      histname << "det" << i;
+      histtitle << "Energy deposition in Detector " << i;
+      // Choice of proper data type in TH1 is VERY important here! A TH1F for example uses Floats as the datatype for the bin contents, limiting their precision to about 7 digits.
+      // With this precision at a bin content of 1.67772e+07 an incrementation by one gets lost in precision, leaving the value effectively unchanged.
+      // Hence the fill() method would fail unnoticed for (Float) bins as soon as they reach this content, effectively limiting the bin's content to this value (although the Float
+      // datatype could handle much higher values, just not with the needed precision on integer basis).
+      // Hence a TH1D is used: The Double datatype has a precision of about 14 digits (more digits than an Integer can store), and the incrementation by one gets lost at
+      // a bin content of about 9.0e+15, which should suffice for all (utr) cases (one could also implement throwing an exception if a bin passes some threshold after filling).
+
+      histPtr[i] = node
+                       .Filter([](double e) { return e > 0.; }, {columns[i]})
+                       .Histo1D(TH1D(histname.str().c_str(), histtitle.str().c_str(), nbins, emin, eMax), columns[i]);
       histname.str("");
       histtitle.str("");
-      clover++;
     }
-  }
 
-  vector<TH1D> hist(histPtr.size() + 1); // +1 For sum histogram
-  hist[arguments.nhistograms] = TH1D("sum", "Sum spectrum of all detectors", nbins, emin, eMax);
-  for (unsigned int i = 0; i < arguments.nhistograms; ++i) {
-    hist[i] = histPtr[i].GetValue();
-    hist[arguments.nhistograms].Add(&(hist[i]));
-  }
-  for (unsigned int i = arguments.nhistograms + 1; i < hist.size(); ++i) {
-    hist[i] = histPtr[i - 1].GetValue();
+    if (arguments.addback >= 0) {
+      int clover = 1;
+      for (unsigned int i = static_cast<unsigned int>(arguments.addback); i + 3 < arguments.nhistograms; i += 4) {
+        histname << "addback" << clover;
+        histtitle << "Addback energy deposition in clover detector " << clover;
+        histPtr.push_back(
+            node.Define("ADDBACK" + std::to_string(clover),
+                        [](double e1, double e2, double e3, double e4) { return e1 + e2 + e3 + e4; },
+                        {columns[i], columns[i + 1], columns[i + 2], columns[i + 3]})
+                .Filter([](double e) { return e > 0.; }, {"ADDBACK" + std::to_string(clover)})
+                .Histo1D(TH1D(histname.str().c_str(), histtitle.str().c_str(), nbins, emin, eMax), "ADDBACK" + std::to_string(clover)));
+        histname.str("");
+        histtitle.str("");
+        clover++;
+      }
+    }
+
+    hist.resize(histPtr.size() + 1); // +1 For sum histogram
+    hist[arguments.nhistograms] = TH1D("sum", "Sum spectrum of all detectors", nbins, emin, eMax);
+    for (unsigned int i = 0; i < arguments.nhistograms; ++i) {
+      hist[i] = histPtr[i].GetValue();
+      hist[arguments.nhistograms].Add(&(hist[i]));
+    }
+    for (unsigned int i = arguments.nhistograms + 1; i < hist.size(); ++i) {
+      hist[i] = histPtr[i - 1].GetValue();
+    }
   }
 
   if (arguments.verbose) {
@@ -18,20 +18,30 @@ You should have received a copy of the GNU General Public License
 along with utr.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <argp.h>
+#include <atomic>
+#include <cerrno>
 #include <dirent.h>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <stdlib.h>
 #include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 
 #include <TChain.h>
 #include <TFile.h>
 #include <TH1.h>
+#include <TNamed.h>
 #include <TROOT.h>
 #include <TSystemDirectory.h>
 
+#include "BulkReader.hh"
+
 using std::cerr;
 using std::cout;
 using std::endl;
@@ -60,7 +70,10 @@ static struct argp_option options[] = {
     {"maxid", 'n', "MAXID", 0, "Highest detection volume ID (default: 12). 'getHistogram' only processes energy depositions in detectors with integer volume ID numbers from 0 to MAXID (MAXID is included)."},
     {"multiplicity", 'm', "MULTIPLICITY", 0, "Particle multiplicity, sum energy depositions for each detector among MULTIPLICITY events (default: 1)"},
     {"addback", 'a', 0, 0, "Add back energy depositions that occurred in a single event to the detector first listed in the event (usually this is the first one hit) (default: Off)"},
+    {"weight", 'w', 0, 0, "Fill the histograms with the statistical weights from the branch 'weight', which utr writes with the WEIGHT quantity. With addback, the weight of the first energy deposition in the event is used. Requires MULTIPLICITY 1. (default: Off)"},
     {"silent", 's', 0, 0, "Silent mode (does not silence -B option) (default: Off"},
+    {"cachedir", 'c', "CACHEDIR", 0, "Directory in which the results for the single input files are cached, so that a re-run only processes new or changed files. (default: no cache)"},
+    {"threads", 'T', "THREADS", 0, "Number of threads that process the input in parallel, 0 for the number of cpu cores. The bin contents are identical to the ones of the sequential processing. (default: 1)"},
     {0, 0, 0, 0, 0}};
 
 // Used by main to communicate with parse_opt
@@ -79,10 +92,26 @@ struct arguments {
   unsigned int nhistograms = 12 + 1; // Default value for MAXID of 12 and +1 (histograms 0 to 12)
   unsigned int multiplicity = 1;
   bool addback = false;
+  bool weight = false;
   bool verbose = true;
+  unsigned int threads = 1;
+  string cacheDir = "";
 };
 
 // Function to parse a single option
+// Parses the argument of --threads. Only non-negative integers are accepted, since atoi would turn a
+// negative or non-numeric argument into a huge number of threads or into 0 (the number of cpu cores).
+static bool parseThreads(const char *arg, unsigned int &threads) {
+  char *end;
+  errno = 0;
+  const long value = strtol(arg, &end, 10);
+  if (end == arg || *end != '\0' || errno != 0 || value < 0 || value > std::numeric_limits<int>::max()) {
+    return false;
+  }
+  threads = (unsigned int)value;
+  return true;
+}
+
 static error_t parse_opt(int key, char *arg, struct argp_state *state) {
   // Get the input argument from argp_parse, which is a pointer to the arguments structure
   struct arguments *arguments = (struct arguments *)state->input;
@@ -124,9 +153,20 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
     case 'a':
       arguments->addback = true;
       break;
+    case 'w':
+      arguments->weight = true;
+      break;
     case 's':
       arguments->verbose = false;
       break;
+    case 'T':
+      if (!parseThreads(arg, arguments->threads)) {
+        argp_error(state, "invalid number of threads '%s', expected a non-negative integer (0 for the number of cpu cores)", arg);
+      }
+      break;
+    case 'c':
+      arguments->cacheDir = arg;
+      break;
     case ARGP_KEY_ARG:
       cerr << "> Error: getHistogram takes only options and no arguments!" << endl;
       argp_usage(state);
@@ -141,6 +181,459 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
 
 static struct argp argp = {options, parse_opt, args_doc, doc};
 
+// Parallel processing (option --threads)
+//
+// The sequential algorithm in main() groups consecutive entries with a valid volume ID into 'units': With --addback, a unit
+// consists of all consecutive entries of the same event, which are attributed to the volume of its first entry. Otherwise, each
+// entry is a unit. For each volume, the sum of the energy depositions of each block of MULTIPLICITY consecutive units is filled
+// into the histogram.
+//
+// In parallel mode, the chain is split into contiguous ranges of entries, which are processed by separate threads with their own
+// TChain. The first and the last unit of a range may continue in the neighbouring ranges, so their energy depositions are only
+// stored and the units are completed when the results of the ranges are combined in their original order.
+// Since the position of the remaining ('inner') units of a range in their blocks of MULTIPLICITY units is only known after all
+// previous ranges were combined, each thread processes the inner units for all MULTIPLICITY possible offsets ('phases') of the
+// block counter of a volume. For each phase, it keeps the energy depositions that complete the block which started in a previous
+// range, the histogram of all complete blocks and the buffered energy of the last, incomplete block.
+// All energy depositions are summed in the same order as in the sequential algorithm, so the bin contents and the numbers of
+// entries are identical to the sequential ones. The histograms of the ranges are combined with TH1::Add, which sums the
+// statistics for the mean and the standard deviation, and the weights of --weight, in a different order. These can differ
+// from the sequential ones in the last bits.
+
+struct Unit {
+  double event = -1.;
+  unsigned int volume = 0;
+  double weight = 1.; // Weight of the first entry, only read with --weight
+  vector<double> edeps; // Energy depositions of the entries in the order of the chain
+};
+
+struct Phase {
+  TH1D hist; // Complete blocks of inner units
+  vector<double> leadEdeps; // Energy depositions of the inner units that belong to a block which started in a previous range
+  bool leadOpen = false; // Whether the units are still added to the leading block
+  bool leadClosed = false; // Whether the leading block was completed in this range
+  unsigned int counter = 0;
+  double buffer = 0.;
+};
+
+struct RangeResult {
+  bool empty = true; // Whether the range contains any entry with a valid volume ID
+  Unit head, tail; // First and last unit of the range, the tail is only used if nUnits > 1
+  unsigned long nUnits = 0;
+  unsigned long nInvalidEntries = 0;
+  vector<unsigned long> nInnerUnits; // Number of inner units for each volume
+  vector<vector<Phase>> phases; // Index: [volume][phase]
+};
+
+static void processInnerUnit(RangeResult &result, const Unit &unit, const unsigned int multiplicity) {
+  result.nInnerUnits[unit.volume]++;
+  for (auto &phase : result.phases[unit.volume]) {
+    for (auto edep : unit.edeps) {
+      if (phase.leadOpen) {
+        phase.leadEdeps.push_back(edep);
+      }
+      phase.buffer += edep;
+    }
+    phase.counter++;
+    if (phase.counter == multiplicity) {
+      if (phase.leadOpen) {
+        phase.leadOpen = false;
+        phase.leadClosed = true;
+      } else {
+        phase.hist.Fill(phase.buffer, unit.weight);
+      }
+      phase.buffer = 0.;
+      phase.counter = 0;
+    }
+  }
+}
+
+// Branches which are read from the tree, in the order of the columns of the BulkReader
+static vector<string> requiredBranches(const arguments &args) {
+  vector<string> names{"edep", "volume"};
+  if (args.addback) {
+    names.push_back("event");
+  }
+  if (args.weight) {
+    names.push_back("weight");
+  }
+  return names;
+}
+
+// Column of the weight branch in the BulkReader
+static unsigned int weightColumn(const arguments &args) { return args.addback ? 3 : 2; }
+
+static void processRange(RangeResult &result, const vector<string> &filenames, const arguments &args, const TH1D &templateHist, const long firstEntry, const long lastEntry) {
+  TChain chain(args.tree.c_str());
+  for (auto &filename : filenames) {
+    chain.Add(filename.c_str());
+  }
+  BulkReader reader;
+  reader.Connect(chain, requiredBranches(args));
+
+  result.nInnerUnits.assign(args.nhistograms, 0);
+  result.phases.resize(args.nhistograms);
+  for (auto &volumePhases : result.phases) {
+    volumePhases.resize(args.multiplicity);
+    for (unsigned int r = 0; r < args.multiplicity; ++r) {
+      volumePhases[r].hist = templateHist;
+      volumePhases[r].leadOpen = (r != 0);
+      volumePhases[r].counter = r;
+    }
+  }
+
+  Unit current;
+  for (long blockStart = firstEntry; blockStart < lastEntry;) {
+    const long blockSize = std::min(reader.Read(blockStart), lastEntry - blockStart);
+    if (blockSize <= 0) {
+      break;
+    }
+    const double *edeps = reader.Column(0);
+    const double *volumes = reader.Column(1);
+    const double *events = args.addback ? reader.Column(2) : nullptr;
+    const double *weights = args.weight ? reader.Column(weightColumn(args)) : nullptr;
+
+    for (long i = 0; i < blockSize; ++i) {
+      const unsigned int volume = (unsigned int)volumes[i];
+      if (volume >= args.nhistograms) {
+        result.nInvalidEntries++;
+        continue;
+      }
+      const double event = args.addback ? events[i] : -1;
+      if (result.empty) {
+        result.empty = false;
+      } else if (!args.addback || current.event != event) {
+        // The current unit is complete
+        if (result.nUnits == 1) {
+          result.head = current;
+        } else {
+          processInnerUnit(result, current, args.multiplicity);
+        }
+      } else {
+        current.edeps.push_back(edeps[i]);
+        continue;
+      }
+      result.nUnits++;
+      current.event = event;
+      current.volume = volume;
+      current.weight = args.weight ? weights[i] : 1.;
+      current.edeps.clear();
+      current.edeps.push_back(edeps[i]);
+    }
+    blockStart += blockSize;
+  }
+
+  if (result.nUnits == 1) {
+    result.head = current;
+  } else if (result.nUnits > 1) {
+    result.tail = current;
+  }
+}
+
+// Combines the results of the ranges in their order and fills the histograms, returns the total number of units
+static unsigned long combineRanges(vector<RangeResult> &results, const arguments &args, vector<TH1 *> &hist) {
+  vector<unsigned int> multiplicity_counter(args.nhistograms, 0);
+  vector<double> EdepBuffer(args.nhistograms, 0.);
+  unsigned long nUnits = 0;
+
+  // Same as the sequential algorithm for a single unit
+  auto processUnit = [&](const Unit &unit) {
+    for (auto edep : unit.edeps) {
+      EdepBuffer[unit.volume] += edep;
+    }
+    multiplicity_counter[unit.volume]++;
+    if (multiplicity_counter[unit.volume] == args.multiplicity) {
+      hist[unit.volume]->Fill(EdepBuffer[unit.volume], unit.weight);
+      EdepBuffer[unit.volume] = 0.;
+      multiplicity_counter[unit.volume] = 0;
+    }
+    nUnits++;
+  };
+
+  Unit pending;
+  bool anyPending = false;
+  for (auto &result : results) {
+    if (result.empty) {
+      continue;
+    }
+    if (anyPending && args.addback && result.head.event == pending.event) {
+      // The first unit of this range continues the last one of a previous range
+      pending.edeps.insert(pending.edeps.end(), result.head.edeps.begin(), result.head.edeps.end());
+    } else {
+      if (anyPending) {
+        processUnit(pending);
+      }
+      pending = result.head;
+      anyPending = true;
+    }
+    if (result.nUnits == 1) {
+      continue;
+    }
+
+    processUnit(pending);
+    for (unsigned int volume = 0; volume < args.nhistograms; ++volume) {
+      if (result.nInnerUnits[volume] == 0) {
+        continue;
+      }
+      const Phase &phase = result.phases[volume][multiplicity_counter[volume]];
+      if (multiplicity_counter[volume] == 0) {
+        hist[volume]->Add(&phase.hist);
+        EdepBuffer[volume] = phase.buffer;
+      } else {
+        for (auto edep : phase.leadEdeps) {
+          EdepBuffer[volume] += edep;
+        }
+        if (phase.leadClosed) {
+          hist[volume]->Fill(EdepBuffer[volume]);
+          hist[volume]->Add(&phase.hist);
+          EdepBuffer[volume] = phase.buffer;
+        }
+      }
+      multiplicity_counter[volume] = (unsigned int)((multiplicity_counter[volume] + result.nInnerUnits[volume]) % args.multiplicity);
+      nUnits += result.nInnerUnits[volume];
+    }
+    pending = result.tail;
+  }
+  if (anyPending) {
+    processUnit(pending);
+  }
+
+  return nUnits;
+}
+
+// Returns true if the tree in the file was written by utr with /utr/mergeNtuples, which appends ' (merged)' to its title.
+// The entries of a single event may be split between the blocks of different threads in such a tree.
+static bool isMergedTree(const string &filename, const string &treeName) {
+  TFile file(filename.c_str());
+  const TTree *tree = file.IsZombie() ? nullptr : (const TTree *)file.Get(treeName.c_str());
+  if (tree == nullptr) {
+    return false;
+  }
+  const string title = tree->GetTitle();
+  const string suffix = " (merged)";
+  return title.size() >= suffix.size() && title.compare(title.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Cache of the results of single input files (option --cachedir)
+//
+// The result of processing a single input file is a RangeResult for the range of all of its entries. It is stored in
+// a cache file in CACHEDIR together with a key that consists of the path, size and modification time of the input file
+// and all parameters that influence the result. A re-run only processes input files whose key changed and combines
+// the results of all files like in parallel mode, so the bin contents are identical to the ones without a cache.
+
+static string cacheKey(const string &filename, const arguments &args) {
+  struct stat fileStatus;
+  if (stat(filename.c_str(), &fileStatus) != 0) {
+    return "";
+  }
+  char *path = realpath(filename.c_str(), nullptr);
+  stringstream key;
+  key.precision(17);
+  key << (path != nullptr ? path : filename) << " " << fileStatus.st_size << " " << fileStatus.st_mtim.tv_sec << "." << fileStatus.st_mtim.tv_nsec;
+  key << " " << args.tree << " " << args.binning << " " << args.eMax << " " << args.nhistograms << " " << args.multiplicity << " " << args.addback << " " << args.weight;
+  free(path);
+  return key.str();
+}
+
+// The name of the cache file depends on the path of the input file and the parameters, but not on the size and
+// modification time, so that a changed input file replaces its old cache file.
+static string cacheFilename(const string &filename, const arguments &args) {
+  char *path = realpath(filename.c_str(), nullptr);
+  stringstream id;
+  id.precision(17);
+  id << (path != nullptr ? path : filename) << " " << args.tree << " " << args.binning << " " << args.eMax << " " << args.nhistograms << " " << args.multiplicity << " " << args.addback << " " << args.weight;
+  free(path);
+
+  // 64 bit FNV-1a hash, which does not depend on the compiler or the platform, unlike std::hash
+  unsigned long long hash = 14695981039346656037ULL;
+  for (char c : id.str()) {
+    hash = (hash ^ (unsigned char)c) * 1099511628211ULL;
+  }
+
+  const size_t slash = filename.find_last_of('/');
+  stringstream cacheFile;
+  cacheFile << args.cacheDir << "/" << (slash == string::npos ? filename : filename.substr(slash + 1)) << "_" << std::hex << hash << ".root";
+  return cacheFile.str();
+}
+
+static void appendUnit(vector<double> &values, const Unit &unit) {
+  values.push_back(unit.event);
+  values.push_back(unit.volume);
+  values.push_back(unit.weight);
+  values.push_back((double)unit.edeps.size());
+  values.insert(values.end(), unit.edeps.begin(), unit.edeps.end());
+}
+
+// Reads a unit that starts at values[position] and advances position, returns false if values is too short
+static bool readUnit(const vector<double> &values, size_t &position, Unit &unit) {
+  if (position + 4 > values.size()) {
+    return false;
+  }
+  unit.event = values[position];
+  unit.volume = (unsigned int)values[position + 1];
+  unit.weight = values[position + 2];
+  const size_t nedeps = (size_t)values[position + 3];
+  position += 4;
+  if (position + nedeps > values.size()) {
+    return false;
+  }
+  unit.edeps.assign(values.begin() + (long)position, values.begin() + (long)(position + nedeps));
+  position += nedeps;
+  return true;
+}
+
+static void writeCache(const RangeResult &result, const string &cacheFile, const string &key, const arguments &args) {
+  TFile file(cacheFile.c_str(), "RECREATE");
+  if (file.IsZombie()) {
+    return;
+  }
+  TNamed keyObject("key", key.c_str());
+  keyObject.Write();
+
+  vector<double> values{(double)result.empty, (double)result.nUnits, (double)result.nInvalidEntries};
+  appendUnit(values, result.head);
+  appendUnit(values, result.tail);
+  values.insert(values.end(), result.nInnerUnits.begin(), result.nInnerUnits.end());
+  file.WriteObject(&values, "result");
+
+  // Phases of volumes without inner units are never used
+  for (unsigned int volume = 0; volume < args.nhistograms; ++volume) {
+    if (result.nInnerUnits[volume] == 0) {
+      continue;
+    }
+    for (unsigned int r = 0; r < args.multiplicity; ++r) {
+      const Phase &phase = result.phases[volume][r];
+      vector<double> state{(double)phase.leadOpen, (double)phase.leadClosed, (double)phase.counter, phase.buffer};
+      state.insert(state.end(), phase.leadEdeps.begin(), phase.leadEdeps.end());
+      stringstream name;
+      name << "phase_" << volume << "_" << r;
+      file.WriteObject(&state, name.str().c_str());
+      name << "_hist";
+      file.WriteTObject(&phase.hist, name.str().c_str());
+    }
+  }
+  file.Close();
+}
+
+// Returns false if the cache file does not exist, belongs to a different key or is incomplete
+static bool readCache(RangeResult &result, const string &cacheFile, const string &key, const arguments &args, const TH1D &templateHist) {
+  if (access(cacheFile.c_str(), R_OK) != 0) {
+    return false;
+  }
+  TFile file(cacheFile.c_str());
+  if (file.IsZombie()) {
+    return false;
+  }
+  TNamed *keyObject = nullptr;
+  file.GetObject("key", keyObject);
+  if (keyObject == nullptr || key != keyObject->GetTitle()) {
+    return false;
+  }
+
+  vector<double> *values = nullptr;
+  file.GetObject("result", values);
+  if (values == nullptr || values->size() < 3) {
+    return false;
+  }
+  result.empty = (*values)[0] != 0.;
+  result.nUnits = (unsigned long)(*values)[1];
+  result.nInvalidEntries = (unsigned long)(*values)[2];
+  size_t position = 3;
+  if (!readUnit(*values, position, result.head) || !readUnit(*values, position, result.tail) || values->size() - position != args.nhistograms) {
+    delete values;
+    return false;
+  }
+  result.nInnerUnits.assign(args.nhistograms, 0);
+  for (unsigned int volume = 0; volume < args.nhistograms; ++volume) {
+    result.nInnerUnits[volume] = (unsigned long)(*values)[position + volume];
+  }
+  delete values;
+
+  result.phases.assign(args.nhistograms, vector<Phase>(args.multiplicity));
+  for (unsigned int volume = 0; volume < args.nhistograms; ++volume) {
+    for (unsigned int r = 0; r < args.multiplicity; ++r) {
+      Phase &phase = result.phases[volume][r];
+      phase.hist = templateHist;
+      if (result.nInnerUnits[volume] == 0) {
+        continue;
+      }
+      stringstream name;
+      name << "phase_" << volume << "_" << r;
+      vector<double> *state = nullptr;
+      file.GetObject(name.str().c_str(), state);
+      name << "_hist";
+      TH1D *hist = nullptr;
+      file.GetObject(name.str().c_str(), hist);
+      if (state == nullptr || state->size() < 4 || hist == nullptr || hist->GetNbinsX() != templateHist.GetNbinsX()) {
+        delete state;
+        delete hist;
+        return false;
+      }
+      phase.leadOpen = (*state)[0] != 0.;
+      phase.leadClosed = (*state)[1] != 0.;
+      phase.counter = (unsigned int)(*state)[2];
+      phase.buffer = (*state)[3];
+      phase.leadEdeps.assign(state->begin() + 4, state->end());
+      phase.hist.Add(hist);
+      delete state;
+      delete hist;
+    }
+  }
+  return true;
+}
+
+// Processes all input files that are not in the cache with up to 'nthreads' threads, updates their cache files and
+// fills the histograms. Returns the total number of units like combineRanges.
+static unsigned long processWithCache(const vector<string> &filenames, const arguments &args, const unsigned int nthreads, const TH1D &templateHist, vector<TH1 *> &hist) {
+  if (access(args.cacheDir.c_str(), F_OK) != 0 && mkdir(args.cacheDir.c_str(), 0755) != 0) {
+    cerr << "> ERROR: Could not create CACHEDIR '" << args.cacheDir << "'! Aborting..." << endl;
+    exit(1);
+  }
+
+  vector<RangeResult> results(filenames.size());
+  vector<string> keys(filenames.size());
+  vector<size_t> missing;
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    keys[i] = cacheKey(filenames[i], args);
+    if (keys[i] == "" || !readCache(results[i], cacheFilename(filenames[i], args), keys[i], args, templateHist)) {
+      results[i] = RangeResult();
+      missing.push_back(i);
+    }
+  }
+  if (args.verbose) {
+    cout << "> Found " << filenames.size() - missing.size() << " of " << filenames.size() << " files in the cache" << endl;
+  }
+
+  // Each thread takes the next missing file until all are processed
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t j = next++; j < missing.size(); j = next++) {
+      const size_t i = missing[j];
+      processRange(results[i], {filenames[i]}, args, templateHist, 0, std::numeric_limits<long>::max());
+      if (keys[i] != "") {
+        writeCache(results[i], cacheFilename(filenames[i], args), keys[i], args);
+      }
+    }
+  };
+  vector<std::thread> threads;
+  for (unsigned int t = 0; t < std::min((size_t)nthreads, missing.size()); ++t) {
+    threads.push_back(std::thread(worker));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  unsigned long nInvalidEntries = 0;
+  for (auto &result : results) {
+    nInvalidEntries += result.nInvalidEntries;
+  }
+  if (args.verbose && nInvalidEntries > 0) {
+    cout << "Warning: Skipped " << nInvalidEntries << " entries with volume > MAXID = " << args.nhistograms - 1 << endl;
+  }
+
+  return combineRanges(results, args, hist);
+}
+
 int main(int argc, char *argv[]) {
 
   struct arguments arguments;
@@ -183,9 +676,24 @@ int main(int argc, char *argv[]) {
     } else {
       cout << "FALSE" << endl;
     }
+    if (arguments.weight) {
+      cout << "> WEIGHT       : TRUE" << endl;
+    }
+    if (arguments.threads != 1) {
+      cout << "> THREADS      : " << arguments.threads << endl;
+    }
+    if (arguments.cacheDir != "") {
+      cout << "> CACHEDIR     : " << arguments.cacheDir << endl;
+    }
     cout << "#############################################" << endl;
   }
 
+  // The weights of the units in a block of MULTIPLICITY units can differ, so there is no weight for their sum
+  if (arguments.weight && arguments.multiplicity != 1) {
+    cerr << "> ERROR: The option --weight requires MULTIPLICITY 1! Aborting..." << endl;
+    exit(1);
+  }
+
   // Find all files in the current directory that contain pattern1 and pattern1 and connect them to a TChain
   if (!opendir(arguments.inputDir.c_str())) {
     cerr << "> ERROR: Supplied INPUTDIR is not a valid directory! Aborting..." << endl;
@@ -201,6 +709,7 @@ int main(int argc, char *argv[]) {
   TSystemDirectory dir("INPUTDIRECTORY", arguments.inputDir.c_str());
   TChain fileChain(arguments.tree.c_str());
   TString fname;
+  vector<string> filenames; // Needed to create a separate TChain for each thread in parallel mode
   TIter next(dir.GetListOfFiles());
   TSystemFile *file = (TSystemFile *)next();
 
@@ -211,6 +720,7 @@ int main(int argc, char *argv[]) {
         cout << fname << endl;
       }
       fileChain.Add(fname);
+      filenames.push_back(fname.Data());
     }
     file = (TSystemFile *)next();
   }
@@ -246,93 +756,178 @@ int main(int argc, char *argv[]) {
   }
   hist[arguments.nhistograms] = new TH1D("sum", "Sum spectrum of all detectors", nbins, emin, eMax);
 
-  vector<unsigned int> multiplicity_counter(arguments.nhistograms, 0);
+  // Only the branches which are needed are read, all others are deactivated
+  BulkReader reader;
+  if (!reader.Connect(fileChain, requiredBranches(arguments))) {
+    if (arguments.weight) {
+      cerr << "> ERROR: The tree '" << arguments.tree << "' does not contain the branch 'weight' (required for --weight) or the branches 'edep', 'volume' and, for addback, 'event' with a supported type! Aborting..." << endl;
+    } else if (arguments.addback) {
+      cerr << "> ERROR: The tree '" << arguments.tree << "' does not contain the branches 'edep', 'volume' and 'event' (required for addback) with a supported type! Aborting..." << endl;
+    } else {
+      cerr << "> ERROR: The tree '" << arguments.tree << "' does not contain the branches 'edep' and 'volume' with a supported type! Aborting..." << endl;
+    }
+    exit(1);
+  }
 
-  // Fill histogram from TBranch in TChain with user-defined conditions
-  // Define variables and automatically update their values from the ROOT tree using the GetEntry method after registering them with the SetBranchAddress method
-  double Event, lastEvent;
-  double Volume; // Needs to be double to correctly work with GetEntry and SetBranchAddress methods
-  unsigned int lastVolume; // Needs to be unsigned int to correctly work with array indices
-  double Edep;
-  vector<double> EdepBuffer(arguments.nhistograms, 0.);
+  if (fileChain.GetEntries() == 0) {
+    cerr << "> ERROR: The input files do not contain any entries! Aborting..." << endl;
+    exit(1);
+  }
 
-  fileChain.SetBranchAddress("edep", &Edep);
-  fileChain.SetBranchAddress("volume", &Volume);
+  // Addback relies on consecutive entries of an event, which is not guaranteed for merged ntuples
   if (arguments.addback) {
-    fileChain.SetBranchAddress("event", &Event);
-  } else {
-    Event = -1; // If addback is disabled, Event will not be relevant in the code below, and the ROOT tree is not required to contain it
+    for (const auto &filename : filenames) {
+      if (isMergedTree(filename, arguments.tree)) {
+        cerr << "> ERROR: The tree '" << arguments.tree << "' in '" << filename << "' was written with /utr/mergeNtuples, which may split the entries of an event between the blocks of different threads. Addback would count the parts as separate events. Aborting..." << endl;
+        exit(1);
+      }
+    }
   }
 
   unsigned int addback_counter = 0;
-  unsigned int warningCounter = 0;
-
-  // The addback-option compares the event number of the last energy deposition to the present event number.
-  // If the present event number is different from the last one, the energy deposition buffer is filled into
-  // the histogram, set to zero, and then the present energy deposition is added to the buffer.
-  // This procedure requires that the 'last event' has been defined, therefore getHistogram
-  // preprocesses the first event manually.
-  //
-  // A valid last event has a valid detector ID. The following while loop reads entries until it finds a
-  // valid last event.
-  fileChain.GetEntry(0);
-  long entry = 1;
-  while ((unsigned int)Volume >= arguments.nhistograms && entry < fileChain.GetEntries()) { // Make sure that always a valid volume is given as the last volume
-    if (warningCounter < 10) {
-      cout << "Warning: Entry with volume = " << (unsigned int)Volume << " > MAXID = " << arguments.nhistograms - 1 << " encountered. Skipping this entry." << endl;
-      warningCounter++;
-      if (warningCounter == 10) {
-        cout << "Warning: No more warnings of this type will be displayed!" << endl;
+
+  if (arguments.threads != 1 || arguments.cacheDir != "") {
+    unsigned int nthreads = arguments.threads == 0 ? std::thread::hardware_concurrency() : arguments.threads;
+    if (nthreads == 0) {
+      nthreads = 1;
+    }
+
+    ROOT::EnableThreadSafety();
+    TH1::AddDirectory(false);
+    const TH1D templateHist("template", "template", nbins, emin, eMax);
+
+    if (arguments.cacheDir != "") {
+      addback_counter = (unsigned int)processWithCache(filenames, arguments, nthreads, templateHist, hist);
+    } else {
+      const long nentries = fileChain.GetEntries();
+      if (nthreads > nentries) {
+        nthreads = (unsigned int)nentries;
+      }
+
+      vector<RangeResult> results(nthreads);
+      vector<std::thread> threads;
+      for (unsigned int i = 0; i < nthreads; ++i) {
+        threads.push_back(std::thread(processRange, std::ref(results[i]), std::cref(filenames), std::cref(arguments), std::cref(templateHist), nentries * i / nthreads, nentries * (i + 1) / nthreads));
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+
+      addback_counter = (unsigned int)combineRanges(results, arguments, hist);
+
+      unsigned long nInvalidEntries = 0;
+      for (auto &result : results) {
+        nInvalidEntries += result.nInvalidEntries;
+      }
+      if (arguments.verbose && nInvalidEntries > 0) {
+        cout << "Warning: Skipped " << nInvalidEntries << " entries with volume > MAXID = " << arguments.nhistograms - 1 << endl;
       }
     }
-    fileChain.GetEntry(entry);
-    entry++;
-  }
-  lastEvent = Event;
-  lastVolume = (unsigned int)Volume;
-  EdepBuffer[lastVolume] = Edep;
-
-  // Process next events in loops
-  while (entry < fileChain.GetEntries()) {
-    // Get the entry, this sets the values for the Edep, Volume and Event variables
-    fileChain.GetEntry(entry);
-    if ((unsigned int)Volume < arguments.nhistograms) { // nhistograms=MAXID+1 so must always be greater than Volume to consider that Volume
-      // If addback is disabled or the event number has changed:
-      if (!arguments.addback || lastEvent != Event) {
-        // First process the *last* event still in the buffer:
-        // Increase the volumes multiplicity counter
-        multiplicity_counter[lastVolume]++;
-        // If multiplicity counter is high enough write the buffered energy value to the histogram
-        if (multiplicity_counter[lastVolume] == arguments.multiplicity) {
-          hist[lastVolume]->Fill(EdepBuffer[lastVolume]); // Fill own histogram
-          hist[arguments.nhistograms]->Fill(EdepBuffer[lastVolume]); // Fill sum histogram
-          EdepBuffer[lastVolume] = 0.; // Reset energy buffer to zero
-          multiplicity_counter[lastVolume] = 0; // Reset multiplicity counter to zero
+
+    // Every filled value also enters the sum histogram, so it is the sum of all other ones
+    for (unsigned int i = 0; i < arguments.nhistograms; ++i) {
+      hist[arguments.nhistograms]->Add(hist[i]);
+    }
+  } else {
+    vector<unsigned int> multiplicity_counter(arguments.nhistograms, 0);
+
+    // Fill histogram from TBranch in TChain with user-defined conditions
+    // The BulkReader reads blocks of entries, the getEntry function below updates these variables from the current block
+    // The branches can be double, float or int columns depending on the build options of utr, the BulkReader converts them to double
+    double Event, lastEvent;
+    double Volume;
+    unsigned int lastVolume; // Needs to be unsigned int to correctly work with array indices
+    double Edep;
+    double Weight, lastWeight;
+    vector<double> EdepBuffer(arguments.nhistograms, 0.);
+
+    // Reads an entry and updates the values of Edep, Volume and Event
+    // Entries are always requested in increasing order, so a new block is only read at the end of the current one
+    long blockStart = 0, blockSize = 0;
+    auto getEntry = [&](long i) {
+      if (i >= blockStart + blockSize) {
+        blockStart = i;
+        blockSize = reader.Read(i);
+      }
+      const long j = i - blockStart;
+      Edep = reader.Column(0)[j];
+      Volume = reader.Column(1)[j];
+      // If addback is disabled, Event will not be relevant in the code below, and the ROOT tree is not required to contain it
+      Event = arguments.addback ? reader.Column(2)[j] : -1;
+      Weight = arguments.weight ? reader.Column(weightColumn(arguments))[j] : 1.;
+    };
+
+    unsigned int warningCounter = 0;
+
+    // The addback-option compares the event number of the last energy deposition to the present event number.
+    // If the present event number is different from the last one, the energy deposition buffer is filled into
+    // the histogram, set to zero, and then the present energy deposition is added to the buffer.
+    // This procedure requires that the 'last event' has been defined, therefore getHistogram
+    // preprocesses the first event manually.
+    //
+    // A valid last event has a valid detector ID. The following while loop reads entries until it finds a
+    // valid last event.
+    getEntry(0);
+    long entry = 1;
+    while ((unsigned int)Volume >= arguments.nhistograms && entry < fileChain.GetEntries()) { // Make sure that always a valid volume is given as the last volume
+      if (warningCounter < 10) {
+        cout << "Warning: Entry with volume = " << (unsigned int)Volume << " > MAXID = " << arguments.nhistograms - 1 << " encountered. Skipping this entry." << endl;
+        warningCounter++;
+        if (warningCounter == 10) {
+          cout << "Warning: No more warnings of this type will be displayed!" << endl;
         }
-        // Now update history variables to *this* event and increase addback_counter
-        addback_counter++;
-        lastEvent = Event;
-        lastVolume = (unsigned int)Volume;
       }
-      // Add Edep value to buffer (necessary for addback and multiplicity), note that the *last* Volume can now already be *this* event's volume
-      EdepBuffer[lastVolume] += Edep;
-    } else if (arguments.verbose && warningCounter < 10) {
-      cout << "Warning: Entry with volume = " << (unsigned int)Volume << " > MAXID = " << arguments.nhistograms - 1 << " encountered. Skipping this entry." << endl;
-      warningCounter++;
-      if (warningCounter == 10) {
-        cout << "Warning: No more warnings of this type will be displayed!" << endl;
+      getEntry(entry);
+      entry++;
+    }
+    lastEvent = Event;
+    lastVolume = (unsigned int)Volume;
+    lastWeight = Weight;
+    EdepBuffer[lastVolume] = Edep;
+
+    // Process next events in loops
+    while (entry < fileChain.GetEntries()) {
+      // Get the entry, this sets the values for the Edep, Volume and Event variables
+      getEntry(entry);
+      if ((unsigned int)Volume < arguments.nhistograms) { // nhistograms=MAXID+1 so must always be greater than Volume to consider that Volume
+        // If addback is disabled or the event number has changed:
+        if (!arguments.addback || lastEvent != Event) {
+          // First process the *last* event still in the buffer:
+          // Increase the volumes multiplicity counter
+          multiplicity_counter[lastVolume]++;
+          // If multiplicity counter is high enough write the buffered energy value to the histogram
+          if (multiplicity_counter[lastVolume] == arguments.multiplicity) {
+            hist[lastVolume]->Fill(EdepBuffer[lastVolume], lastWeight); // Fill own histogram
+            hist[arguments.nhistograms]->Fill(EdepBuffer[lastVolume], lastWeight); // Fill sum histogram
+            EdepBuffer[lastVolume] = 0.; // Reset energy buffer to zero
+            multiplicity_counter[lastVolume] = 0; // Reset multiplicity counter to zero
+          }
+          // Now update history variables to *this* event and increase addback_counter
+          addback_counter++;
+          lastEvent = Event;
+          lastVolume = (unsigned int)Volume;
+          lastWeight = Weight;
+        }
+        // Add Edep value to buffer (necessary for addback and multiplicity), note that the *last* Volume can now already be *this* event's volume
+        EdepBuffer[lastVolume] += Edep;
+      } else if (arguments.verbose && warningCounter < 10) {
+        cout << "Warning: Entry with volume = " << (unsigned int)Volume << " > MAXID = " << arguments.nhistograms - 1 << " encountered. Skipping this entry." << endl;
+        warningCounter++;
+        if (warningCounter == 10) {
+          cout << "Warning: No more warnings of this type will be displayed!" << endl;
+        }
       }
+      ++entry;
     }
-    ++entry;
-  }
 
-  // (Post)Process last event manually
-  multiplicity_counter[lastVolume]++;
-  if (multiplicity_counter[lastVolume] == arguments.multiplicity) {
-    hist[lastVolume]->Fill(EdepBuffer[lastVolume]); // Fill own histogram
-    hist[arguments.nhistograms]->Fill(EdepBuffer[lastVolume]); // Fill sum histogram
+    // (Post)Process last event manually
+    multiplicity_counter[lastVolume]++;
+    if (multiplicity_counter[lastVolume] == arguments.multiplicity) {
+      hist[lastVolume]->Fill(EdepBuffer[lastVolume], lastWeight); // Fill own histogram
+      hist[arguments.nhistograms]->Fill(EdepBuffer[lastVolume], lastWeight); // Fill sum histogram
+    }
+    addback_counter++;
   }
-  addback_counter++;
 
   if (arguments.verbose) {
     cout << "> Processed " << fileChain.GetEntries() << " entries" << endl;
@@ -9,6 +9,8 @@
 #include <TROOT.h>
 #include <TSystemDirectory.h>
 
+#include "BulkReader.hh"
+
 using std::size_t;
 using std::vector;
 
@@ -120,21 +122,34 @@ int main(int argc, char *argv[]) {
   Double_t event = 0;
   Double_t volume;
 
-  utr.SetBranchAddress("volume", &volume);
-  utr.SetBranchAddress("event", &event);
+  // The branches can be double or int columns depending on the build options of utr
+  // Only the branches 'volume' and 'event' are read, in blocks of many entries
+  BulkReader reader;
+  if (!reader.Connect(utr, {"volume", "event"})) {
+    cerr << "> ERROR: The tree '" << args.tree << "' does not contain the branches 'volume' and 'event' with a supported type! Aborting...\n";
+    exit(1);
+  }
 
   map<Double_t, int> counters, counters_first;
-  for (int i = 0; i < utr.GetEntries(); ++i) {
-    utr.GetEntry(i);
-    if (!counters.count(volume))
-      counters[volume] = 0;
-    if (!counters_first.count(volume))
-      counters_first[volume] = 0;
-
-    if (event != prev_event)
-      counters_first[volume]++;
-    counters[volume]++;
-    prev_event = event;
+  const long nentries = utr.GetEntries();
+  for (long blockStart = 0; blockStart < nentries;) {
+    const long blockSize = reader.Read(blockStart);
+    if (blockSize <= 0) {
+      break;
+    }
+    const double *volumes = reader.Column(0);
+    const double *events = reader.Column(1);
+    for (long i = 0; i < blockSize; ++i) {
+      volume = volumes[i];
+      event = events[i];
+      // operator[] inserts a zero counter for a new volume, so every volume which was hit appears in both maps
+      counters[volume]++;
+      int &counter_first = counters_first[volume];
+      if (event != prev_event)
+        counter_first++;
+      prev_event = event;
+    }
+    blockStart += blockSize;
   }
 
   if (args.verbose) {
@@ -19,7 +19,6 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <argp.h>
-#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <stdlib.h>
@@ -30,10 +29,11 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include <TROOT.h>
 //#include <TApplication.h>
 
+#include "BufferedWriter.hh"
+
 using std::cerr;
 using std::cout;
 using std::endl;
-using std::ofstream;
 using std::string;
 using std::stringstream;
 
@@ -139,7 +139,6 @@ int main(int argc, char *argv[]) {
 
   // Loop over all keys (hopefully all of them are TH1 histograms) and write their content to separate output files
   stringstream outputFilename;
-  ofstream outFile;
 
   for (Int_t i = arguments.indexBegin; i <= maxIndex; i++) {
     TString histogramName = inFile->GetListOfKeys()->At(i)->GetName();
@@ -151,17 +150,20 @@ int main(int argc, char *argv[]) {
       cout << "Histogram " << histogramName << " is empty. Skipping..." << endl;
     } else {
       outputFilename << arguments.filenamePrefix << "_" << histogramName << ".txt";
-      outFile.open(outputFilename.str().c_str());
+      // Same format as an std::ofstream with the default precision of 6 digits
+      BufferedWriter outFile(outputFilename.str());
 
       Int_t nbins = hist->GetNbinsX();
       for (Int_t j = 1; j <= nbins; j++) {
         if (!arguments.countsOnly) {
-          outFile << hist->GetBinCenter(j) << "\t";
+          outFile.General(hist->GetBinCenter(j));
+          outFile.Char('\t');
         }
-        outFile << hist->GetBinContent(j) << "\n";
+        outFile.General(hist->GetBinContent(j));
+        outFile.Char('\n');
       }
 
-      outFile.close();
+      outFile.Close();
       cout << "Output file " << outputFilename.str() << " created." << endl;
       outputFilename.str("");
     }
@@ -5,30 +5,111 @@
 #include <TROOT.h>
 #include <TTree.h>
 
-#include <fstream>
-#include <iomanip>
+#include <argp.h>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <iostream>
-#include <sstream>
+#include <memory>
+#include <mutex>
 #include <stdlib.h>
+#include <thread>
 #include <time.h>
+#include <vector>
+
+#include "BufferedWriter.hh"
+#include "BulkReader.hh"
 
 using std::cout;
 using std::endl;
-using std::ofstream;
-using std::setprecision;
 using std::string;
-using std::stringstream;
+using std::vector;
+
+static char doc[] = "Convert the first TTree in a ROOT file to a text file with one column for each TBranch";
+static char args_doc[] = "ROOT_FILE";
+
+static struct argp_option options[] = {
+    {"binary", 'b', 0, 0, "Write each TBranch to a separate raw binary file of little-endian doubles instead of a text file (default: Off)"},
+    {"readahead", 'r', 0, 0, "Read the next entries on a separate thread while the current ones are written (default: Off)"},
+    {0, 0, 0, 0, 0}};
+
+struct arguments {
+  char *args[1];
+  bool binary = false;
+  bool readahead = false;
+};
+
+static error_t parse_opt(int key, char *arg, struct argp_state *state) {
+  struct arguments *arguments = (struct arguments *)state->input;
+
+  switch (key) {
+    case 'b':
+      arguments->binary = true;
+      break;
+    case 'r':
+      arguments->readahead = true;
+      break;
+    case ARGP_KEY_ARG:
+      if (state->arg_num >= 1) {
+        cout << "Error: rootToTxt takes only one argument!" << endl;
+        argp_usage(state);
+      }
+      arguments->args[state->arg_num] = arg;
+      break;
+    case ARGP_KEY_END:
+      if (state->arg_num < 1) {
+        cout << "Error: rootToTxt needs exactly one argument!" << endl;
+        argp_usage(state);
+      }
+      break;
+    default:
+      return ARGP_ERR_UNKNOWN;
+  }
+  return 0;
+}
 
-#define MAXNBRANCHES 20
+static struct argp argp = {options, parse_opt, args_doc, doc, 0, 0, 0};
+
+// Copy of a block of entries from the BulkReader, which is passed from the reading to the writing thread
+struct Block {
+  long size = 0;
+  vector<vector<double>> columns;
+};
+
+// Bounded queue of blocks between the reading and the writing thread. An empty block marks the end.
+class BlockQueue {
+  public:
+  void Push(std::unique_ptr<Block> block) {
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [this] { return blocks.size() < capacity; });
+    blocks.push_back(std::move(block));
+    notEmpty.notify_one();
+  }
+
+  std::unique_ptr<Block> Pop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    notEmpty.wait(lock, [this] { return !blocks.empty(); });
+    std::unique_ptr<Block> block = std::move(blocks.front());
+    blocks.pop_front();
+    notFull.notify_one();
+    return block;
+  }
+
+  private:
+  const size_t capacity = 4;
+  std::deque<std::unique_ptr<Block>> blocks;
+  std::mutex mutex;
+  std::condition_variable notEmpty, notFull;
+};
 
 int main(int argc, char *argv[]) {
-  (void)argc;
-  // void RootToTxt(string filename){
+  struct arguments arguments;
+  argp_parse(&argp, argc, argv, 0, 0, &arguments);
 
   // Open ROOT file
-  string filename = argv[1];
+  string filename = arguments.args[0];
 
-  TFile *f = new TFile(argv[1]);
+  TFile *f = new TFile(filename.c_str());
   cout << "Opened ROOT file " << filename << endl;
 
   // Get number of TTree objects in the TFile (hopefully only one)
@@ -48,60 +129,142 @@ int main(int argc, char *argv[]) {
   cout << "Reading from TTree " << t->GetName() << endl;
 
   // Get number of TBranch objects in the TTree, output their names and put them in a list
-  Int_t nbranches = t->GetNbranches();
-  if (nbranches > MAXNBRANCHES)
-    cout << "Warning: TTree contains more than " << MAXNBRANCHES << "TBranch objects, change the variable MAXNBRANCHES in the code appropriately." << endl;
+  const size_t nbranches = (size_t)t->GetNbranches();
 
-  TBranch *branches[MAXNBRANCHES];
+  vector<string> branchNames;
   cout << "TTree contains " << nbranches << " TBranches:" << endl;
-  for (int i = 0; i < nbranches; i++) {
-    cout << (i + 1) << ".\t" << t->GetListOfBranches()->At(i)->GetName() << endl;
-    branches[i] = (TBranch *)t->GetListOfBranches()->At(i);
+  for (size_t i = 0; i < nbranches; i++) {
+    branchNames.push_back(t->GetListOfBranches()->At((Int_t)i)->GetName());
+    cout << (i + 1) << ".\t" << branchNames[i] << endl;
   }
 
-  // Open output file
-  stringstream outputfilename;
-  outputfilename << filename.substr(0, filename.length() - 5);
-  outputfilename << ".txt";
-
-  ofstream of;
-  of.open(outputfilename.str().c_str());
-
-  cout << "Opened output file " << outputfilename.str() << endl;
-
-  // Read out the content of TBranch objects and write it to a text file
-  Double_t b[MAXNBRANCHES];
+  // Open output files
+  // The text file has one line per entry with the values of all branches, separated and terminated by tabs.
+  // In binary mode, each branch is written to a separate file, which can be memory-mapped with numpy using
+  // numpy.memmap(FILENAME, dtype='<f8', mode='r')
+  const string basename = filename.substr(0, filename.length() - 5);
+  vector<std::unique_ptr<BufferedWriter>> writers;
+  if (arguments.binary) {
+    for (auto &branchName : branchNames) {
+      writers.emplace_back(new BufferedWriter(basename + "_" + branchName + ".bin"));
+      cout << "Opened output file " << basename + "_" + branchName + ".bin" << endl;
+    }
+  } else {
+    writers.emplace_back(new BufferedWriter(basename + ".txt"));
+    cout << "Opened output file " << basename + ".txt" << endl;
+  }
+  for (auto &writer : writers) {
+    if (!writer->IsOpen()) {
+      cout << "Error: Could not open output file." << endl;
+      abort();
+    }
+  }
 
-  for (int i = 0; i < nbranches; i++) {
-    t->SetBranchAddress(branches[i]->GetName(), &b[i]);
+  // Read out the content of TBranch objects and write it to the output files
+  // The branches can be double, float or int columns depending on the build options of utr, the BulkReader converts them to double
+  BulkReader reader;
+  if (!reader.Connect(*t, branchNames)) {
+    cout << "Error: A TBranch has an unsupported type." << endl;
+    abort();
   }
 
-  double percent;
+  const long nentries = (long)t->GetEntries();
   double nextpercent = 10;
   long tstart = time(0);
+  long nwritten = 0;
 
-  for (int i = 0; i < t->GetEntries(); i++) {
-    t->GetEntry(i);
-    for (int j = 0; j < nbranches; j++) {
-      of << std::scientific << std::setprecision(6) << b[j] << "\t";
+  auto writeBlock = [&](const vector<const double *> &columns, const long size) {
+    if (arguments.binary) {
+      for (size_t j = 0; j < nbranches; j++) {
+#ifdef R__BYTESWAP
+        // Little-endian machine, the values are already in the right byte order
+        writers[j]->Bytes(reinterpret_cast<const char *>(columns[j]), (size_t)size * sizeof(double));
+#else
+        for (long i = 0; i < size; i++) {
+          char bytes[sizeof(double)];
+          std::memcpy(bytes, &columns[j][i], sizeof(double));
+          for (size_t k = 0; k < sizeof(double) / 2; k++) {
+            std::swap(bytes[k], bytes[sizeof(double) - 1 - k]);
+          }
+          writers[j]->Bytes(bytes, sizeof(double));
+        }
+#endif
+      }
+    } else {
+      BufferedWriter &of = *writers[0];
+      for (long i = 0; i < size; i++) {
+        for (size_t j = 0; j < nbranches; j++) {
+          of.Scientific(columns[j][i], 6);
+          of.Char('\t');
+        }
+        of.Char('\n');
+      }
     }
-    of << endl;
-
-    percent = (i + 1) / ((double)t->GetEntries()) * 100.;
-    if (percent >= nextpercent) {
-      nextpercent = nextpercent + 10;
 
+    nwritten += size;
+    const double percent = (double)nwritten / (double)nentries * 100.;
+    while (percent >= nextpercent) {
       cout << "[";
-      for (int k = 1; k <= ((int)percent) / 10; k++)
+      for (int k = 1; k <= ((int)nextpercent) / 10; k++)
         cout << "=";
-      for (int k = ((int)percent / 10) + 1; k <= 10; k++)
+      for (int k = ((int)nextpercent / 10) + 1; k <= 10; k++)
         cout << " ";
 
       cout << "], " << time(0) - tstart << "s" << endl;
+      nextpercent = nextpercent + 10;
+    }
+  };
+
+  vector<const double *> columns(nbranches);
+  if (arguments.readahead) {
+    // The reading thread copies the blocks, since the BulkReader overwrites them with the next one
+    BlockQueue queue;
+    std::thread readingThread([&]() {
+      for (long blockStart = 0; blockStart < nentries;) {
+        const long blockSize = reader.Read(blockStart);
+        if (blockSize <= 0) {
+          break;
+        }
+        std::unique_ptr<Block> block(new Block);
+        block->size = blockSize;
+        block->columns.resize(nbranches);
+        for (size_t j = 0; j < nbranches; j++) {
+          block->columns[j].assign(reader.Column(j), reader.Column(j) + blockSize);
+        }
+        queue.Push(std::move(block));
+        blockStart += blockSize;
+      }
+      queue.Push(std::unique_ptr<Block>(new Block));
+    });
+
+    for (std::unique_ptr<Block> block = queue.Pop(); block->size > 0; block = queue.Pop()) {
+      for (size_t j = 0; j < nbranches; j++) {
+        columns[j] = block->columns[j].data();
+      }
+      writeBlock(columns, block->size);
+    }
+    readingThread.join();
+  } else {
+    for (long blockStart = 0; blockStart < nentries;) {
+      const long blockSize = reader.Read(blockStart);
+      if (blockSize <= 0) {
+        break;
+      }
+      for (size_t j = 0; j < nbranches; j++) {
+        columns[j] = reader.Column(j);
+      }
+      writeBlock(columns, blockSize);
+      blockStart += blockSize;
     }
   }
 
-  of.close();
+  for (auto &writer : writers) {
+    writer->Close();
+  }
 
-  cout << "Close output file " << outputfilename.str() << endl;
+  if (arguments.binary) {
+    cout << "Close output files " << basename << "_<BRANCH>.bin with " << nwritten << " values each" << endl;
+  } else {
+    cout << "Close output file " << basename << ".txt" << endl;
+  }
 }
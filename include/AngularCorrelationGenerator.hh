@@ -28,11 +28,20 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include <vector>
 
 #include "AngularDistribution.hh"
+#include "AngularDistributionSampler.hh"
+#include "SourceVolumeSampler.hh"
+#include "utrConfig.h"
+
+#ifdef PROFILE_GENERATORS
+#include "PrimaryGeneratorProfiler.hh"
+#endif
 
 #define CHECK_POSITION_GENERATOR 1
 #define CHECK_MOMENTUM_GENERATOR 1
-// Maximum value for the sampled w
-#define MAX_W 3.
+// Number of candidate directions which are sampled and evaluated at once by the rejection sampler
+#define MOMENTUM_BLOCK_SIZE 32
+// Number of cos(theta) cells of the piecewise envelope (twice as many cells are used for phi)
+#define ENVELOPE_BINS 32
 
 using std::vector;
 
@@ -58,6 +67,21 @@ class AngularCorrelationGenerator : public G4VUserPrimaryGeneratorAction {
   void check_momentum_generator();
   bool momentum_generator_check_unnecessary(unsigned long n_particle);
 
+  // Look up the angular distributions of all cascade steps. Called at the first event after
+  // the settings were changed by the messenger.
+  void resolve_kernels();
+  // Sample and evaluate blocks of candidate directions until at least one of them is accepted
+  void fill_momentum_buffer(unsigned long n_particle);
+  // Rejection sampling with the piecewise constant envelope of a cascade step
+  G4bool sample_direction_envelope(unsigned long n_particle, G4ThreeVector &direction);
+  void build_envelope(unsigned long n_particle);
+  // Uniformly distributed point on the unit circle without trigonometric functions
+  void random_unit_circle(G4double &cos_phi, G4double &sin_phi);
+  // True if the direction of a cascade step is fixed and not sampled from an angular distribution
+  G4bool direction_is_fixed(unsigned long n_particle) {
+    return (n_particle == 0 && direction_given) || (n_particle > 0 && relative_angle_given[n_particle]);
+  };
+
   // Set-methods to use with the AngularCorrelationMessenger
 
   void AddParticle(G4ParticleDefinition *particleDefinition) {
@@ -72,19 +96,24 @@ class AngularCorrelationGenerator : public G4VUserPrimaryGeneratorAction {
     states.push_back(vector<G4double>(4));
     alt_states.push_back(vector<G4double>(4));
     mixing_ratios.push_back(vector<G4double>(3));
+    kernels.push_back(AngularDistributionKernel());
+    kernels_resolved = false;
   };
   void SetEnergy(G4double energy) { particleEnergies[particleEnergies.end() - particleEnergies.begin() - 1] = energy; };
   void SetDirection(G4ThreeVector vec) {
     direction = vec;
     direction_given = true;
+    kernels_resolved = false;
   };
   void SetRelativeAngle(G4double relangle) {
     relative_angle[relative_angle.end() - relative_angle.begin() - 1] = relangle;
     relative_angle_given[relative_angle_given.end() - relative_angle_given.begin() - 1] = true;
+    kernels_resolved = false;
   };
 
   void SetNStates(G4int nst) {
     nstates[nstates.end() - nstates.begin() - 1] = nst;
+    kernels_resolved = false;
   };
   void SetState(G4int n_state, G4double jpi) {
     states[states.end() - states.begin() - 1][n_state] = jpi;
@@ -93,25 +122,62 @@ class AngularCorrelationGenerator : public G4VUserPrimaryGeneratorAction {
     } else {
       alt_states[states.end() - states.begin() - 1][n_state] = jpi;
     }
+    kernels_resolved = false;
   };
   void SetDelta(G4int n_transition, G4double delta) {
     mixing_ratios[mixing_ratios.end() - mixing_ratios.begin() - 1][n_transition] = delta;
+    kernels_resolved = false;
   };
   void SetPolarization(G4ThreeVector vec) {
     polarization[polarization.end() - polarization.begin() - 1] = vec;
     if (vec.mag() > 0.)
       is_polarized[is_polarized.end() - is_polarized.begin() - 1] = true;
+    kernels_resolved = false;
   };
 
-  void SetSourceX(G4double x) { source_x = x; };
-  void SetSourceY(G4double y) { source_y = y; };
-  void SetSourceZ(G4double z) { source_z = z; };
+  void SetSourceX(G4double x) {
+    source_x = x;
+    source_sampler.Reset();
+  };
+  void SetSourceY(G4double y) {
+    source_y = y;
+    source_sampler.Reset();
+  };
+  void SetSourceZ(G4double z) {
+    source_z = z;
+    source_sampler.Reset();
+  };
+
+  void SetSourceDX(G4double dx) {
+    range_x = dx;
+    source_sampler.Reset();
+  };
+  void SetSourceDY(G4double dy) {
+    range_y = dy;
+    source_sampler.Reset();
+  };
+  void SetSourceDZ(G4double dz) {
+    range_z = dz;
+    source_sampler.Reset();
+  };
 
-  void SetSourceDX(G4double dx) { range_x = dx; };
-  void SetSourceDY(G4double dy) { range_y = dy; };
-  void SetSourceDZ(G4double dz) { range_z = dz; };
+  void AddSourcePV(G4String physvol) {
+    source_PV_names.push_back(physvol);
+    source_sampler.Reset();
+  };
+  void SetPositionSampler(G4String sampler_name) {
+    position_sampler_method = (sampler_name == "solid") ? POSITION_SAMPLER_SOLID : POSITION_SAMPLER_BOX;
+    source_sampler.Reset();
+  };
 
-  void AddSourcePV(G4String physvol) { source_PV_names.push_back(physvol); };
+  void SetUseEnvelope(G4bool use) {
+    use_envelope = use;
+    kernels_resolved = false;
+  };
+  void SetMaxW(G4double mw) {
+    max_w_user = mw;
+    kernels_resolved = false;
+  };
 
   // Get-methods to use with the AngularCorrelationMessenger
 
@@ -140,6 +206,10 @@ class AngularCorrelationGenerator : public G4VUserPrimaryGeneratorAction {
 
   G4String GetSourcePV(int i) { return source_PV_names[i]; };
 
+  G4String GetPositionSampler() { return position_sampler_method == POSITION_SAMPLER_SOLID ? "solid" : "box"; };
+  G4bool GetUseEnvelope() { return use_envelope; };
+  G4double GetMaxW() { return max_w_user; };
+
   private:
   G4ParticleTable *particleTable;
   G4ParticleGun *particleGun;
@@ -169,6 +239,9 @@ class AngularCorrelationGenerator : public G4VUserPrimaryGeneratorAction {
   G4String pvz;
   G4String pvmz;
 
+  position_sampler position_sampler_method;
+  SourceVolumeSampler source_sampler;
+
   // Particle properties
   vector<G4ParticleDefinition *> particles;
   vector<G4double> particleEnergies;
@@ -185,6 +258,23 @@ class AngularCorrelationGenerator : public G4VUserPrimaryGeneratorAction {
   vector<G4bool> is_polarized;
   vector<G4ThreeVector> polarization;
 
+  // Angular distribution of each cascade step, including the sum over both possible
+  // polarizations for an unpolarized step
+  vector<AngularDistributionKernel> kernels;
+  G4bool kernels_resolved;
+  // Directions of each cascade step which were accepted by the rejection sampler, but not used yet
+  vector<vector<G4ThreeVector>> accepted_directions;
+  // Upper limit for W of each cascade step, which is used as the constant envelope of the
+  // rejection sampler. It is determined from the kernel, unless a positive value was given by the user.
+  vector<G4double> max_w;
+  G4double max_w_user;
+  // Piecewise constant envelope of each cascade step, i.e. the maximum of W in each
+  // (cos(theta), phi) cell, and samplers which select the cells with a probability
+  // proportional to their envelope
+  G4bool use_envelope;
+  vector<vector<G4double>> envelope_w;
+  vector<AngularDistributionSampler> envelope_samplers;
+
   /*********************************************
    *  Local variables
    *********************************************/
@@ -194,6 +284,7 @@ class AngularCorrelationGenerator : public G4VUserPrimaryGeneratorAction {
   G4double random_z;
 
   G4double random_theta;
+  G4double random_cos_theta;
   G4double random_phi;
   G4double random_w;
 
@@ -206,4 +297,8 @@ class AngularCorrelationGenerator : public G4VUserPrimaryGeneratorAction {
 
   G4bool checked_momentum_generator;
   G4bool checked_position_generator;
+
+#ifdef PROFILE_GENERATORS
+  PrimaryGeneratorProfiler profiler;
+#endif
 };
@@ -85,4 +85,8 @@ class AngularCorrelationMessenger : public G4UImessenger {
   G4UIcmdWithAString *sourcePVCmd;
 
   G4UIcmdWith3Vector *polarizationCmd;
+
+  G4UIcmdWithAString *positionSamplerCmd;
+  G4UIcmdWithAString *samplerCmd;
+  G4UIcmdWithADouble *maxWCmd;
 };
@@ -19,10 +19,87 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 */
 #pragma once
 
+#include <cmath>
+#include <cstddef>
+#include <functional>
+
+// Closed form of an angular distribution W for a fixed spin sequence and fixed multipole
+// mixing ratios.
+//
+// All distributions in AngularDistribution::AngDist that describe gamma-ray cascades after
+// the excitation by a linearly polarized beam have the form
+//
+//   W(theta, phi) = A(cos^2(theta)) + cos(2 phi) * B(cos^2(theta)),
+//
+// where A and B are polynomials. AngularDistribution::Resolve() determines their
+// coefficients once by evaluating AngDist at a few points and verifies the result on a
+// grid of test points. If the verification fails, which is the case for the test
+// distributions, the kernel falls back to calling the original function.
+class AngularDistributionKernel {
+  public:
+  // Number of coefficients of A and B, i.e. terms up to cos^6(theta)
+  static const int n_coefficients = 4;
+
+  AngularDistributionKernel() : is_polynomial(true), a{0., 0., 0., 0.}, b{0., 0., 0., 0.}, fallback(){};
+
+  double operator()(double cos_theta, double phi) const {
+    if (is_polynomial) {
+      return Polynomial(cos_theta * cos_theta, cos(2. * phi));
+    }
+    return fallback(cos_theta, phi);
+  };
+
+  // Evaluate W for n directions in structure-of-arrays layout, given by cos(theta), cos(phi)
+  // and sin(phi). For a polynomial kernel, cos(2 phi) = cos^2(phi) - sin^2(phi) is used, so
+  // that the loop only consists of multiplications and additions and can be vectorized.
+  void Evaluate(size_t n, const double *cos_theta, const double *cos_phi, const double *sin_phi, double *w) const;
+
+  // Only valid if IsPolynomial() is true
+  double Polynomial(double cos_theta_2, double cos_two_phi) const {
+    return a[0] + cos_theta_2 * (a[1] + cos_theta_2 * (a[2] + cos_theta_2 * a[3])) +
+           cos_two_phi * (b[0] + cos_theta_2 * (b[1] + cos_theta_2 * (b[2] + cos_theta_2 * b[3])));
+  };
+
+  // Maximum of W in the interval [cos_theta_min, cos_theta_max] x [phi_min, phi_max]. For a
+  // polynomial kernel, the maximum is found analytically. Otherwise, W is evaluated on a grid
+  // of points, and the result should be multiplied by a safety factor.
+  double Maximum(double cos_theta_min = -1., double cos_theta_max = 1., double phi_min = 0., double phi_max = 2. * M_PI) const;
+
+  // Maximum of W in the given interval, multiplied by a safety factor which depends on the
+  // method that was used to find the maximum
+  double Envelope(double cos_theta_min = -1., double cos_theta_max = 1., double phi_min = 0., double phi_max = 2. * M_PI) const {
+    return Maximum(cos_theta_min, cos_theta_max, phi_min, phi_max) * (is_polynomial ? polynomial_safety_factor : grid_safety_factor);
+  };
+  static constexpr double polynomial_safety_factor = 1.001;
+  static constexpr double grid_safety_factor = 1.1;
+
+  bool IsPolynomial() const { return is_polynomial; };
+  const double *GetA() const { return a; };
+  const double *GetB() const { return b; };
+
+  private:
+  friend class AngularDistribution;
+
+  bool is_polynomial;
+  double a[n_coefficients];
+  double b[n_coefficients];
+  // W(cos(theta), phi)
+  std::function<double(double, double)> fallback;
+};
+
 class AngularDistribution {
   public:
   AngularDistribution(){};
   ~AngularDistribution(){};
 
   double AngDist(double theta, double phi, double *st, int nst, double *mix) const;
+
+  // Resolve the closed form of an arbitrary function W(cos(theta), phi)
+  AngularDistributionKernel Resolve(const std::function<double(double, double)> &w) const;
+  // Resolve the closed form of AngDist for the spin sequence st and the mixing ratios mix.
+  // The spin sequence is looked up only once, here.
+  AngularDistributionKernel Resolve(const double *st, int nst, const double *mix) const;
+  // Resolve the closed form of weight * (AngDist(st) + AngDist(alt_st)), the angular
+  // distribution after an unpolarized excitation
+  AngularDistributionKernel Resolve(const double *st, const double *alt_st, int nst, const double *mix, double weight) const;
 };
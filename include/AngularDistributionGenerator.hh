@@ -28,14 +28,32 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include <vector>
 
 #include "AngularDistribution.hh"
+#include "AngularDistributionSampler.hh"
+#include "SourceVolumeSampler.hh"
+#include "utrConfig.h"
+
+#ifdef PROFILE_GENERATORS
+#include "PrimaryGeneratorProfiler.hh"
+#endif
 
 #define CHECK_POSITION_GENERATOR 1
 #define CHECK_MOMENTUM_GENERATOR 1
-// Maximum value for the sampled w
-#define MAX_W 3.
+// Number of cos(theta) cells of the piecewise envelope (twice as many cells are used for phi)
+#define ENVELOPE_BINS 32
+// Number of candidate directions which are sampled and evaluated at once by the rejection sampler
+#define MOMENTUM_BLOCK_SIZE 32
+// Default number of cos(theta) bins of the tabulated sampler (twice as many bins are used for phi)
+#define DEFAULT_TABLE_BINS 256
 
 using std::vector;
 
+// Methods to sample the momentum direction from the angular distribution
+enum momentum_sampler : short {
+  SAMPLER_REJECTION, // Rejection sampling with the constant envelope MAX_W (default)
+  SAMPLER_ENVELOPE,  // Rejection sampling with a piecewise constant envelope over (cos(theta), phi) cells
+  SAMPLER_TABLE,     // Inverse-CDF sampling from a table which is built once per run
+};
+
 class AngularDistributionMessenger;
 
 class AngularDistributionGenerator : public G4VUserPrimaryGeneratorAction {
@@ -48,30 +66,73 @@ class AngularDistributionGenerator : public G4VUserPrimaryGeneratorAction {
   // Self-checks
   void check_position_generator();
   void check_momentum_generator();
+  void compare_momentum_samplers();
 
   // Set- and Get- methods to use with the AngularDistributionMessenger
 
-  void SetNStates(G4int nst) { nstates = nst; };
-  void SetState(G4int statenumber, G4double st) { states[statenumber] = st; };
+  void SetNStates(G4int nst) {
+    nstates = nst;
+    kernel_resolved = false;
+  };
+  void SetState(G4int statenumber, G4double st) {
+    states[statenumber] = st;
+    kernel_resolved = false;
+  };
   void SetDelta(G4int deltanumber, G4double delta) {
     mixing_ratios[deltanumber] = delta;
+    kernel_resolved = false;
   };
 
   void SetParticleEnergy(G4double en) { particleEnergy = en; };
   void SetParticleDefinition(G4ParticleDefinition *pd) {
     particleDefinition = pd;
   };
-  void SetSourceX(G4double x) { source_x = x; };
-  void SetSourceY(G4double y) { source_y = y; };
-  void SetSourceZ(G4double z) { source_z = z; };
+  void SetSourceX(G4double x) {
+    source_x = x;
+    source_sampler.Reset();
+  };
+  void SetSourceY(G4double y) {
+    source_y = y;
+    source_sampler.Reset();
+  };
+  void SetSourceZ(G4double z) {
+    source_z = z;
+    source_sampler.Reset();
+  };
+
+  void SetSourceDX(G4double dx) {
+    range_x = dx;
+    source_sampler.Reset();
+  };
+  void SetSourceDY(G4double dy) {
+    range_y = dy;
+    source_sampler.Reset();
+  };
+  void SetSourceDZ(G4double dz) {
+    range_z = dz;
+    source_sampler.Reset();
+  };
 
-  void SetSourceDX(G4double dx) { range_x = dx; };
-  void SetSourceDY(G4double dy) { range_y = dy; };
-  void SetSourceDZ(G4double dz) { range_z = dz; };
+  void AddSourcePV(G4String physvol) {
+    source_PV_names.push_back(physvol);
+    source_sampler.Reset();
+  };
 
-  void AddSourcePV(G4String physvol) { source_PV_names.push_back(physvol); };
+  void SetPolarized(G4bool pol) {
+    is_polarized = pol;
+    kernel_resolved = false;
+  };
 
-  void SetPolarized(G4bool pol) { is_polarized = pol; };
+  void SetMomentumSampler(G4String sampler_name);
+  void SetTableBins(G4int bins) { table_bins = bins; };
+  void SetPositionSampler(G4String sampler_name) {
+    position_sampler_method = (sampler_name == "solid") ? POSITION_SAMPLER_SOLID : POSITION_SAMPLER_BOX;
+    source_sampler.Reset();
+  };
+  void SetMaxW(G4double mw) {
+    max_w_user = mw;
+    kernel_resolved = false;
+  };
 
   G4ParticleDefinition *GetParticleDefinition() {
     return particleDefinition;
@@ -95,7 +156,28 @@ class AngularDistributionGenerator : public G4VUserPrimaryGeneratorAction {
 
   G4bool IsPolarized() { return is_polarized; };
 
+  G4String GetMomentumSampler();
+  G4String GetPositionSampler() { return position_sampler_method == POSITION_SAMPLER_SOLID ? "solid" : "box"; };
+  G4int GetTableBins() { return table_bins; };
+  G4double GetMaxW() { return max_w_user; };
+
   private:
+  // Value of the angular distribution for the current settings, including the average over
+  // both possible polarizations for an unpolarized excitation
+  G4double W(G4double cos_theta, G4double phi) { return kernel(cos_theta, phi); };
+  // Look up the angular distribution for the current settings. Called at the first event
+  // after the settings were changed by the messenger.
+  void resolve_kernel();
+  G4bool sample_momentum_rejection(G4ThreeVector &direction);
+  // Sample and evaluate blocks of candidate directions until at least one of them is accepted
+  void fill_momentum_buffer();
+  // Uniformly distributed point on the unit circle without trigonometric functions
+  void random_unit_circle(G4double &cos_phi, G4double &sin_phi);
+  G4bool sample_momentum_envelope(G4ThreeVector &direction);
+  void prepare_envelope_sampler();
+  void sample_momentum_table(G4ThreeVector &direction);
+  void prepare_table_sampler();
+
   G4ParticleGun *particleGun;
   AngularDistributionMessenger *angDistMessenger;
   AngularDistribution *angdist;
@@ -113,6 +195,15 @@ class AngularDistributionGenerator : public G4VUserPrimaryGeneratorAction {
   G4double alt_states[4];
   G4double mixing_ratios[3];
 
+  AngularDistributionKernel kernel;
+  G4bool kernel_resolved;
+  // Upper limit for W, which is used as the constant envelope of the rejection sampler. It is
+  // determined from the kernel, unless a positive value was given by the user.
+  G4double max_w;
+  G4double max_w_user;
+  // Directions which were accepted by the rejection sampler, but not used yet
+  vector<G4ThreeVector> accepted_directions;
+
   G4double source_x;
   G4double source_y;
   G4double source_z;
@@ -124,10 +215,26 @@ class AngularDistributionGenerator : public G4VUserPrimaryGeneratorAction {
   G4bool is_polarized;
 
   G4Navigator *navi;
+  position_sampler position_sampler_method;
+  SourceVolumeSampler source_sampler;
 
   G4double MAX_TRIES_POSITION;
   G4double MAX_TRIES_MOMENTUM;
 
   G4bool checked_position_generator;
   G4bool checked_momentum_generator;
+
+  momentum_sampler momentum_sampler_method;
+  AngularDistributionSampler sampler;
+  G4int table_bins;
+  G4int tabulated_run_id;
+  // Piecewise constant envelope, i.e. the maximum of W in each cell, and a sampler which
+  // selects the cells with a probability proportional to their envelope
+  AngularDistributionSampler envelope_sampler;
+  vector<G4double> envelope_w;
+  G4bool envelope_built;
+
+#ifdef PROFILE_GENERATORS
+  PrimaryGeneratorProfiler profiler;
+#endif
 };
@@ -70,4 +70,9 @@ class AngularDistributionMessenger : public G4UImessenger {
   G4UIcmdWithAString *sourcePVCmd;
 
   G4UIcmdWithABool *polarizationCmd;
+
+  G4UIcmdWithAString *samplerCmd;
+  G4UIcmdWithAnInteger *tableBinsCmd;
+  G4UIcmdWithAString *positionSamplerCmd;
+  G4UIcmdWithADouble *maxWCmd;
 };
@@ -0,0 +1,71 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <functional>
+#include <vector>
+
+using std::vector;
+
+// Tabulated inverse-CDF sampler for an angular distribution W(cos(theta), phi).
+//
+// W is evaluated once at the centers of an equidistant grid in (cos(theta), phi),
+// i.e. on cells which all cover the same solid angle, and cumulative tables are built
+// from the cell contents. After that, each direction is drawn with two uniform random
+// numbers: the first one selects the cos(theta) row from the marginal distribution,
+// the second one the phi cell inside this row. The position of each random number
+// inside the selected interval of the cumulative table is used to place the direction
+// uniformly inside the cell. Therefore, the sampled distribution is the histogram of W
+// on the grid, and no random number is ever rejected.
+class AngularDistributionSampler {
+public:
+  AngularDistributionSampler() : n_cos_theta(0), n_phi(0), n_negative(0){};
+  ~AngularDistributionSampler(){};
+
+  // Tabulate W(cos(theta), phi) on n_ct x n_ph cells. Negative values of W are set to zero
+  // and counted. Returns false if W vanishes everywhere on the grid.
+  bool Tabulate(const std::function<double(double, double)> &w, unsigned int n_ct, unsigned int n_ph);
+  // Build the tables from given cell contents. The content of cell (i, j), which covers the
+  // i-th cos(theta) and the j-th phi interval, is cell_weights[i * n_ph + j].
+  bool Build(const vector<double> &cell_weights, unsigned int n_ct, unsigned int n_ph);
+
+  // Map two uniform random numbers in [0, 1) to cos(theta) in [-1, 1] and phi in [0, 2 pi)
+  void Sample(double random_1, double random_2, double &cos_theta, double &phi) const {
+    size_t cell;
+    Sample(random_1, random_2, cos_theta, phi, cell);
+  };
+  // Same as above, but also return the index of the selected cell
+  void Sample(double random_1, double random_2, double &cos_theta, double &phi, size_t &cell) const;
+
+  bool IsTabulated() const { return n_cos_theta > 0; };
+  unsigned int GetNCosTheta() const { return n_cos_theta; };
+  unsigned int GetNPhi() const { return n_phi; };
+  unsigned int GetNNegative() const { return n_negative; };
+
+private:
+  unsigned int n_cos_theta;
+  unsigned int n_phi;
+  unsigned int n_negative;
+
+  // Normalized cumulative distribution of the cos(theta) rows (n_cos_theta + 1 entries)
+  vector<double> row_cdf;
+  // Normalized cumulative distributions of the phi cells in each row (n_cos_theta x (n_phi + 1) entries)
+  vector<double> cell_cdf;
+};
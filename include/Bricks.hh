@@ -36,6 +36,7 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "G4UnitsTable.hh"
 
 #include "DetectorConstruction.hh"
+#include "utrRegionTools.hh"
 
 class NormBrick {
   private:
@@ -71,6 +72,7 @@ class NormBrick {
                                             "NormBrick_Logical", 0, 0, 0);
 
     NormBrick_Logical->SetVisAttributes(new G4VisAttributes(green));
+    utrRegionTools::addLogicalVolume("shielding", NormBrick_Logical);
 
     rot = new G4RotationMatrix();
   }
@@ -137,6 +139,7 @@ class NormBrickWithHole {
         NormBrickWithHole_Solid, Pb, "NormBrickWithHole_Logical", 0, 0, 0);
 
     NormBrickWithHole_Logical->SetVisAttributes(new G4VisAttributes(green));
+    utrRegionTools::addLogicalVolume("shielding", NormBrickWithHole_Logical);
 
     rot = new G4RotationMatrix();
   }
@@ -197,6 +200,7 @@ class ShortNormBrick {
         ShortNormBrick_Solid, Pb, "ShortNormBrick_Logical", 0, 0, 0);
 
     ShortNormBrick_Logical->SetVisAttributes(new G4VisAttributes(green));
+    utrRegionTools::addLogicalVolume("shielding", ShortNormBrick_Logical);
 
     rot = new G4RotationMatrix();
   }
@@ -270,6 +274,7 @@ class ShortBrickWithHole {
 
     ShortBrickWithHole_Logical->SetVisAttributes(
         new G4VisAttributes(green));
+    utrRegionTools::addLogicalVolume("shielding", ShortBrickWithHole_Logical);
 
     rot = new G4RotationMatrix();
   }
@@ -344,6 +349,7 @@ class HalfShortBrickWithHole {
 
     HalfShortBrickWithHole_Logical->SetVisAttributes(
         new G4VisAttributes(green));
+    utrRegionTools::addLogicalVolume("shielding", HalfShortBrickWithHole_Logical);
 
     rot = new G4RotationMatrix();
   }
@@ -405,6 +411,7 @@ class ConcreteBrick {
         ConcreteBrick_Solid, Concrete, "ConcreteBrick_Logical", 0, 0, 0);
 
     ConcreteBrick_Logical->SetVisAttributes(new G4VisAttributes(white));
+    utrRegionTools::addLogicalVolume("shielding", ConcreteBrick_Logical);
 
     rot = new G4RotationMatrix();
   }
@@ -476,6 +483,7 @@ class BridgeBrick {
         BridgeBrick_Solid, Pb, "BridgeBrick_Logical", 0, 0, 0);
 
     BridgeBrick_Logical->SetVisAttributes(new G4VisAttributes(grey));
+    utrRegionTools::addLogicalVolume("shielding", BridgeBrick_Logical);
 
     rot = new G4RotationMatrix();
   }
@@ -535,6 +543,7 @@ class ThinNormBrick {
         ThinNormBrick_Solid, Pb, "ThinNormBrick_Logical", 0, 0, 0);
 
     ThinNormBrick_Logical->SetVisAttributes(new G4VisAttributes(green));
+    utrRegionTools::addLogicalVolume("shielding", ThinNormBrick_Logical);
 
     rot = new G4RotationMatrix();
   }
@@ -596,6 +605,7 @@ class ShortThinNormBrick {
 
     ShortThinNormBrick_Logical->SetVisAttributes(
         new G4VisAttributes(green));
+    utrRegionTools::addLogicalVolume("shielding", ShortThinNormBrick_Logical);
 
     rot = new G4RotationMatrix();
   }
@@ -658,6 +668,7 @@ class FlatFlatThinNormBrick {
 
     FlatFlatThinNormBrick_Logical->SetVisAttributes(
         new G4VisAttributes(green));
+    utrRegionTools::addLogicalVolume("shielding", FlatFlatThinNormBrick_Logical);
 
     rot = new G4RotationMatrix();
   }
@@ -721,6 +732,7 @@ class ThreeQuarterShortNormBrick {
 
     ThreeQuarterShortNormBrick_Logical->SetVisAttributes(
         new G4VisAttributes(green));
+    utrRegionTools::addLogicalVolume("shielding", ThreeQuarterShortNormBrick_Logical);
 
     rot = new G4RotationMatrix();
   }
@@ -783,6 +795,7 @@ class FlatConcreteBrick {
                             "FlatConcreteBrick_Logical", 0, 0, 0);
 
     FlatConcreteBrick_Logical->SetVisAttributes(new G4VisAttributes(white));
+    utrRegionTools::addLogicalVolume("shielding", FlatConcreteBrick_Logical);
 
     rot = new G4RotationMatrix();
   }
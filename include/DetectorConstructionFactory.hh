@@ -0,0 +1,89 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "G4VUserDetectorConstruction.hh"
+#include "globals.hh"
+
+#include <exception>
+#include <map>
+#include <vector>
+
+using std::map;
+using std::vector;
+
+// Registry of the geometries (DetectorConstruction classes) that are available to utr, which are selected at
+// runtime with the --geometry option by their directory 'CAMPAIGN/DETECTOR_CONSTRUCTION'.
+//
+// The geometry selected by the CAMPAIGN and DETECTOR_CONSTRUCTION build options is compiled into utr. The ones
+// listed in the GEOMETRIES build option are compiled into separate modules <build>/geometries/CAMPAIGN/
+// DETECTOR_CONSTRUCTION.so, which are loaded on request. Since all geometries use the same class name
+// DetectorConstruction, only a single module is loaded.
+// In both cases, cmake generates a static Registrar for each geometry, so the geometries themselves do not
+// need to know about the factory.
+class DetectorConstructionFactory {
+  public:
+  typedef G4VUserDetectorConstruction *(*Creator)();
+  typedef unsigned int (*MaxSensitiveDetectorIDGetter)(const G4VUserDetectorConstruction *);
+
+  static void Register(const G4String &name, Creator creator, MaxSensitiveDetectorIDGetter getter);
+  static vector<G4String> GetGeometries(); // Registered geometries and the ones in the module directory
+  static G4VUserDetectorConstruction *Create(const G4String &name); // Loads the module of the geometry if necessary
+
+  // Max_Sensitive_Detector_ID of the created geometry, needed by the EVENT_EVENTWISE and EVENT_HISTOGRAM output modes
+  static unsigned int GetMaxSensitiveDetectorID();
+
+  // Runtime parameters of the geometries, which replace build options like the TARGET of Campaign_2021/154Sm-GDR.
+  // They are set with the --geometry-parameter option of utr.
+  static void SetParameter(const G4String &name, const G4String &value) { parameters[name] = value; };
+  static G4String GetParameter(const G4String &name, const G4String &defaultValue);
+  static G4bool GetBoolParameter(const G4String &name, G4bool defaultValue);
+
+  template <typename T> class Registrar {
+    public:
+    Registrar(const G4String &name) { Register(name, create, maxSensitiveDetectorID); };
+
+    private:
+    static G4VUserDetectorConstruction *create() { return new T(); };
+    static unsigned int maxSensitiveDetectorID(const G4VUserDetectorConstruction *detectorConstruction) { return getMaxSensitiveDetectorID(static_cast<const T *>(detectorConstruction), 0); };
+
+    // Not all geometries define Max_Sensitive_Detector_ID, the first overload is preferred if it exists
+    template <typename U> static auto getMaxSensitiveDetectorID(const U *detectorConstruction, int) -> decltype((unsigned int)detectorConstruction->Max_Sensitive_Detector_ID) { return (unsigned int)detectorConstruction->Max_Sensitive_Detector_ID; };
+    template <typename U> static unsigned int getMaxSensitiveDetectorID(const U *, long) {
+      G4cerr << "ERROR: The DetectorConstruction does not define Max_Sensitive_Detector_ID, which is needed by the EVENT_EVENTWISE and EVENT_HISTOGRAM output modes. Aborting..." << G4endl;
+      throw std::exception();
+    };
+  };
+
+  private:
+  struct Entry {
+    Creator creator;
+    MaxSensitiveDetectorIDGetter getter;
+  };
+
+  // Function-local static, since the Registrars of the geometry compiled into utr are constructed during static initialization
+  static map<G4String, Entry> &registry();
+  static G4bool loadModule(const G4String &name);
+  static G4String moduleDirectory();
+
+  static map<G4String, G4String> parameters;
+  static const Entry *createdEntry;
+  static const G4VUserDetectorConstruction *createdDetectorConstruction;
+};
@@ -19,15 +19,25 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 */
 #pragma once
 
+#include "G4ThreeVector.hh"
 #include "G4VSensitiveDetector.hh"
 
 #include "TargetHit.hh"
 
+#include "utrConfig.h"
+
 #include <vector>
 
 class G4Step;
 class G4HCofThisEvent;
 
+// Type of the energy depositions in the EVENT_EVENTWISE_SPARSE output
+#ifdef EVENT_FLOAT_COLUMNS
+typedef G4float sparse_edep_type;
+#else
+typedef G4double sparse_edep_type;
+#endif
+
 class EnergyDepositionSD : public G4VSensitiveDetector {
   public:
   EnergyDepositionSD(const G4String &name,
@@ -41,9 +51,32 @@ class EnergyDepositionSD : public G4VSensitiveDetector {
   unsigned int GetDetectorID() { return detectorID; };
   void SetDetectorID(unsigned int detID) { detectorID = detID; };
   static std::vector<bool> anyDetectorHitInEvent; // Needed for EVENT_EVENTWISE mode, signals whether an entry (row) needs to be written to the root file for the current event (or whether the row would be zeroes only)
+  // Needed for EVENT_EVENTWISE_SPARSE mode: IDs and total energy depositions of the detectors that were hit in the current event of this thread.
+  // They are bound to the vector columns of the ntuple in RunAction::BeginOfRunAction, and EventAction::EndOfEventAction writes and clears them.
+  static std::vector<G4int> &GetHitDetectorIDs();
+  static std::vector<sparse_edep_type> &GetHitEnergyDepositions();
 
   private:
+#ifdef EDEP_HITS_COLLECTION
   TargetHitsCollection *hitsCollection;
+#endif
   G4int detectorID;
   G4int eventID;
+
+  // Running sum of the energy depositions of the particles with the same statistical weight in the current
+  // event, and the quantities of their first hit. With FORCED_INTERACTION, the uncollided and the interacting
+  // copy of a photon have different weights, and their depositions must not be recorded with a common weight.
+  // Otherwise, all particles of an event usually have the same weight, and there is only one entry.
+  struct WeightedDeposition {
+    G4double weight;
+    G4double energyDeposition;
+    G4double kineticEnergy;
+    G4int particleType;
+    G4ThreeVector position;
+    G4ThreeVector momentum;
+  };
+  std::vector<WeightedDeposition> depositions;
+
+  static G4ThreadLocal std::vector<G4int> *hitDetectorIDs;
+  static G4ThreadLocal std::vector<sparse_edep_type> *hitEnergyDepositions;
 };
@@ -22,6 +22,12 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "G4GeneralParticleSource.hh"
 #include "G4VUserPrimaryGeneratorAction.hh"
 
+#include "utrConfig.h"
+
+#ifdef PROFILE_GENERATORS
+#include "PrimaryGeneratorProfiler.hh"
+#endif
+
 class GeneralParticleSource : public G4VUserPrimaryGeneratorAction {
   public:
   GeneralParticleSource();
@@ -31,4 +37,8 @@ class GeneralParticleSource : public G4VUserPrimaryGeneratorAction {
 
   private:
   G4GeneralParticleSource *particleGun;
+
+#ifdef PROFILE_GENERATORS
+  PrimaryGeneratorProfiler profiler;
+#endif
 };
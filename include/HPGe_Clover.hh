@@ -30,7 +30,7 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 
 class HPGe_Clover : public Detector {
   public:
-  HPGe_Clover(G4LogicalVolume *World_Logical, G4String name) : Detector(World_Logical, name), use_dewar(false){};
+  HPGe_Clover(G4LogicalVolume *World_Logical, G4String name) : Detector(World_Logical, name), use_dewar(false), use_subtraction_crystals(false){};
   ~HPGe_Clover(){};
 
   void Construct(G4ThreeVector global_coordinates, G4double theta, G4double phi, G4double dist_from_center, G4double intrinsic_rotation_angle) const override;
@@ -38,9 +38,19 @@ class HPGe_Clover : public Detector {
   void Construct(G4ThreeVector global_coordinates, G4double theta, G4double phi, G4double dist_from_center) const override;
   void setProperties(HPGe_Clover_Properties &prop) { properties = prop; };
   void useDewar() { use_dewar = true; };
+  // Construct the crystals with crystal_solid_subtraction instead of crystal_solid
+  void useSubtractionCrystals() { use_subtraction_crystals = true; };
+
+  // Solid of a single crystal: A cylinder with the anode hole at the back (a single G4Polycone) which is
+  // flattened on all four sides by the intersection with a box.
+  G4VSolid *crystal_solid() const;
+  // Equivalent solid of a single crystal, which is constructed by subtracting the anode hole and four boxes from
+  // a cylinder. The chain of five G4SubtractionSolids is much slower to navigate than crystal_solid.
+  G4VSolid *crystal_solid_subtraction() const;
 
   private:
   HPGe_Clover_Properties properties;
   bool use_dewar;
+  bool use_subtraction_crystals;
   G4VSolid *rounded_box(const G4String name, const G4double side_length, const G4double length, const G4double rounding_radius, const G4int n_points_per_corner) const;
 };
@@ -0,0 +1,84 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "globals.hh"
+
+// Binary format of the phase-space files, which are written by PhaseSpaceSD at the end of a run and
+// read by the PhaseSpaceGenerator. A file consists of a PhaseSpaceHeader, followed by n_records
+// PhaseSpaceRecords without any padding. The numbers are stored in the byte order of the machine that
+// wrote the file.
+
+#define PHASESPACE_MAGIC "UTRPHSP1"
+#define PHASESPACE_VERSION 1
+
+struct PhaseSpaceHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint64_t n_records;
+  // Number of events of the run that wrote the file, which is needed to normalize a simulation
+  // that replays the file
+  uint64_t n_primaries;
+};
+
+// Lengths in mm, energies in MeV
+struct PhaseSpaceRecord {
+  int32_t particle; // PDG encoding
+  float position[3];
+  float direction[3];
+  float kinetic_energy;
+  float polarization[3];
+  float weight;
+};
+
+static_assert(sizeof(PhaseSpaceHeader) == 32, "Unexpected padding in PhaseSpaceHeader");
+static_assert(sizeof(PhaseSpaceRecord) == 48, "Unexpected padding in PhaseSpaceRecord");
+
+// Read-only view of a phase-space file, which is mapped into memory. Several instances can map the
+// same file, so each thread of the PhaseSpaceGenerator reads the file independently. The operating
+// system shares the pages between them.
+class PhaseSpaceFile {
+  public:
+  PhaseSpaceFile();
+  ~PhaseSpaceFile();
+
+  // Map the given file into memory and check its header. Aborts if the file is not a valid
+  // phase-space file.
+  void Open(const G4String &filename);
+  void Close();
+
+  bool IsOpen() const { return data != nullptr; };
+  const G4String &GetFilename() const { return filename; };
+  uint64_t GetNumberOfRecords() const { return header->n_records; };
+  uint64_t GetNumberOfPrimaries() const { return header->n_primaries; };
+  const PhaseSpaceRecord &GetRecord(uint64_t index) const { return records[index]; };
+
+  private:
+  G4String filename;
+  void *data;
+  size_t size;
+  const PhaseSpaceHeader *header;
+  const PhaseSpaceRecord *records;
+};
@@ -0,0 +1,56 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "G4VUserPrimaryGeneratorAction.hh"
+
+#include "PhaseSpace.hh"
+
+#include "utrConfig.h"
+
+#ifdef PROFILE_GENERATORS
+#include "PrimaryGeneratorProfiler.hh"
+#endif
+
+class G4ParticleDefinition;
+
+// Replays a phase-space file written by PhaseSpaceSD (see utrPhaseSpaceTools). Each event contains a
+// single particle of the file. The instance of each thread maps the file itself. With sequential access,
+// the threads share the position in the file (see utrPhaseSpaceTools::nextSequentialUse).
+class PhaseSpaceGenerator : public G4VUserPrimaryGeneratorAction {
+  public:
+  PhaseSpaceGenerator();
+  ~PhaseSpaceGenerator();
+
+  void GeneratePrimaries(G4Event *anEvent);
+
+  private:
+  // Map the file of /utr/phaseSpace/replay, if it has not been mapped yet or was changed
+  void open();
+  uint64_t nextIndex();
+  G4ParticleDefinition *findParticle(G4int pdg);
+
+  PhaseSpaceFile file;
+
+#ifdef PROFILE_GENERATORS
+  PrimaryGeneratorProfiler profiler;
+#endif
+};
@@ -0,0 +1,35 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "ParticleSD.hh"
+
+// Records each particle that enters the sensitive detector in the phase-space file of
+// utrPhaseSpaceTools, if /utr/phaseSpace/record is set. The sensitive detector should be a thin
+// volume of vacuum or air, which defines the plane between the two stages of a simulation.
+// Without a phase-space file, it does nothing, so the geometry of both stages can be the same.
+class PhaseSpaceSD : public ParticleSD {
+  public:
+  PhaseSpaceSD(const G4String &name, const G4String &hitsCollectionName);
+  virtual ~PhaseSpaceSD();
+
+  virtual G4bool ProcessHits(G4Step *step, G4TouchableHistory *history);
+};
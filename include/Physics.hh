@@ -27,4 +27,8 @@ class Physics : public G4VModularPhysicsList {
 
   public:
   Physics();
+
+  // Apply the production cuts and EM physics of the regions of the geometry (see utrRegionTools)
+  void ConstructProcess() override;
+  void SetCuts() override;
 };
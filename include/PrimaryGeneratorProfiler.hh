@@ -0,0 +1,130 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "globals.hh"
+
+// Number of bins of the histograms of trials per event. Events with more trials are
+// counted in the last bin.
+#define PROFILE_MAX_TRIALS 1024
+
+using std::vector;
+
+// Counters of the primary generator, which are accumulated for each thread in its Run and
+// merged at the end of the run
+class PrimaryGeneratorProfile {
+  public:
+  PrimaryGeneratorProfile();
+
+  // The totals count the trials when they were made. The distributions of the trials per event use
+  // the trials attributed to the samples that the event consumed (see PrimaryGeneratorProfiler).
+  void AddEvent(G4long n_primaries, G4long n_position_trials, G4long n_positions, G4long n_momentum_trials, G4long n_momenta, G4long n_w_evaluations, G4long t_ns, G4long attributed_position_trials, G4long attributed_momentum_trials);
+  void Merge(const PrimaryGeneratorProfile &profile);
+  // Print a summary table. The generation time is compared to the given time that all
+  // threads spent in the run.
+  void Print(G4double thread_time_ns) const;
+
+  private:
+  // Smallest number of trials per event, so that the given fraction of all events needed
+  // at most this number of trials
+  static G4long percentile(const vector<G4long> &histogram, G4double fraction);
+
+  G4long events;
+  G4long primaries;
+  G4long position_trials;
+  G4long positions;
+  G4long momentum_trials;
+  G4long momenta;
+  G4long w_evaluations;
+  G4long time_ns;
+
+  G4long max_position_trials;
+  G4long max_momentum_trials;
+  vector<G4long> position_trials_per_event;
+  vector<G4long> momentum_trials_per_event;
+};
+
+// Helper of the primary generators, which counts the trials and measures the time of
+// a single event and adds them to the profile of the current run.
+// Samples from a pool or buffer are generated in blocks by whichever event finds it empty. To
+// keep these refills out of the distributions of the trials per event, each consumed sample is
+// attributed the mean number of trials per accepted sample of the refill that produced it.
+class PrimaryGeneratorProfiler {
+  public:
+  PrimaryGeneratorProfiler() : position_trials(0), positions(0), momentum_trials(0), momenta(0), w_evaluations(0), attributed_position_trials(0.), attributed_momentum_trials(0.), position_cost(0.){};
+
+  void BeginEvent() {
+    position_trials = 0;
+    positions = 0;
+    momentum_trials = 0;
+    momenta = 0;
+    w_evaluations = 0;
+    attributed_position_trials = 0.;
+    attributed_momentum_trials = 0.;
+    start = std::chrono::steady_clock::now();
+  };
+  // Trials and accepted positions of the position sampler since the previous call, for one
+  // consumed position. Both are zero if the position was taken from the pool of a previous refill.
+  void CountPositionTrials(G4long trials, G4long accepted) {
+    position_trials += trials;
+    positions += accepted;
+    if (accepted > 0) {
+      position_cost = (G4double)trials / (G4double)accepted;
+      attributed_position_trials += position_cost;
+    } else if (trials > 0) {
+      attributed_position_trials += (G4double)trials;
+    } else {
+      attributed_position_trials += position_cost;
+    }
+  };
+  // Trials of a sampler without a buffer for a single sample
+  void CountMomentumTrials(G4long trials, G4long accepted) {
+    momentum_trials += trials;
+    momenta += accepted;
+    attributed_momentum_trials += (G4double)trials;
+  };
+  // Trials of a block that refills the momentum buffer with the given index. The buffer was
+  // empty before the first block of a refill.
+  void CountBufferedMomentumTrials(size_t buffer, G4long trials, G4long accepted);
+  // A sample taken from the momentum buffer with the given index, or a failed attempt to refill it
+  void CountBufferedMomentum(size_t buffer, bool found);
+  void CountWEvaluations(G4long n) { w_evaluations += n; };
+  void EndEvent(G4long n_primaries);
+
+  private:
+  std::chrono::steady_clock::time_point start;
+  G4long position_trials;
+  G4long positions;
+  G4long momentum_trials;
+  G4long momenta;
+  G4long w_evaluations;
+
+  G4double attributed_position_trials;
+  G4double attributed_momentum_trials;
+  // Trials per accepted sample of the last refill of the position pool and of each momentum buffer
+  G4double position_cost;
+  vector<G4double> momentum_cost;
+  // Trials of the blocks of a momentum buffer refill which have not been accepted yet
+  vector<G4long> pending_momentum_trials;
+};
@@ -0,0 +1,64 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+
+#include "G4Run.hh"
+
+#include "PrimaryGeneratorProfiler.hh"
+#include "StackingAction.hh"
+#include "SteppingAction.hh"
+#include "utrBiasingTools.hh"
+
+// Run with additional information which is accumulated by each thread and merged by the
+// master thread at the end of the run
+class Run : public G4Run {
+  public:
+  Run();
+  ~Run(){};
+
+  void Merge(const G4Run *run);
+
+  PrimaryGeneratorProfile &GetGeneratorProfile() { return generator_profile; };
+  const PrimaryGeneratorProfile &GetGeneratorProfile() const { return generator_profile; };
+  StackingProfile &GetStackingProfile() { return stacking_profile; };
+  const StackingProfile &GetStackingProfile() const { return stacking_profile; };
+  EscapeCullingProfile &GetEscapeCullingProfile() { return escape_culling_profile; };
+  const EscapeCullingProfile &GetEscapeCullingProfile() const { return escape_culling_profile; };
+  WeightTally &GetWeightTally() { return weight_tally; };
+  const WeightTally &GetWeightTally() const { return weight_tally; };
+  // Time that all threads spent in this run
+  G4double GetThreadTime() const;
+
+  private:
+  // Time since the creation of this run in nanoseconds
+  G4double elapsed_time() const;
+
+  std::chrono::steady_clock::time_point start;
+  // Sum of the times that the worker threads spent in the run, filled by Merge()
+  G4double worker_time_ns;
+
+  PrimaryGeneratorProfile generator_profile;
+  StackingProfile stacking_profile;
+  EscapeCullingProfile escape_culling_profile;
+  WeightTally weight_tally;
+};
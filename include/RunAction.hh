@@ -22,6 +22,8 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "G4UserRunAction.hh"
 #include "globals.hh"
 
+#include "utrConfig.h"
+
 #include <string>
 
 using std::string;
@@ -38,7 +40,8 @@ enum output_flags : short {
   MOMX = 8,
   MOMY = 9,
   MOMZ = 10,
-  NFLAGS = 11
+  WEIGHT = 11,
+  NFLAGS = 12
 };
 
 class RunAction : public G4UserRunAction {
@@ -46,8 +49,22 @@ class RunAction : public G4UserRunAction {
   RunAction();
   virtual ~RunAction();
 
+  virtual G4Run *GenerateRun();
   virtual void BeginOfRunAction(const G4Run *);
   virtual void EndOfRunAction(const G4Run *);
 
-  G4String GetOutputFlagName(unsigned int n);
+  static G4String GetOutputFlagName(unsigned int n);
+
+  // Create and fill columns of the output ntuple with the type selected by the
+  // EVENT_INT_COLUMNS and EVENT_FLOAT_COLUMNS build options (double by default)
+  static G4int CreateIntColumn(const G4String &name);
+  static G4int CreateRealColumn(const G4String &name);
+  static void FillIntColumn(G4int column, G4int value);
+  static void FillRealColumn(G4int column, G4double value);
+  // Add the filled row to the ntuple of the current scan point (see utrScanTools), which is the only ntuple outside of a scan
+  static void AddNtupleRow();
+
+  private:
+  static G4ThreadLocal G4int firstNtupleID;
+  static G4ThreadLocal G4int ntupleID;
 };
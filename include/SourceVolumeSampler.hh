@@ -0,0 +1,121 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "G4Navigator.hh"
+#include "G4ThreeVector.hh"
+#include "G4Transform3D.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+
+#include <vector>
+
+// Number of accepted source positions which are sampled at once
+#define POSITION_POOL_SIZE 1024
+
+using std::vector;
+
+// Methods to sample the position of a primary particle inside the source volumes
+enum position_sampler : short {
+  POSITION_SAMPLER_BOX,   // Uniform sampling in the container box and navigator lookups (default)
+  POSITION_SAMPLER_SOLID, // Uniform sampling inside the solids of the source volumes
+};
+
+// Samples uniformly distributed positions inside a set of physical volumes, restricted
+// to a box in the global coordinate system.
+//
+// The physical volumes are identified by their names once, at initialization. After
+// that, a sampled point is accepted by comparing pointers instead of strings. Accepted
+// points are sampled in blocks of POSITION_POOL_SIZE and handed out one by one, so that
+// the pool is only refilled when it is exhausted. Every point is used only once.
+//
+// In the POSITION_SAMPLER_BOX mode, random points in the container box are located with a
+// private navigator. In the POSITION_SAMPLER_SOLID mode, the placements of the source
+// volumes are found in the geometry tree, and the points are sampled inside the bounding
+// box of each solid and tested with G4VSolid::Inside(), excluding the daughter volumes.
+// A placement is selected with a probability proportional to the volume of its bounding
+// box, so that the positions are distributed uniformly in the union of all source volumes.
+// Replicated or parameterised source volumes are not supported by this mode, and the
+// sampler falls back to the POSITION_SAMPLER_BOX mode.
+class SourceVolumeSampler {
+  public:
+  SourceVolumeSampler();
+  ~SourceVolumeSampler();
+
+  // Find the source volumes in the current geometry. Must be called again if any of
+  // the parameters change.
+  void Initialize(const vector<G4String> &pv_names, G4ThreeVector box_center, G4ThreeVector box_size, position_sampler method, G4int max_t);
+
+  // Get the next position from the pool. Returns false if no position inside the source
+  // volumes could be found in MAX_TRIES attempts.
+  G4bool Sample(G4ThreeVector &position);
+
+  G4bool IsInitialized() const { return initialized; };
+  void Reset() { initialized = false; };
+
+  position_sampler GetMethod() const { return sampler_method; };
+  // Total numbers of sampled and accepted points
+  G4long GetNTrials() const { return n_trials; };
+  G4long GetNAccepted() const { return n_accepted; };
+
+  private:
+  struct Placement {
+    const G4VPhysicalVolume *pv;
+    G4VSolid *solid;
+    // Transformation from the local coordinate system of the solid to the global one
+    G4Transform3D local_to_global;
+    G4ThreeVector bounding_min;
+    G4ThreeVector bounding_max;
+    // Solids of the daughter volumes and the transformations from the local coordinate
+    // system of the solid to the ones of the daughters
+    vector<G4VSolid *> daughter_solids;
+    vector<G4Transform3D> local_to_daughter;
+  };
+
+  G4bool fill_pool();
+  G4bool sample_box(G4ThreeVector &position);
+  G4bool sample_solid(G4ThreeVector &position);
+  G4bool inside_box(const G4ThreeVector &position) const;
+  G4bool is_source(const G4VPhysicalVolume *pv) const;
+  // Find all placements of the source volumes below the given physical volume. Returns
+  // false if a source volume is replicated or has replicated daughters.
+  G4bool find_placements(const G4VPhysicalVolume *mother, const G4Transform3D &mother_to_global);
+
+  G4bool initialized;
+  position_sampler sampler_method;
+  G4int max_tries;
+
+  G4ThreeVector box_min;
+  G4ThreeVector box_max;
+
+  G4Navigator *navigator;
+  vector<const G4VPhysicalVolume *> source_pvs;
+
+  vector<Placement> placements;
+  // Cumulative bounding-box volumes of the placements
+  vector<G4double> placement_cdf;
+
+  vector<G4ThreeVector> pool;
+  size_t pool_position;
+
+  G4long n_trials;
+  G4long n_accepted;
+};
@@ -0,0 +1,87 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+
+#include "G4Navigator.hh"
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+using std::vector;
+
+// Rule of the StackingAction. A new secondary track is killed if it fulfills all conditions of
+// a rule. Empty strings and a max_energy <= 0 mean that the condition is not used.
+struct StackingRule {
+  G4String particle;    // Name of the particle
+  G4String volume;      // Name of the logical volume in which the track was created
+  G4String region;      // Name of the region in which the track was created (see utrRegionTools)
+  G4double max_energy;  // Kill only tracks with a lower kinetic energy
+  G4bool unreachable;   // Kill only tracks that cannot reach a sensitive detector
+  G4String description; // Description for the output, like the arguments of the macro command
+};
+
+// Counters of the StackingAction, which are accumulated for each thread in its Run and merged
+// at the end of the run
+class StackingProfile {
+  public:
+  StackingProfile();
+
+  void AddSecondary() { ++secondaries; };
+  void AddKill(size_t rule, G4double kinetic_energy);
+  void Merge(const StackingProfile &profile);
+  // Print the number of killed tracks and their kinetic energy for each rule. The given time
+  // that all threads spent in the run is printed for comparison with runs without the rules.
+  void Print(G4double thread_time_ns) const;
+
+  private:
+  G4long secondaries;
+  vector<G4long> kills;
+  vector<G4double> killed_energy;
+};
+
+// Stacking action that kills secondary tracks which are irrelevant for the sensitive detectors,
+// to save the time to track them. The rules are set with the /utr/stacking/ commands.
+// Primary particles are never killed.
+class StackingAction : public G4UserStackingAction {
+  public:
+  StackingAction();
+  virtual ~StackingAction();
+
+  virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track *track);
+  virtual void PrepareNewEvent();
+
+  static void AddRule(const StackingRule &rule) { rules.push_back(rule); };
+  static void ClearRules() { rules.clear(); };
+  static const vector<StackingRule> &GetRules() { return rules; };
+
+  private:
+  G4bool Matches(const StackingRule &rule, const G4Track *track);
+  // True if the track is charged, was not created in a sensitive detector, and its range is shorter than
+  // the distance to the closest boundary. The track is located with an own navigator, since the
+  // navigator for tracking must not be moved while the parent track is stepping.
+  G4bool CannotReachSensitiveDetector(const G4Track *track);
+
+  G4Navigator *navigator;
+  StackingProfile *profile;
+
+  // The rules are set between runs and are shared by the StackingActions of all threads
+  static vector<StackingRule> rules;
+};
@@ -0,0 +1,107 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <chrono>
+
+#include "G4Transform3D.hh"
+#include "G4UserSteppingAction.hh"
+#include "G4VPhysicalVolume.hh"
+#include "globals.hh"
+
+// Counters of the escape culling, which are accumulated for each thread in its Run and merged
+// at the end of the run
+class EscapeCullingProfile {
+  public:
+  EscapeCullingProfile() : bounding_radius(0.), culled_tracks(0), sampled_tracks(0), sampled_steps(0), sampled_time_ns(0.){};
+
+  void SetBoundingRadius(G4double radius) { bounding_radius = radius; };
+  void AddCulledTrack() { ++culled_tracks; };
+  void AddSampledTrack() { ++sampled_tracks; };
+  void AddSampledStep(G4double t_ns) {
+    ++sampled_steps;
+    sampled_time_ns += t_ns;
+  };
+  void Merge(const EscapeCullingProfile &profile);
+  // Print the number of culled tracks and an estimate of the saved steps and time, which is
+  // extrapolated from the sampled tracks. The estimate is compared to the given time that all
+  // threads spent in the run.
+  void Print(G4double thread_time_ns) const;
+
+  private:
+  G4double bounding_radius;
+  G4long culled_tracks;
+  G4long sampled_tracks;
+  G4long sampled_steps;
+  G4double sampled_time_ns;
+};
+
+// Stepping action that kills tracks which have left the bounding sphere of all sensitive
+// detectors on an outgoing trajectory. The sphere is centered at the origin, where the targets
+// are placed. Without a magnetic field, such a track can only reach a sensitive detector again
+// after it has been scattered back by the material outside of the sphere, for example the walls
+// of the room.
+//
+// Every sample_every-th escaping track is not killed, but followed like without the culling, to
+// estimate the number of steps and the time that the culling saved. The sampled tracks must not
+// change the output, so their secondaries are killed, and they are killed themselves when they
+// enter a sensitive volume. The output is then the same as with the culling of all tracks.
+class SteppingAction : public G4UserSteppingAction {
+  public:
+  SteppingAction();
+  virtual ~SteppingAction(){};
+
+  virtual void UserSteppingAction(const G4Step *step);
+
+  static void SetRoomScatter(G4bool rs) { room_scatter = rs; };
+  static G4bool GetRoomScatter() { return room_scatter; };
+  static void SetMargin(G4double m) { margin = m; };
+  static G4double GetMargin() { return margin; };
+  static void SetSampleEvery(G4int n) { sample_every = n; };
+  static G4int GetSampleEvery() { return sample_every; };
+
+  private:
+  // The sensitive detectors are only known by the worker threads, so each thread finds the
+  // radius in its copy of the geometry at its first step
+  void ComputeBoundingRadius();
+  // Extend the bounding radius by the sensitive volumes below the given one. Returns false
+  // if there are none.
+  G4bool ExtendBoundingRadius(const G4VPhysicalVolume *physical, const G4Transform3D &local_to_global);
+  void ExtendBoundingRadius(const G4VSolid *solid, const G4Transform3D &local_to_global);
+  // Sensitive volumes that define the bounding sphere. PhaseSpaceSD volumes only count while a
+  // phase-space file is recorded.
+  static G4bool IsSensitive(const G4LogicalVolume *logical);
+  // Kill the secondaries of a step of the sampled track, and the track itself if it enters a sensitive volume
+  static void SuppressSampledOutput(const G4Step *step);
+  static G4bool ContainsSensitiveDetector(const G4LogicalVolume *logical);
+
+  G4double bounding_radius;
+  G4long escaping_tracks;
+
+  // Track which is followed to estimate the saved steps and time
+  G4int sampled_track_id;
+  G4int sampled_step_number;
+  std::chrono::steady_clock::time_point sampled_step_time;
+
+  // Set with the /utr/cull/ commands, common to all threads
+  static G4bool room_scatter;
+  static G4double margin;
+  static G4int sample_every;
+};
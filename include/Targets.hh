@@ -32,6 +32,8 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "G4Material.hh"
 #include "G4NistManager.hh"
 #include "Materials.hh"
+#include "utrBiasingTools.hh"
+#include "utrRegionTools.hh"
 
 #include "G4SystemOfUnits.hh"
 #include "G4UnitsTable.hh"
@@ -142,6 +144,7 @@ class Cr54_Target {
     Cr54_Target_Logical =
         new G4LogicalVolume(Cr54_Target_Solid, air, "Cr54_Target_Logical");
     Cr54_Target_Logical->SetVisAttributes(G4VisAttributes::GetInvisible());
+    utrRegionTools::addLogicalVolume("target", Cr54_Target_Logical);
 
     // Target Container
 
@@ -176,6 +179,7 @@ class Cr54_Target {
     G4LogicalVolume *Cr54_Logical = new G4LogicalVolume(
         Cr54_Solid, mat->Get_target_Cr54_2O3(), "Cr54_Logical");
     Cr54_Logical->SetVisAttributes(new G4VisAttributes(yellow));
+    utrBiasingTools::addTargetVolume(Cr54_Logical);
 
     new G4PVPlacement(
         0,
@@ -229,6 +233,7 @@ class Se82_Target {
     Se82_Target_Logical =
         new G4LogicalVolume(Se82_Target_Solid, air, "Se82_Target_Logical");
     Se82_Target_Logical->SetVisAttributes(G4VisAttributes::GetInvisible());
+    utrRegionTools::addLogicalVolume("target", Se82_Target_Logical);
 
     // Target Container
 
@@ -263,6 +268,7 @@ class Se82_Target {
     G4LogicalVolume *Se82_Logical = new G4LogicalVolume(
         Se82_Solid, mat->Get_target_Se(), "Se82_Logical");
     Se82_Logical->SetVisAttributes(new G4VisAttributes(yellow));
+    utrBiasingTools::addTargetVolume(Se82_Logical);
 
     new G4PVPlacement(
         0,
@@ -320,6 +326,7 @@ class Nd150_Target {
     Nd150_Target_Logical =
         new G4LogicalVolume(Nd150_Target_Solid, air, "Nd150_Target_Logical");
     Nd150_Target_Logical->SetVisAttributes(G4VisAttributes::GetInvisible());
+    utrRegionTools::addLogicalVolume("target", Nd150_Target_Logical);
 
     // Target Container Barrel
 
@@ -365,6 +372,7 @@ class Nd150_Target {
     G4LogicalVolume *Nd150_Logical = new G4LogicalVolume(
         Nd150_Solid, mat->Get_target_Nd150(), "Nd150_Logical");
     Nd150_Logical->SetVisAttributes(new G4VisAttributes(yellow));
+    utrBiasingTools::addTargetVolume(Nd150_Logical);
 
     new G4PVPlacement(
         0, G4ThreeVector(), Nd150_Logical, "Nd150_Target", Nd150_Target_Logical, false, 0);
@@ -413,6 +421,7 @@ class Sm152_Target {
     Sm152_Target_Logical =
         new G4LogicalVolume(Sm152_Target_Solid, air, "Sm152_Target_Logical");
     Sm152_Target_Logical->SetVisAttributes(G4VisAttributes::GetInvisible());
+    utrRegionTools::addLogicalVolume("target", Sm152_Target_Logical);
 
     // Target Container
 
@@ -447,6 +456,7 @@ class Sm152_Target {
     G4LogicalVolume *Sm152_Logical = new G4LogicalVolume(
         Sm152_Solid, mat->Get_target_Sm152(), "Sm152_Logical");
     Sm152_Logical->SetVisAttributes(new G4VisAttributes(yellow));
+    utrBiasingTools::addTargetVolume(Sm152_Logical);
 
     new G4PVPlacement(
         0,
@@ -498,6 +508,7 @@ class Dy164_Target {
     Dy164_Target_Logical = new G4LogicalVolume(Dy164_Target_Solid, air,
                                                "Dy164_Target_Logical");
     Dy164_Target_Logical->SetVisAttributes(G4VisAttributes::GetInvisible());
+    utrRegionTools::addLogicalVolume("target", Dy164_Target_Logical);
 
     // Dy164 metallic Target
     G4Tubs *Dy164_Solid =
@@ -507,6 +518,7 @@ class Dy164_Target {
     G4LogicalVolume *Dy164_Logical = new G4LogicalVolume(
         Dy164_Solid, mat->Get_target_Dy164(), "Dy164_Logical");
     Dy164_Logical->SetVisAttributes(new G4VisAttributes(yellow));
+    utrBiasingTools::addTargetVolume(Dy164_Logical);
 
     new G4PVPlacement(
         0,
@@ -560,6 +572,7 @@ class Dy164_2O3_Target {
         Dy164_2O3_Target_Solid, air, "Dy164_2O3_Target_Logical");
     Dy164_2O3_Target_Logical->SetVisAttributes(
         G4VisAttributes::GetInvisible());
+    utrRegionTools::addLogicalVolume("target", Dy164_2O3_Target_Logical);
 
     // Target Container
 
@@ -594,6 +607,7 @@ class Dy164_2O3_Target {
     G4LogicalVolume *Dy164_2O3_Logical = new G4LogicalVolume(
         Dy164_2O3_Solid, mat->Get_target_Dy164_2O3(), "Dy164_2O3_Logical");
     Dy164_2O3_Logical->SetVisAttributes(new G4VisAttributes(yellow));
+    utrBiasingTools::addTargetVolume(Dy164_2O3_Logical);
 
     new G4PVPlacement(
         0,
@@ -0,0 +1,94 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <set>
+
+#include "G4LogicalVolume.hh"
+#include "G4Types.hh"
+#include "globals.hh"
+
+class G4BOptrForceCollision;
+
+// Statistical weights of the detector hits, which are accumulated for each thread in its Run and
+// merged at the end of the run
+class WeightTally {
+  public:
+  WeightTally() : hits(0), sum_of_weights(0.), sum_of_squared_weights(0.){};
+
+  void Add(G4double weight) {
+    ++hits;
+    sum_of_weights += weight;
+    sum_of_squared_weights += weight * weight;
+  };
+  void Merge(const WeightTally &tally);
+  // Print the relative statistical error of the weighted number of hits and the figure of merit
+  // 1/(relative error^2 * time), i.e. the inverse of the time needed for a relative error of 1, for
+  // the given time that all threads spent in the run.
+  void Print(G4double thread_time_ns) const;
+
+  private:
+  G4long hits;
+  G4double sum_of_weights;
+  G4double sum_of_squared_weights;
+};
+
+// Tools for the FORCED_INTERACTION build option, which uses Geant4's generic biasing to force photons
+// to undergo a Compton scattering, Rayleigh scattering or photoabsorption in each target-material volume
+// that they enter.
+// The target-material volumes are registered by the geometry with addTargetVolume(). Unlike the 'target'
+// region of utrRegionTools, which usually starts at an air envelope, they exclude the envelopes and the
+// containers, in which a forced interaction would only cost time.
+// The photon is split into an uncollided copy, whose weight is the probability to traverse the volume
+// without an interaction, and a copy that interacts in the volume with the complementary weight.
+// The weights are inherited by the secondaries and recorded with the energy depositions in the
+// sensitive detectors.
+class utrBiasingTools {
+  public:
+  utrBiasingTools();
+  virtual ~utrBiasingTools();
+
+  static void setForcedInteraction(bool force) { forcedInteraction = force; };
+  static bool getForcedInteraction() { return forcedInteraction; };
+  static void setAnalogFigureOfMerit(G4double fom) { analogFigureOfMerit = fom; };
+  static G4double getAnalogFigureOfMerit() { return analogFigureOfMerit; };
+
+  // Called by the DetectorConstruction for the logical volumes that consist of the target material.
+  // The operator also applies to the daughters of the same material, like the irradiated part of a target.
+  static void addTargetVolume(G4LogicalVolume *logical) { targetVolumes.insert(logical); };
+
+  // Called by Physics::ConstructProcess in each thread, after the geometry has been constructed.
+  // The biasing operators are thread-local, so every thread attaches its own one to the volumes.
+  static void attachOperators();
+  // Called in EnergyDepositionSD::EndOfEvent for each detector with a nonzero energy deposition. The
+  // particles recorded by a ParticleSD, SecondarySD or PhaseSpaceSD are not hits in this sense.
+  static void addHit(G4double weight);
+
+  private:
+  static void attachOperator(G4LogicalVolume *logical, std::set<G4LogicalVolume *> &attached);
+
+  // The settings are shared by all threads and can only be changed before the initialization
+  static bool forcedInteraction;
+  static G4double analogFigureOfMerit; // <= 0 if unknown
+  static std::set<G4LogicalVolume *> targetVolumes;
+
+  static G4ThreadLocal G4BOptrForceCollision *forceCollision;
+};
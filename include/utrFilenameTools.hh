@@ -42,6 +42,9 @@ class utrFilenameTools {
   static unsigned int findNextFreeFilenameID();
   static string getMasterFilename();
   static void deleteMasterFilename();
+  static string getMergedFilename(); // <outputDir>/<filenamePrefix>[filenameID].root, the output file if ntuple merging is used
+  static void setMergeNtuples(bool merge) { mergeNtuples = merge; };
+  static bool getMergeNtuples() { return mergeNtuples; };
 
   private:
   // statics are set as statics here so they are shared and available to all threads
@@ -51,4 +54,5 @@ class utrFilenameTools {
   static unsigned int filenameID;
   static bool useFilenameID;
   static string masterFilename;
+  static bool mergeNtuples;
 };
@@ -0,0 +1,81 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "G4Types.hh"
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Tools for the EVENT_HISTOGRAM output mode, in which the energy depositions of each event are sorted
+// directly into histograms instead of being written to an ntuple.
+// Every thread fills its own histograms 'det0' ... 'det<MAXID>' and 'sum' with the same layout as the
+// ones created by OutputProcessing/getHistogram. At the end of the run, Geant4 merges the histograms of
+// all threads in the master thread, which writes them to '<OUTPUTDIR>/<PREFIX>[ID]_hist.root'.
+class utrHistogramTools {
+  public:
+  utrHistogramTools();
+  virtual ~utrHistogramTools();
+
+  static void setBinning(G4double bin) { binning = bin; };
+  static G4double getBinning() { return binning; };
+  static void setMaxEnergy(G4double emax) { maxEnergy = emax; };
+  static G4double getMaxEnergy() { return maxEnergy; };
+  static bool addAddbackGroup(const vector<unsigned int> &group); // Returns false if a detector is already part of another group
+  static void clearAddbackGroups() { addbackGroups.clear(); };
+  static const vector<vector<unsigned int>> &getAddbackGroups() { return addbackGroups; };
+  static string getHistogramFilename();
+
+  // Called by each thread in RunAction::BeginOfRunAction to create its histograms.
+  // A set of histograms is created for each prefix of the names (one for each point of a scan, see utrScanTools), the first one is filled.
+  static void book(unsigned int max_detector_ID, const vector<string> &prefixes = vector<string>(1, ""));
+  // Selects the set of histograms that is filled
+  static void selectSet(unsigned int set);
+  // Called in EnergyDepositionSD::EndOfEvent for each detector and statistical weight with a nonzero energy deposition.
+  static void addEnergyDeposition(unsigned int detector_ID, G4double edep, G4double weight = 1.);
+  // Called in EventAction::EndOfEventAction to fill the buffered energy depositions of the event.
+  // The depositions of each weight are filled separately with this weight, and only they are added back.
+  static void fillEvent();
+
+  private:
+  // statics are set as statics here so they are shared and available to all threads, just like in utrFilenameTools
+  static G4double binning;
+  static G4double maxEnergy;
+  static vector<vector<unsigned int>> addbackGroups;
+
+  // Fills the depositions in edepBuffer of the detectors in hitDetectors with the given weight, and clears both
+  static void fillDetectors(G4double weight);
+
+  struct WeightedDeposition {
+    unsigned int detector_ID;
+    G4double edep;
+    G4double weight;
+  };
+
+  // Per-thread buffers of the current event
+  static G4ThreadLocal vector<WeightedDeposition> *depositionBuffer;
+  static G4ThreadLocal vector<G4double> *edepBuffer;
+  static G4ThreadLocal vector<unsigned int> *hitDetectors;
+  static G4ThreadLocal vector<G4int> *addbackGroupOfDetector; // -1 if a detector is not part of any addback group
+  static G4ThreadLocal G4int firstHistogramID;
+  static G4ThreadLocal G4int firstSetHistogramID;
+};
@@ -20,12 +20,18 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
 #include "G4UIcommand.hh"
 #include "G4UIdirectory.hh"
 #include "G4UImessenger.hh"
 #include "globals.hh"
 
+#include "utrConfig.h"
+
 class AngularDistributionGenerator;
 
 class utrMessenger : public G4UImessenger {
@@ -41,5 +47,68 @@ class utrMessenger : public G4UImessenger {
 
   G4UIcmdWithAString *setFilenameCmd;
   G4UIcmdWithABool *setUseFilenameIDCmd;
+  G4UIcmdWithABool *mergeNtuplesCmd;
   G4UIcmdWithAString *appendZerosToVarCmd;
+
+  G4UIdirectory *scanDirectory;
+
+  G4UIcmdWithAString *scanMacroCmd;
+  G4UIcmdWithAString *scanAddPointCmd;
+  G4UIcmdWithoutParameter *scanClearCmd;
+  G4UIcmdWithAnInteger *scanBeamOnCmd;
+
+  G4UIdirectory *regionDirectory;
+
+  G4UIcmdWithAString *regionCutCmd;
+  G4UIcmdWithAString *regionEmPhysicsCmd;
+
+  G4UIdirectory *stackingDirectory;
+
+  G4UIcmdWithAString *stackingKillParticleCmd;
+  G4UIcmdWithAString *stackingKillBelowCmd;
+  G4UIcmdWithAString *stackingKillInVolumeCmd;
+  G4UIcmdWithAString *stackingKillInRegionCmd;
+  G4UIcmdWithAString *stackingKillUnreachableCmd;
+  G4UIcmdWithoutParameter *stackingClearCmd;
+
+#ifdef ESCAPE_CULLING
+  G4UIdirectory *cullDirectory;
+
+  G4UIcmdWithABool *cullRoomScatterCmd;
+  G4UIcmdWithADoubleAndUnit *cullMarginCmd;
+  G4UIcmdWithAnInteger *cullSampleEveryCmd;
+#endif
+
+#ifdef FORCED_INTERACTION
+  G4UIdirectory *biasDirectory;
+
+  G4UIcmdWithABool *biasForcedInteractionCmd;
+  G4UIcmdWithADouble *biasAnalogFOMCmd;
+#endif
+
+  G4UIdirectory *phaseSpaceDirectory;
+
+  G4UIcmdWithAString *phaseSpaceRecordCmd;
+  G4UIcmdWithABool *phaseSpaceKillRecordedCmd;
+#ifdef GENERATOR_PHASESPACE
+  G4UIcmdWithAString *phaseSpaceReplayCmd;
+  G4UIcmdWithAString *phaseSpaceAccessCmd;
+  G4UIcmdWithAnInteger *phaseSpaceRecycleCmd;
+#endif
+
+#if !defined(EVENT_HISTOGRAM) && !defined(EVENT_EVENTWISE_SPARSE) && !defined(EVENT_EVENTWISE)
+  G4UIdirectory *outputDirectory;
+
+  G4UIcmdWithAString *outputQuantitiesCmd;
+  G4UIcmdWithAString *outputRecordCmd;
+#endif
+
+#ifdef EVENT_HISTOGRAM
+  G4UIdirectory *histogramDirectory;
+
+  G4UIcmdWithADoubleAndUnit *histogramBinningCmd;
+  G4UIcmdWithADoubleAndUnit *histogramMaxEnergyCmd;
+  G4UIcmdWithAString *histogramAddbackCmd;
+  G4UIcmdWithoutParameter *histogramClearAddbackCmd;
+#endif
 };
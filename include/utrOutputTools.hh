@@ -0,0 +1,84 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "G4ThreeVector.hh"
+#include "G4Types.hh"
+#include "globals.hh"
+
+#include "RunAction.hh"
+
+#include <vector>
+
+using std::vector;
+
+// Quantities of a single entry (row) of the output ntuple, collected by the sensitive detectors
+struct OutputRecord {
+  G4int eventID;
+  G4double edep;
+  G4double ekin;
+  G4int particle;
+  G4int volume;
+  G4ThreeVector position;
+  G4ThreeVector momentum;
+  G4double weight; // Statistical weight of the track, different from 1 only with FORCED_INTERACTION
+};
+
+// Tools for the selection of the quantities in the output ntuple at runtime with the /utr/output/ commands.
+// The default selection is given by the EVENT_ID ... EVENT_WEIGHT build options.
+// At the start of each run, every thread compiles the selection into a fill plan, i.e. an array of functions
+// that each copy one quantity of an OutputRecord into its column, so that writing an entry does not need to
+// check the selection again.
+class utrOutputTools {
+  public:
+  utrOutputTools();
+  virtual ~utrOutputTools();
+
+  static bool setRecordQuantity(const G4String &name, bool record); // Returns false if the quantity does not exist
+  static bool setRecordQuantities(const vector<G4String> &names); // Records only the given quantities, returns false if any of them does not exist
+  static bool getRecordQuantity(unsigned int flag) { return recordQuantity[flag]; };
+  static G4String getSelection(); // Names of the recorded quantities, separated by spaces
+
+  // Called by each thread in RunAction::BeginOfRunAction to create the columns and the fill plan of an ntuple.
+  // In a scan, it is called for the ntuple of each point, but the selection is only printed for the first one.
+  static void book(bool printSelection = true);
+  // Called by the sensitive detectors to write an entry with the selected quantities of the record
+  static void fill(const OutputRecord &record);
+
+  // Whether the fill plan of the thread contains the particle type, any coordinate of the position or any component of
+  // the momentum. The sensitive detectors only compute these quantities of an OutputRecord if they are written.
+  static bool recordsParticle() { return particleInPlan; };
+  static bool recordsPosition() { return positionInPlan; };
+  static bool recordsMomentum() { return momentumInPlan; };
+
+  private:
+  typedef void (*ColumnFiller)(G4int column, const OutputRecord &record);
+
+  static G4int findFlag(const G4String &name); // Returns -1 if the quantity does not exist
+
+  // The selection is shared by all threads like the settings in utrFilenameTools, and may only be changed between runs
+  static vector<bool> recordQuantity;
+
+  static G4ThreadLocal ColumnFiller fillPlan[NFLAGS];
+  static G4ThreadLocal G4int nColumns;
+  static G4ThreadLocal bool particleInPlan;
+  static G4ThreadLocal bool positionInPlan;
+  static G4ThreadLocal bool momentumInPlan;
+};
@@ -0,0 +1,95 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
+#include "G4Types.hh"
+#include "globals.hh"
+
+#include "PhaseSpace.hh"
+
+using std::vector;
+
+// Settings of the two-stage simulations with a phase-space file (see PhaseSpace.hh).
+// In the first stage, the PhaseSpaceSDs record the particles that enter them. Each thread buffers its
+// records and writes them to a part file '<filename>_t<threadID>', which the master thread merges into
+// the phase-space file at the end of the run. In the second stage, the PhaseSpaceGenerator replays
+// the phase-space file.
+class utrPhaseSpaceTools {
+  public:
+  utrPhaseSpaceTools();
+  virtual ~utrPhaseSpaceTools();
+
+  // An empty filename switches off the recording
+  static void setRecordFilename(const G4String &filename) { recordFilename = filename; };
+  static const G4String &getRecordFilename() { return recordFilename; };
+  static bool isRecording() { return recordFilename != ""; };
+  static void setKillRecorded(bool kill) { killRecorded = kill; };
+  static bool getKillRecorded() { return killRecorded; };
+
+  static void setReplayFilename(const G4String &filename) { replayFilename = filename; };
+  static const G4String &getReplayFilename() { return replayFilename; };
+  static void setSequentialAccess(bool sequential) { sequentialAccess = sequential; };
+  static bool getSequentialAccess() { return sequentialAccess; };
+  static void setRecycle(G4int n) { recycle = n; };
+  static G4int getRecycle() { return recycle; };
+
+  // Called by RunAction::BeginOfRunAction of the master thread at the start of a run, or of the first
+  // point of a scan. Aborts if the phase-space file already exists.
+  static void beginRun();
+  // Called by PhaseSpaceSD::ProcessHits in the thread of the event
+  static void write(const PhaseSpaceRecord &record);
+  // Called by RunAction::EndOfRunAction of each thread. The phase-space file is written by the
+  // master thread at the end of a run, or of the last point of a scan.
+  static void endRun(G4int n_events, bool master, bool last_point);
+
+  // Called by RunAction::BeginOfRunAction of the master thread. The sequential access restarts at the
+  // first record if the replayed file was changed since the previous run.
+  static void beginReplay();
+  // Called by PhaseSpaceGenerator for each event with sequential access. All threads draw from the same
+  // counter, so each use of a record goes to exactly one event, whichever thread processes it.
+  static uint64_t nextSequentialUse() { return sequentialUses++; };
+
+  private:
+  static void flush();
+  static void merge();
+
+  static G4String recordFilename;
+  static bool killRecorded;
+
+  static G4String replayFilename;
+  static bool sequentialAccess;
+  static G4int recycle;
+  // Number of records that were handed out by nextSequentialUse() for the file replayedFilename
+  static std::atomic<uint64_t> sequentialUses;
+  static G4String replayedFilename;
+
+  // Accumulated by the master thread over all points of a scan
+  static G4long recordedEvents;
+  // Filenames of the part files of all threads, guarded by a mutex
+  static vector<G4String> partFilenames;
+
+  static G4ThreadLocal FILE *partFile;
+  static G4ThreadLocal vector<PhaseSpaceRecord> *buffer;
+};
@@ -0,0 +1,65 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "G4LogicalVolume.hh"
+#include "G4Types.hh"
+#include "globals.hh"
+#include <map>
+#include <vector>
+
+using std::map;
+using std::vector;
+
+// Tools for the regions of the geometry, which allow to use different production cuts and electromagnetic
+// physics in different parts of the setup.
+// The geometry code adds logical volumes to one of the regions 'detector', 'target', 'shielding' and
+// 'infrastructure'. All other volumes belong to the default region of the world. The production cuts and
+// the type of the electromagnetic physics of each region are set with the /utr/region/ commands.
+// The defaults are the global production cut and the global electromagnetic physics, except for the
+// EM_REGIONS build option (see Physics).
+class utrRegionTools {
+  public:
+  utrRegionTools();
+  virtual ~utrRegionTools();
+
+  static const vector<G4String> &getRegionNames() { return regionNames; };
+  static bool isRegionName(const G4String &region);
+
+  // Adds a logical volume and all of its daughters, which do not belong to another region, to a region
+  static void addLogicalVolume(const G4String &region, G4LogicalVolume *logical);
+
+  static void setProductionCut(const G4String &region, G4double cut) { productionCuts[region] = cut; }; // A cut <= 0 means the global production cut
+  static G4double getProductionCut(const G4String &region);
+  static void setEmPhysics(const G4String &region, const G4String &type) { emPhysics[region] = type; }; // An empty type means the global EM physics
+  static G4String getEmPhysics(const G4String &region);
+
+  // Called by Physics::SetCuts and when a cut is changed between runs
+  static void applyProductionCuts();
+  // Called by Physics::ConstructProcess before the EM physics is constructed
+  static void addEmPhysics();
+
+  private:
+  // statics are set as statics here so they are shared and available to all threads, just like in utrFilenameTools
+  static const vector<G4String> regionNames;
+  static map<G4String, G4double> productionCuts;
+  static map<G4String, G4String> emPhysics;
+};
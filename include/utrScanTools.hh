@@ -0,0 +1,67 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "G4Types.hh"
+#include "globals.hh"
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Tools for scans, in which the same simulation is run for a list of parameter points (for example
+// beam energies, source positions or spins of an angular distribution) with /utr/scan/beamOn.
+// All points are run in the same process, so the geometry, the physics tables and the worker threads
+// are reused. For each point, the parameters are defined as macro aliases {NAME} and the scan macro
+// is executed, which applies them with the usual commands (for example /gps/ene/mono {E} MeV).
+// The output of all points goes to the same output file(s), in which the names of the histograms or
+// ntuples of a point are prefixed with 'p<POINT>_'.
+class utrScanTools {
+  public:
+  utrScanTools();
+  virtual ~utrScanTools();
+
+  static void setMacro(const G4String &macro) { scanMacro = macro; };
+  static G4String getMacro() { return scanMacro; };
+  static bool addPoint(const G4String &parameters); // 'NAME=VALUE [NAME=VALUE ...]', returns false if malformed
+  static void clearPoints() { points.clear(); };
+  static size_t getNPoints() { return points.size(); };
+  static G4String getPointParameters(size_t point);
+
+  // Runs all points with nevents events each and prints a timing summary
+  static void beamOn(G4int nevents);
+
+  // Used by RunAction to keep the output file open during a scan. Outside of a scan, the current point is always 0.
+  static bool isScanning() { return scanning; };
+  static unsigned int getCurrentPoint() { return currentPoint; };
+  static bool isLastPoint() { return !scanning || currentPoint + 1 == points.size(); };
+  // Prefixes of the output objects of all points, a single empty prefix outside of a scan
+  static vector<string> getOutputPrefixes();
+
+  private:
+  // statics are set as statics here so they are shared and available to all threads, just like in utrFilenameTools
+  static G4String scanMacro;
+  static vector<vector<std::pair<G4String, G4String>>> points;
+  static bool scanning;
+  static unsigned int currentPoint;
+};
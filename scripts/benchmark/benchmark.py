@@ -0,0 +1,307 @@
+#!/usr/bin/env python3
+
+import argparse
+import datetime
+import glob
+import json
+import os
+import platform
+import re
+import shutil
+import socket
+import subprocess
+import sys
+import time
+
+benchmarkDir = os.path.dirname(os.path.abspath(__file__))
+sourceDir = os.path.dirname(os.path.dirname(benchmarkDir))
+
+# Geometries of the benchmark with their runtime parameters (utr --geometry-parameter) and the aliases used by the
+# workload macros. The beam starts upstream of the target, the sources of the angdist workload are the target volumes.
+geometries = {
+    "unit_tests/Physics": {
+        "parameters": [],
+        "aliases": {
+            "beamZ": "-900.",
+            "beamRadius": "5.",
+            "sourceDX": "20.",
+            "sourceDY": "20.",
+            "sourceDZ": "100.",
+            "sourcePVs": "target",
+        },
+    },
+    "Campaign_2021/154Sm-GDR": {
+        "parameters": ["TARGET=154Sm"],
+        "aliases": {
+            "beamZ": "-100.",
+            "beamRadius": "4.",
+            "sourceDX": "14.",
+            "sourceDY": "14.",
+            "sourceDZ": "24.",
+            "sourcePVs": "target154SmFirstMaterial target154SmFirstMaterialIrradiated target154SmSecondMaterial target154SmSecondMaterialIrradiated",
+        },
+    },
+}
+
+# Workloads of the benchmark with the primary generator they need
+workloads = {
+    "beam": "gps",
+    "gps": "gps",
+    "angdist": "angdist",
+}
+
+generatorOptions = {
+    "gps": ["-DGENERATOR_ANGDIST=OFF", "-DGENERATOR_ANGCORR=OFF"],
+    "angdist": ["-DGENERATOR_ANGDIST=ON", "-DGENERATOR_ANGCORR=OFF"],
+}
+
+argparser = argparse.ArgumentParser(
+    description="""
+Reproducible performance benchmark of utr
+
+Builds utr with all geometries of the benchmark (cmake option GEOMETRIES) once
+for each primary generator, selects the geometry of each run with
+utr --geometry, runs each workload with a fixed random number seed
+and 1 to THREADS threads, and writes the throughput (events/s, ns/event),
+the peak resident memory, the output size per event and the scaling
+efficiency of each run to a JSON file.
+The results of two benchmarks can be compared with --compare.
+""",
+    formatter_class=argparse.RawDescriptionHelpFormatter,
+)
+argparser.add_argument("-t", "--threads", type=int, default=os.cpu_count(), help="Maximum number of threads (default: number of CPUs)")
+argparser.add_argument("-n", "--events", type=int, default=100000, help="Number of events of each run (default: 100000)")
+argparser.add_argument("-s", "--seed", type=int, default=1, help="Random number seed of each run (default: 1)")
+argparser.add_argument("-g", "--geometries", nargs="+", choices=list(geometries.keys()), default=list(geometries.keys()), help="Geometries to benchmark (default: all)")
+argparser.add_argument("-w", "--workloads", nargs="+", choices=list(workloads.keys()), default=list(workloads.keys()), help="Workloads to run (default: all)")
+argparser.add_argument("-b", "--build-dir", default="benchmark", help="Directory for the builds and the output of the runs (default: benchmark)")
+argparser.add_argument("-o", "--output", default="benchmark.json", help="Name of the JSON file with the results (default: benchmark.json)")
+argparser.add_argument("-j", "--jobs", type=int, default=os.cpu_count(), help="Number of parallel jobs for the compilation (default: number of CPUs)")
+argparser.add_argument("--cmake-args", nargs="*", default=[], help="Additional arguments for cmake, e.g. -DEM_FAST=ON")
+argparser.add_argument("--skip-build", action="store_true", help="Use the existing builds in the build directory")
+argparser.add_argument("--compare", metavar="JSON", help="Compare the results to those of an earlier benchmark")
+args = argparser.parse_args()
+
+
+def runCommand(command, cwd, log):
+    log.write("$ " + " ".join(command) + "\n")
+    log.flush()
+    if subprocess.run(command, cwd=cwd, stdout=log, stderr=subprocess.STDOUT).returncode != 0:
+        sys.exit("Error! '" + " ".join(command) + "' failed, see " + log.name)
+
+
+def buildName(generator):
+    return generator
+
+
+# The configuration of utr writes header files into the source directory, which are restored after the
+# benchmark builds, so that an existing build of the user is not affected.
+generatedHeaders = [os.path.join(sourceDir, "include", "utrConfig.h")] + glob.glob(os.path.join(sourceDir, "DetectorConstruction", "*", "*", "DetectorConstructionConfig.hh"))
+savedHeaders = {}
+for header in generatedHeaders:
+    if os.path.isfile(header):
+        with open(header) as f:
+            savedHeaders[header] = f.read()
+
+
+def restoreHeaders():
+    for header, content in savedHeaders.items():
+        current = None
+        if os.path.isfile(header):
+            with open(header) as f:
+                current = f.read()
+        if current != content:
+            with open(header, "w") as f:
+                f.write(content)
+
+
+buildDir = os.path.abspath(args.build_dir)
+os.makedirs(buildDir, exist_ok=True)
+
+builds = []
+for workload in args.workloads:
+    if workloads[workload] not in builds:
+        builds.append(workloads[workload])
+
+if not args.skip_build:
+    try:
+        for generator in builds:
+            directory = os.path.join(buildDir, buildName(generator))
+            os.makedirs(directory, exist_ok=True)
+            print("Building utr for " + ", ".join(args.geometries) + " (" + generator + ") in " + directory)
+            with open(os.path.join(directory, "build.log"), "w") as log:
+                runCommand(
+                    ["cmake", sourceDir, "-DCMAKE_BUILD_TYPE=Release", "-DGEOMETRIES=" + ";".join(args.geometries)]
+                    + generatorOptions[generator]
+                    + args.cmake_args,
+                    directory,
+                    log,
+                )
+                runCommand(["cmake", "--build", ".", "--", "-j" + str(args.jobs)], directory, log)
+    finally:
+        restoreHeaders()
+
+# Geant4 prints the time of the event loop in the run summary of the master thread with /run/verbose 1
+eventsPattern = re.compile(r"Number of events processed\s*:\s*(\d+)")
+realTimePattern = re.compile(r"Real=\s*([0-9.eE+-]+)\s*s")
+
+
+def parseRunSummary(logFilename):
+    events = None
+    realTime = None
+    with open(logFilename, errors="replace") as log:
+        for line in log:
+            if line.startswith("G4WT"):
+                continue
+            match = eventsPattern.search(line)
+            if match:
+                events = int(match.group(1))
+            match = realTimePattern.search(line)
+            if match:
+                realTime = float(match.group(1))
+    return events, realTime
+
+
+def directorySize(directory):
+    size = 0
+    for root, dirs, files in os.walk(directory):
+        for filename in files:
+            size += os.path.getsize(os.path.join(root, filename))
+    return size
+
+
+results = []
+for geometry in args.geometries:
+    for workload in args.workloads:
+        directory = os.path.join(buildDir, buildName(workloads[workload]))
+        executable = os.path.join(directory, "utr")
+        if not os.path.isfile(executable):
+            sys.exit("Error! utr executable '" + executable + "' not found.")
+
+        for nthreads in range(1, args.threads + 1):
+            runDir = os.path.join(directory, "runs", geometry.replace("/", "_") + "_" + workload + "_t" + str(nthreads))
+            if os.path.isdir(runDir):
+                shutil.rmtree(runDir)
+            outputDir = os.path.join(runDir, "output")
+            os.makedirs(outputDir)
+
+            macroFilename = os.path.join(runDir, "benchmark.mac")
+            with open(macroFilename, "w") as macro:
+                macro.write("/control/alias nevents " + str(args.events) + "\n")
+                macro.write("/control/alias benchmarkDir " + benchmarkDir + "\n")
+                for alias, value in geometries[geometry]["aliases"].items():
+                    # Alias values with spaces have to be quoted
+                    macro.write("/control/alias " + alias + " " + ('"' + value + '"' if " " in value else value) + "\n")
+                macro.write("/control/execute " + os.path.join(benchmarkDir, workload + ".mac") + "\n")
+
+            print("Running " + workload + " workload in " + geometry + " with " + str(nthreads) + " thread(s) ...", end=" ", flush=True)
+            logFilename = os.path.join(runDir, "utr.log")
+            with open(logFilename, "w") as log:
+                start = time.perf_counter()
+                command = [executable, "-g", geometry, "-m", macroFilename, "-t", str(nthreads), "-o", outputDir, "-s", str(args.seed)]
+                for parameter in geometries[geometry]["parameters"]:
+                    command += ["-p", parameter]
+                process = subprocess.Popen(command, cwd=directory, stdout=log, stderr=subprocess.STDOUT)
+                _, status, usage = os.wait4(process.pid, 0)
+                wallTime = time.perf_counter() - start
+            if not os.WIFEXITED(status) or os.WEXITSTATUS(status) != 0:
+                sys.exit("Error! utr failed, see " + logFilename)
+
+            events, eventLoopTime = parseRunSummary(logFilename)
+            if events is None:
+                events = args.events
+            # Without a run summary, the time for the initialization is included
+            time_s = eventLoopTime if eventLoopTime else wallTime
+            outputBytes = directorySize(outputDir)
+            result = {
+                "geometry": geometry,
+                "workload": workload,
+                "threads": nthreads,
+                "events": events,
+                "wall_time_s": wallTime,
+                "event_loop_time_s": eventLoopTime,
+                "cpu_time_s": usage.ru_utime + usage.ru_stime,
+                "events_per_s": events / time_s,
+                "ns_per_event": time_s / events * 1e9,
+                # ru_maxrss is given in kilobytes on Linux
+                "peak_rss_bytes": usage.ru_maxrss * 1024,
+                "output_bytes": outputBytes,
+                "output_bytes_per_event": outputBytes / events,
+            }
+            results.append(result)
+            print("{:.1f} events/s".format(result["events_per_s"]))
+
+# The scaling efficiency is the speedup with respect to a single thread divided by the number of threads
+for result in results:
+    for reference in results:
+        if reference["geometry"] == result["geometry"] and reference["workload"] == result["workload"] and reference["threads"] == 1:
+            result["scaling_efficiency"] = result["events_per_s"] / (reference["events_per_s"] * result["threads"])
+
+
+def commandOutput(command):
+    try:
+        return subprocess.run(command, cwd=sourceDir, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, universal_newlines=True).stdout.strip()
+    except OSError:
+        return ""
+
+
+cpuModel = platform.processor()
+if os.path.isfile("/proc/cpuinfo"):
+    with open("/proc/cpuinfo") as cpuinfo:
+        for line in cpuinfo:
+            if line.startswith("model name"):
+                cpuModel = line.split(":", 1)[1].strip()
+                break
+
+metadata = {
+    "date": datetime.datetime.now(datetime.timezone.utc).isoformat(),
+    "commit": commandOutput(["git", "rev-parse", "HEAD"]),
+    "describe": commandOutput(["git", "describe", "--always", "--dirty"]),
+    "geant4": commandOutput(["geant4-config", "--version"]),
+    "host": socket.gethostname(),
+    "platform": platform.platform(),
+    "cpu": cpuModel,
+    "cpu_count": os.cpu_count(),
+    "seed": args.seed,
+    "events": args.events,
+    "cmake_args": args.cmake_args,
+}
+
+with open(args.output, "w") as output:
+    json.dump({"metadata": metadata, "results": results}, output, indent=2)
+print("Wrote results to " + args.output)
+
+print()
+print("{:<26} {:<8} {:>7} {:>12} {:>12} {:>10} {:>12} {:>10}".format("geometry", "workload", "threads", "events/s", "ns/event", "RSS/MiB", "bytes/event", "efficiency"))
+for result in results:
+    print(
+        "{:<26} {:<8} {:>7} {:>12.1f} {:>12.0f} {:>10.1f} {:>12.1f} {:>10.2f}".format(
+            result["geometry"],
+            result["workload"],
+            result["threads"],
+            result["events_per_s"],
+            result["ns_per_event"],
+            result["peak_rss_bytes"] / 2**20,
+            result["output_bytes_per_event"],
+            result["scaling_efficiency"],
+        )
+    )
+
+if args.compare:
+    with open(args.compare) as f:
+        earlier = json.load(f)
+    print()
+    print("Comparison to " + args.compare + " (commit " + earlier["metadata"].get("describe", "unknown") + ", " + earlier["metadata"].get("date", "unknown date") + ")")
+    print("{:<26} {:<8} {:>7} {:>14} {:>14}".format("geometry", "workload", "threads", "events/s ratio", "RSS ratio"))
+    for result in results:
+        for reference in earlier["results"]:
+            if reference["geometry"] == result["geometry"] and reference["workload"] == result["workload"] and reference["threads"] == result["threads"]:
+                print(
+                    "{:<26} {:<8} {:>7} {:>14.3f} {:>14.3f}".format(
+                        result["geometry"],
+                        result["workload"],
+                        result["threads"],
+                        result["events_per_s"] / reference["events_per_s"],
+                        result["peak_rss_bytes"] / reference["peak_rss_bytes"],
+                    )
+                )
@@ -18,22 +18,22 @@ You should have received a copy of the GNU General Public License
 along with utr.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <vector>
-
 #include "ActionInitialization.hh"
 
 #ifdef GENERATOR_ANGDIST
 #include "AngularDistributionGenerator.hh"
 #elif defined GENERATOR_ANGCORR
 #include "AngularCorrelationGenerator.hh"
+#elif defined GENERATOR_PHASESPACE
+#include "PhaseSpaceGenerator.hh"
 #else
 #include "GeneralParticleSource.hh"
 #endif
 
 #include "EventAction.hh"
 #include "RunAction.hh"
-
-using std::vector;
+#include "StackingAction.hh"
+#include "SteppingAction.hh"
 
 ActionInitialization::ActionInitialization() : G4VUserActionInitialization(),
                                                n_threads(1) {}
@@ -49,6 +49,8 @@ void ActionInitialization::Build() const {
   SetUserAction(new AngularDistributionGenerator);
 #elif defined GENERATOR_ANGCORR
   SetUserAction(new AngularCorrelationGenerator);
+#elif defined GENERATOR_PHASESPACE
+  SetUserAction(new PhaseSpaceGenerator);
 #else
   SetUserAction(new GeneralParticleSource);
 #endif
@@ -59,65 +61,27 @@ void ActionInitialization::Build() const {
 #endif
   SetUserAction(eventAction);
 
-  RunAction *runAction = new RunAction();
-
-  vector<bool> record_quantity(NFLAGS);
-  for (short i = 0; i < NFLAGS; ++i)
-    record_quantity[i] = false;
+  // Without kill rules, the StackingAction keeps all tracks
+  SetUserAction(new StackingAction);
 
-#ifdef EVENT_ID
-  record_quantity[ID] = true;
-#endif
-#ifdef EVENT_EDEP
-  record_quantity[EDEP] = true;
-#endif
-#ifdef EVENT_EKIN
-  record_quantity[EKIN] = true;
-#endif
-#ifdef EVENT_PARTICLE
-  record_quantity[PARTICLE] = true;
-#endif
-#ifdef EVENT_VOLUME
-  record_quantity[VOLUME] = true;
-#endif
-#ifdef EVENT_POSX
-  record_quantity[POSX] = true;
-#endif
-#ifdef EVENT_POSY
-  record_quantity[POSY] = true;
-#endif
-#ifdef EVENT_POSZ
-  record_quantity[POSZ] = true;
-#endif
-#ifdef EVENT_MOMX
-  record_quantity[MOMX] = true;
-#endif
-#ifdef EVENT_MOMY
-  record_quantity[MOMY] = true;
-#endif
-#ifdef EVENT_MOMZ
-  record_quantity[MOMZ] = true;
+#ifdef ESCAPE_CULLING
+  SetUserAction(new SteppingAction);
 #endif
 
+  RunAction *runAction = new RunAction();
+
+  // The quantities of the default output mode are printed by utrOutputTools::book() at the start of each run,
+  // since they can be changed with the /utr/output/ commands
+#ifdef EVENT_EVENTWISE
   if (G4Threading::G4GetThreadId() == 0) {
     G4cout << "================================================================"
               "================"
            << G4endl;
-#ifdef EVENT_EVENTWISE
     G4cout << "ActionInitialization: EDEP will be saved to the output file in EVENTWISE mode" << G4endl;
-#else
-    G4cout << "ActionInitialization: The following quantities will be saved to "
-              "the output file:"
-           << G4endl;
-    for (auto i = 0; i < NFLAGS; i++) {
-      if (record_quantity[i]) {
-        G4cout << runAction->GetOutputFlagName(i) << G4endl;
-      }
-    }
-#endif
     G4cout << "================================================================"
               "================"
            << G4endl;
   }
+#endif
   SetUserAction(runAction);
 }
@@ -34,6 +34,10 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 AngularCorrelationGenerator::AngularCorrelationGenerator()
     : G4VUserPrimaryGeneratorAction(), particleGun(0),
       angdist(0),
+      position_sampler_method(POSITION_SAMPLER_BOX),
+      kernels_resolved(false),
+      max_w_user(0.),
+      use_envelope(false),
       MAX_TRIES_POSITION(1e4),
       MAX_TRIES_MOMENTUM(1e4),
       direction_given(false),
@@ -56,6 +60,10 @@ AngularCorrelationGenerator::~AngularCorrelationGenerator() {
 
 void AngularCorrelationGenerator::GeneratePrimaries(G4Event *anEvent) {
 
+  if (!kernels_resolved) {
+    resolve_kernels();
+  }
+
 #ifdef CHECK_POSITION_GENERATOR
   check_position_generator();
 #endif
@@ -64,6 +72,11 @@ void AngularCorrelationGenerator::GeneratePrimaries(G4Event *anEvent) {
   check_momentum_generator();
 #endif
 
+#ifdef PROFILE_GENERATORS
+  // The one-time setup and the self-checks above are not included in the profile
+  profiler.BeginEvent();
+#endif
+
   G4ThreeVector randomPosition = G4ThreeVector(0., 0., 0.);
   randomPosition = generate_position();
 
@@ -98,24 +111,29 @@ void AngularCorrelationGenerator::GeneratePrimaries(G4Event *anEvent) {
     referenceDirection = randomDirection;
     referencePolarization = randomPolarization;
   }
+
+#ifdef PROFILE_GENERATORS
+  profiler.EndEvent((G4long)particles.size());
+#endif
 }
 
 G4ThreeVector AngularCorrelationGenerator::generate_position() {
 
-  for (int i = 0; i < MAX_TRIES_POSITION; i++) {
-    random_x = (G4UniformRand() - 0.5) * range_x + source_x;
-    random_y = (G4UniformRand() - 0.5) * range_y + source_y;
-    random_z = (G4UniformRand() - 0.5) * range_z + source_z;
-
-    pv = navi->LocateGlobalPointAndSetup(
-                 G4ThreeVector(random_x, random_y, random_z))
-             ->GetName();
+  if (!source_sampler.IsInitialized()) {
+    source_sampler.Initialize(source_PV_names, G4ThreeVector(source_x, source_y, source_z), G4ThreeVector(range_x, range_y, range_z), position_sampler_method, MAX_TRIES_POSITION);
+  }
 
-    for (unsigned int j = 0; j < source_PV_names.size(); ++j) {
-      if (pv == source_PV_names[j]) {
-        return G4ThreeVector(random_x, random_y, random_z);
-      }
-    }
+  G4ThreeVector position;
+#ifdef PROFILE_GENERATORS
+  const G4long position_trials = source_sampler.GetNTrials();
+  const G4long positions = source_sampler.GetNAccepted();
+#endif
+  const G4bool position_found = source_sampler.Sample(position);
+#ifdef PROFILE_GENERATORS
+  profiler.CountPositionTrials(source_sampler.GetNTrials() - position_trials, source_sampler.GetNAccepted() - positions);
+#endif
+  if (position_found) {
+    return position;
   }
 
   G4cout << "Warning: AngularCorrelationGenerator: Monte-Carlo method "
@@ -250,46 +268,178 @@ G4ThreeVector AngularCorrelationGenerator::generate_direction(unsigned long n_pa
   } else {
     G4ThreeVector randomDirection(0., 0., 1.);
 
-    for (int i = 0; i < MAX_TRIES_MOMENTUM; i++) {
-      random_theta = acos(2. * G4UniformRand() - 1.);
-      random_phi = twopi * G4UniformRand();
-      random_w = G4UniformRand() * MAX_W;
-
-      if (!is_polarized[n_particle]) {
-        if (random_w <= angdist->AngDist(random_theta, random_phi, &states[n_particle][0],
-                                         nstates[n_particle], &mixing_ratios[n_particle][0]) +
-                            angdist->AngDist(random_theta,
-                                             random_phi, &alt_states[n_particle][0], nstates[n_particle], &mixing_ratios[n_particle][0])) {
-          randomDirection.setTheta(random_theta);
-          randomDirection.setPhi(random_phi);
-          return randomDirection;
-        }
-      } else {
-        if (random_w <= angdist->AngDist(random_theta, random_phi, &states[n_particle][0],
-                                         nstates[n_particle], &mixing_ratios[n_particle][0])) {
-          randomDirection.setTheta(random_theta);
-          randomDirection.setPhi(random_phi);
-          return randomDirection;
-        }
+    if (use_envelope) {
+      if (sample_direction_envelope(n_particle, randomDirection)) {
+        return randomDirection;
       }
+      return G4ThreeVector();
+    }
+
+    if (accepted_directions[n_particle].empty()) {
+      fill_momentum_buffer(n_particle);
+    }
+#ifdef PROFILE_GENERATORS
+    profiler.CountBufferedMomentum(n_particle, !accepted_directions[n_particle].empty());
+#endif
+    if (!accepted_directions[n_particle].empty()) {
+      randomDirection = accepted_directions[n_particle].back();
+      accepted_directions[n_particle].pop_back();
+      return randomDirection;
     }
   }
   return G4ThreeVector();
 }
 
+void AngularCorrelationGenerator::fill_momentum_buffer(unsigned long n_particle) {
+  // All candidates are independent, so every accepted direction of a block is a valid
+  // sample. The ones which are not used in the current event are kept for the next events.
+  G4double block_cos_theta[MOMENTUM_BLOCK_SIZE];
+  G4double block_cos_phi[MOMENTUM_BLOCK_SIZE];
+  G4double block_sin_phi[MOMENTUM_BLOCK_SIZE];
+  G4double block_random_w[MOMENTUM_BLOCK_SIZE];
+  G4double block_w[MOMENTUM_BLOCK_SIZE];
+
+  for (int i = 0; i < MAX_TRIES_MOMENTUM; i += MOMENTUM_BLOCK_SIZE) {
+    for (int j = 0; j < MOMENTUM_BLOCK_SIZE; ++j) {
+      block_cos_theta[j] = 2. * G4UniformRand() - 1.;
+      random_unit_circle(block_cos_phi[j], block_sin_phi[j]);
+      block_random_w[j] = G4UniformRand() * max_w[n_particle];
+    }
+
+    kernels[n_particle].Evaluate(MOMENTUM_BLOCK_SIZE, block_cos_theta, block_cos_phi, block_sin_phi, block_w);
+
+    for (int j = 0; j < MOMENTUM_BLOCK_SIZE; ++j) {
+      if (block_random_w[j] <= block_w[j]) {
+        const G4double sin_theta = sqrt(1. - block_cos_theta[j] * block_cos_theta[j]);
+        accepted_directions[n_particle].push_back(G4ThreeVector(sin_theta * block_cos_phi[j], sin_theta * block_sin_phi[j], block_cos_theta[j]));
+      }
+    }
+
+#ifdef PROFILE_GENERATORS
+    // The buffer was empty before this block
+    profiler.CountBufferedMomentumTrials(n_particle, MOMENTUM_BLOCK_SIZE, (G4long)accepted_directions[n_particle].size());
+    profiler.CountWEvaluations(MOMENTUM_BLOCK_SIZE);
+#endif
+
+    if (!accepted_directions[n_particle].empty()) {
+      return;
+    }
+  }
+}
+
+G4bool AngularCorrelationGenerator::sample_direction_envelope(unsigned long n_particle, G4ThreeVector &direction) {
+  size_t cell;
+
+  // The cell is selected with a probability proportional to its envelope, and the candidate
+  // is uniformly distributed inside the cell.
+  for (int i = 0; i < MAX_TRIES_MOMENTUM; ++i) {
+    envelope_samplers[n_particle].Sample(G4UniformRand(), G4UniformRand(), random_cos_theta, random_phi, cell);
+#ifdef PROFILE_GENERATORS
+    profiler.CountWEvaluations(1);
+#endif
+    if (G4UniformRand() * envelope_w[n_particle][cell] <= kernels[n_particle](random_cos_theta, random_phi)) {
+#ifdef PROFILE_GENERATORS
+      profiler.CountMomentumTrials(i + 1, 1);
+#endif
+      const G4double sin_theta = sqrt(1. - random_cos_theta * random_cos_theta);
+      direction = G4ThreeVector(sin_theta * cos(random_phi), sin_theta * sin(random_phi), random_cos_theta);
+      return true;
+    }
+  }
+
+#ifdef PROFILE_GENERATORS
+  profiler.CountMomentumTrials(MAX_TRIES_MOMENTUM, 0);
+#endif
+  return false;
+}
+
+void AngularCorrelationGenerator::build_envelope(unsigned long n_particle) {
+  const unsigned int n_cos_theta = ENVELOPE_BINS;
+  const unsigned int n_phi = 2 * ENVELOPE_BINS;
+  envelope_w[n_particle].resize(n_cos_theta * n_phi);
+
+  for (unsigned int i = 0; i < n_cos_theta; ++i) {
+    for (unsigned int j = 0; j < n_phi; ++j) {
+      envelope_w[n_particle][i * n_phi + j] = kernels[n_particle].Envelope(-1. + 2. * i / n_cos_theta, -1. + 2. * (i + 1) / n_cos_theta, twopi * j / n_phi, twopi * (j + 1) / n_phi);
+    }
+  }
+
+  if (!envelope_samplers[n_particle].Build(envelope_w[n_particle], n_cos_theta, n_phi)) {
+    G4cerr << "ERROR: AngularCorrelationGenerator: The envelope of the angular distribution of cascade step #" << n_particle + 1 << " vanishes everywhere. Aborting..." << G4endl;
+    throw std::exception();
+  }
+}
+
+void AngularCorrelationGenerator::random_unit_circle(G4double &cos_phi, G4double &sin_phi) {
+  G4double x, y, r2;
+  do {
+    x = 2. * G4UniformRand() - 1.;
+    y = 2. * G4UniformRand() - 1.;
+    r2 = x * x + y * y;
+  } while (r2 > 1. || r2 == 0.);
+
+  const G4double r_inv = 1. / sqrt(r2);
+  cos_phi = x * r_inv;
+  sin_phi = y * r_inv;
+}
+
+void AngularCorrelationGenerator::resolve_kernels() {
+  accepted_directions.assign(particles.size(), vector<G4ThreeVector>());
+  max_w.assign(particles.size(), 0.);
+  envelope_w.assign(particles.size(), vector<G4double>());
+  envelope_samplers.assign(particles.size(), AngularDistributionSampler());
+
+  for (unsigned long n_particle = 0; n_particle < particles.size(); ++n_particle) {
+    if (direction_is_fixed(n_particle)) {
+      kernels[n_particle] = AngularDistributionKernel();
+      continue;
+    }
+
+    if (!is_polarized[n_particle]) {
+      kernels[n_particle] = angdist->Resolve(&states[n_particle][0], &alt_states[n_particle][0], nstates[n_particle], &mixing_ratios[n_particle][0], 1.);
+    } else {
+      kernels[n_particle] = angdist->Resolve(&states[n_particle][0], nstates[n_particle], &mixing_ratios[n_particle][0]);
+    }
+
+    if (!kernels[n_particle].IsPolynomial()) {
+      G4cout << "Warning: AngularCorrelationGenerator: No closed form found for the angular distribution of cascade step #" << n_particle + 1 << ", evaluating it directly." << G4endl;
+    }
+
+    if (max_w_user > 0.) {
+      max_w[n_particle] = max_w_user;
+    } else {
+      max_w[n_particle] = kernels[n_particle].Envelope();
+    }
+    if (max_w[n_particle] <= 0.) {
+      G4cerr << "ERROR: AngularCorrelationGenerator: The angular distribution of cascade step #" << n_particle + 1 << " is not positive anywhere. Aborting..." << G4endl;
+      throw std::exception();
+    }
+
+    if (use_envelope) {
+      build_envelope(n_particle);
+    }
+  }
+  kernels_resolved = true;
+  // The self-check reports the acceptance rates for the new envelopes
+  checked_momentum_generator = false;
+}
+
 void AngularCorrelationGenerator::check_momentum_generator() {
 
   if (!checked_momentum_generator) {
 
     G4int momentum_success = 0;
-    unsigned int max_w = 0;
+    unsigned int max_w_overflow_counter = 0;
     double p_max_w = 0.;
+    G4double occurred_max_w = -1.;
+    size_t cell;
 
     for (unsigned long n_particle = 0; n_particle < particles.size(); ++n_particle) {
 
       momentum_success = 0;
-      max_w = 0;
+      max_w_overflow_counter = 0;
       p_max_w = 0.;
+      occurred_max_w = -1.;
 
       G4cout << "============================================================"
                 "============"
@@ -300,51 +450,58 @@ void AngularCorrelationGenerator::check_momentum_generator() {
 
       if (!momentum_generator_check_unnecessary(n_particle)) {
         for (int i = 0; i < MAX_TRIES_MOMENTUM; i++) {
-          random_theta = acos(2. * G4UniformRand() - 1.);
+          random_cos_theta = 2. * G4UniformRand() - 1.;
           random_phi = twopi * G4UniformRand();
-          random_w = G4UniformRand() * MAX_W;
-
-          if (!is_polarized[n_particle]) {
-            if (random_w <= angdist->AngDist(random_theta, random_phi, &states[n_particle][0],
-                                             nstates[n_particle], &mixing_ratios[n_particle][0]) +
-                                angdist->AngDist(random_theta,
-                                                 random_phi, &alt_states[n_particle][0], nstates[n_particle], &mixing_ratios[n_particle][0]))
-              ++momentum_success;
-          } else {
-            if (random_w <= angdist->AngDist(random_theta, random_phi, &states[n_particle][0],
-                                             nstates[n_particle], &mixing_ratios[n_particle][0]))
-              ++momentum_success;
-          }
-          if (!is_polarized[n_particle]) {
-            if (MAX_W <= angdist->AngDist(random_theta, random_phi, &states[n_particle][0],
-                                          nstates[n_particle], &mixing_ratios[n_particle][0]) +
-                             angdist->AngDist(random_theta,
-                                              random_phi, &alt_states[n_particle][0], nstates[n_particle], &mixing_ratios[n_particle][0]))
-              ++max_w;
-          } else {
-            if (MAX_W <= angdist->AngDist(random_theta, random_phi, &states[n_particle][0],
-                                          nstates[n_particle], &mixing_ratios[n_particle][0]))
-              ++max_w;
-          }
+          random_w = G4UniformRand() * max_w[n_particle];
+          const G4double w = kernels[n_particle](random_cos_theta, random_phi);
+
+          if (random_w <= w)
+            ++momentum_success;
+          if (max_w[n_particle] < w)
+            ++max_w_overflow_counter;
+          if (occurred_max_w < w)
+            occurred_max_w = w;
         }
 
         G4double p = (double)momentum_success / MAX_TRIES_MOMENTUM;
-        G4double pnot = (double)1. - p;
 
         G4cout << "Check finished. Of " << MAX_TRIES_MOMENTUM
                << " random 3D momentum vectors, " << momentum_success
                << " were valid ( " << p / perCent << " % )" << G4endl;
+        G4cout << "Acceptance rate of rejection sampling with MAX_W == " << max_w[n_particle] << (max_w_user > 0. ? " (user-defined)" : " (automatic)") << ": " << p / perCent << " %" << G4endl;
+        if (max_w_overflow_counter == 0) {
+          G4cout << "MAX_W == " << max_w[n_particle] << " seems to be high enough as the maximal occurred value of the angular distribution was " << occurred_max_w << G4endl;
+        } else {
+          p_max_w = (double)max_w_overflow_counter / MAX_TRIES_MOMENTUM;
+          G4cout << G4endl;
+          G4cout << "In " << max_w_overflow_counter << " out of " << MAX_TRIES_MOMENTUM << " cases (" << p_max_w / perCent << " % ) W(random_theta, random_phi) > MAX_W == " << max_w[n_particle] << " was valid. This may mean that MAX_W is set too low and the angular distribution is truncated." << G4endl;
+        }
+
+        if (use_envelope) {
+          momentum_success = 0;
+          max_w_overflow_counter = 0;
+          for (int i = 0; i < MAX_TRIES_MOMENTUM; i++) {
+            envelope_samplers[n_particle].Sample(G4UniformRand(), G4UniformRand(), random_cos_theta, random_phi, cell);
+            const G4double w = kernels[n_particle](random_cos_theta, random_phi);
+
+            if (G4UniformRand() * envelope_w[n_particle][cell] <= w)
+              ++momentum_success;
+            if (envelope_w[n_particle][cell] < w)
+              ++max_w_overflow_counter;
+          }
+
+          p = (double)momentum_success / MAX_TRIES_MOMENTUM;
+          G4cout << "Acceptance rate of rejection sampling with the piecewise envelope (" << envelope_samplers[n_particle].GetNCosTheta() << " x " << envelope_samplers[n_particle].GetNPhi() << " cells): " << p / perCent << " %" << G4endl;
+          if (max_w_overflow_counter > 0) {
+            G4cout << "In " << max_w_overflow_counter << " out of " << MAX_TRIES_MOMENTUM << " cases the angular distribution was larger than the piecewise envelope. This may mean that the angular distribution is truncated." << G4endl;
+          }
+        }
+
+        G4double pnot = (double)1. - p;
         G4cout << "Probability of failure:\tpow( " << pnot << ", "
                << MAX_TRIES_MOMENTUM
                << " ) = " << pow(pnot, MAX_TRIES_MOMENTUM) / perCent << " %"
                << G4endl;
-        if (max_w == 0) {
-          G4cout << "MAX_W == " << MAX_W << " seems to be high enough." << G4endl;
-        } else {
-          p_max_w = (double)max_w / MAX_TRIES_MOMENTUM;
-          G4cout << G4endl;
-          G4cout << "In " << max_w << " out of " << MAX_TRIES_MOMENTUM << " cases (" << p_max_w / perCent << " % ) W(random_theta, random_phi) == MAX_W == " << MAX_W << " was valid. This may mean that MAX_W is set too low and the angular distribution is truncated." << G4endl;
-        }
         G4cout << "============================================================"
                   "============"
                << G4endl << G4endl;
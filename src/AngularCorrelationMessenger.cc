@@ -163,6 +163,29 @@ AngularCorrelationMessenger::AngularCorrelationMessenger(
   sourcePVCmd->SetGuidance("Add physical volume as a particle source.");
   sourcePVCmd->SetParameterName("sourcePV", true);
   sourcePVCmd->SetDefaultValue("");
+
+  positionSamplerCmd = new G4UIcmdWithAString("/angcorr/positionSampler", this);
+  positionSamplerCmd->SetGuidance("Set the method to sample the position inside the source volumes.");
+  positionSamplerCmd->SetGuidance("box: Uniform sampling in the container box and lookup of the volume (default)");
+  positionSamplerCmd->SetGuidance("solid: Uniform sampling inside the solids of the source volumes, restricted to the container box");
+  positionSamplerCmd->SetParameterName("positionSampler", true);
+  positionSamplerCmd->SetCandidates("box solid");
+  positionSamplerCmd->SetDefaultValue("box");
+
+  samplerCmd = new G4UIcmdWithAString("/angcorr/sampler", this);
+  samplerCmd->SetGuidance("Set the method to sample the momentum directions.");
+  samplerCmd->SetGuidance("rejection: Rejection sampling with a constant envelope (default)");
+  samplerCmd->SetGuidance("envelope: Rejection sampling with a piecewise constant envelope over (cos(theta), phi) cells");
+  samplerCmd->SetParameterName("sampler", true);
+  samplerCmd->SetCandidates("rejection envelope");
+  samplerCmd->SetDefaultValue("rejection");
+
+  maxWCmd = new G4UIcmdWithADouble("/angcorr/maxW", this);
+  maxWCmd->SetGuidance("Set upper limit of the angular distributions for rejection sampling.");
+  maxWCmd->SetGuidance("Default: 0. (determine the maximum of each angular distribution automatically)");
+  maxWCmd->SetParameterName("maxW", true);
+  maxWCmd->SetRange("maxW >= 0.");
+  maxWCmd->SetDefaultValue(0.);
 }
 
 AngularCorrelationMessenger::~AngularCorrelationMessenger() {
@@ -274,6 +297,16 @@ void AngularCorrelationMessenger::SetNewValue(G4UIcommand *command,
   if (command == sourcePVCmd) {
     angularCorrelationGenerator->AddSourcePV(newValues);
   }
+  if (command == positionSamplerCmd) {
+    angularCorrelationGenerator->SetPositionSampler(newValues);
+  }
+  if (command == samplerCmd) {
+    angularCorrelationGenerator->SetUseEnvelope(newValues == "envelope");
+  }
+  if (command == maxWCmd) {
+    angularCorrelationGenerator->SetMaxW(
+        maxWCmd->GetNewDoubleValue(newValues));
+  }
 }
 
 G4String AngularCorrelationMessenger::GetCurrentValue(G4UIcommand *command) {
@@ -357,6 +390,16 @@ G4String AngularCorrelationMessenger::GetCurrentValue(G4UIcommand *command) {
     return polarizationCmd->ConvertToString(
         angularCorrelationGenerator->GetPolarization());
   }
+  if (command == positionSamplerCmd) {
+    return angularCorrelationGenerator->GetPositionSampler();
+  }
+  if (command == samplerCmd) {
+    return angularCorrelationGenerator->GetUseEnvelope() ? "envelope" : "rejection";
+  }
+  if (command == maxWCmd) {
+    return maxWCmd->ConvertToString(
+        angularCorrelationGenerator->GetMaxW());
+  }
 
   return cv;
 }
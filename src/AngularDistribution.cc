@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -948,3 +949,185 @@ double AngularDistribution::AngDist(
   cerr << "ERROR: AngularDistributionGenerator:: Required spin sequence not found." << endl;
   throw std::exception();
 }
+
+void AngularDistributionKernel::Evaluate(size_t n, const double *cos_theta, const double *cos_phi, const double *sin_phi, double *w) const {
+  if (!is_polynomial) {
+    double phi;
+    for (size_t i = 0; i < n; ++i) {
+      phi = atan2(sin_phi[i], cos_phi[i]);
+      w[i] = fallback(cos_theta[i], phi < 0. ? phi + 2. * M_PI : phi);
+    }
+    return;
+  }
+
+  const double a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3];
+  const double b0 = b[0], b1 = b[1], b2 = b[2], b3 = b[3];
+  for (size_t i = 0; i < n; ++i) {
+    const double cos_theta_2 = cos_theta[i] * cos_theta[i];
+    const double cos_two_phi = cos_phi[i] * cos_phi[i] - sin_phi[i] * sin_phi[i];
+    w[i] = a0 + cos_theta_2 * (a1 + cos_theta_2 * (a2 + cos_theta_2 * a3)) +
+           cos_two_phi * (b0 + cos_theta_2 * (b1 + cos_theta_2 * (b2 + cos_theta_2 * b3)));
+  }
+}
+
+// Maximum of the cubic polynomial p[0] + p[1] u + p[2] u^2 + p[3] u^3 in [u_min, u_max]
+static double cubic_maximum(const double *p, double u_min, double u_max) {
+  auto f = [p](double u) { return p[0] + u * (p[1] + u * (p[2] + u * p[3])); };
+
+  double maximum = std::max(f(u_min), f(u_max));
+
+  // Roots of the derivative p[1] + 2 p[2] u + 3 p[3] u^2
+  double roots[2];
+  int n_roots = 0;
+  if (std::abs(p[3]) > 1e-14 * (std::abs(p[1]) + std::abs(p[2]))) {
+    const double discriminant = 4. * p[2] * p[2] - 12. * p[3] * p[1];
+    if (discriminant >= 0.) {
+      roots[0] = (-2. * p[2] + sqrt(discriminant)) / (6. * p[3]);
+      roots[1] = (-2. * p[2] - sqrt(discriminant)) / (6. * p[3]);
+      n_roots = 2;
+    }
+  } else if (p[2] != 0.) {
+    roots[0] = -p[1] / (2. * p[2]);
+    n_roots = 1;
+  }
+
+  for (int i = 0; i < n_roots; ++i) {
+    if (roots[i] > u_min && roots[i] < u_max) {
+      maximum = std::max(maximum, f(roots[i]));
+    }
+  }
+
+  return maximum;
+}
+
+double AngularDistributionKernel::Maximum(double cos_theta_min, double cos_theta_max, double phi_min, double phi_max) const {
+  if (!is_polynomial) {
+    const int n_grid = 33;
+    double maximum = fallback(cos_theta_min, phi_min);
+    for (int i = 0; i < n_grid; ++i) {
+      const double cos_theta = cos_theta_min + (cos_theta_max - cos_theta_min) * i / (n_grid - 1);
+      for (int j = 0; j < n_grid; ++j) {
+        maximum = std::max(maximum, fallback(cos_theta, phi_min + (phi_max - phi_min) * j / (n_grid - 1)));
+      }
+    }
+    return maximum;
+  }
+
+  // Range of cos^2(theta) in the interval
+  const double u_max = std::max(cos_theta_min * cos_theta_min, cos_theta_max * cos_theta_max);
+  const double u_min = (cos_theta_min <= 0. && cos_theta_max >= 0.) ? 0. : std::min(cos_theta_min * cos_theta_min, cos_theta_max * cos_theta_max);
+
+  // Range of cos(2 phi) in the interval. The extrema +1 and -1 are at phi = k pi and
+  // phi = (k + 1/2) pi, respectively.
+  double c_min = std::min(cos(2. * phi_min), cos(2. * phi_max));
+  double c_max = std::max(cos(2. * phi_min), cos(2. * phi_max));
+  if (ceil(phi_min / M_PI) * M_PI <= phi_max) {
+    c_max = 1.;
+  }
+  if (ceil(phi_min / M_PI - 0.5) * M_PI + 0.5 * M_PI <= phi_max) {
+    c_min = -1.;
+  }
+
+  // W is linear in cos(2 phi), so the maximum is located at one of the limits of its range.
+  double p[n_coefficients];
+  double maximum;
+  for (int i = 0; i < n_coefficients; ++i) {
+    p[i] = a[i] + c_min * b[i];
+  }
+  maximum = cubic_maximum(p, u_min, u_max);
+  for (int i = 0; i < n_coefficients; ++i) {
+    p[i] = a[i] + c_max * b[i];
+  }
+
+  return std::max(maximum, cubic_maximum(p, u_min, u_max));
+}
+
+AngularDistributionKernel AngularDistribution::Resolve(const std::function<double(double, double)> &w) const {
+  const int n = AngularDistributionKernel::n_coefficients;
+
+  AngularDistributionKernel kernel;
+  kernel.fallback = w;
+
+  // Evaluate W at n equidistant values of cos^2(theta) for cos(2 phi) = +1 (phi = 0)
+  // and cos(2 phi) = -1 (phi = pi/2), which separates A and B.
+  double vandermonde_a[n][n];
+  double vandermonde_b[n][n];
+  for (int i = 0; i < n; ++i) {
+    const double cos_theta_2 = static_cast<double>(i) / (n - 1);
+    const double w_plus = w(sqrt(cos_theta_2), 0.);
+    const double w_minus = w(sqrt(cos_theta_2), 0.5 * M_PI);
+    kernel.a[i] = 0.5 * (w_plus + w_minus);
+    kernel.b[i] = 0.5 * (w_plus - w_minus);
+    for (int j = 0; j < n; ++j) {
+      vandermonde_a[i][j] = pow(cos_theta_2, j);
+      vandermonde_b[i][j] = vandermonde_a[i][j];
+    }
+  }
+
+  // Solve for the polynomial coefficients by Gaussian elimination. The nodes are fixed and
+  // well separated, so no pivoting is necessary.
+  for (int k = 0; k < n; ++k) {
+    for (int i = k + 1; i < n; ++i) {
+      const double factor_a = vandermonde_a[i][k] / vandermonde_a[k][k];
+      const double factor_b = vandermonde_b[i][k] / vandermonde_b[k][k];
+      for (int j = k; j < n; ++j) {
+        vandermonde_a[i][j] -= factor_a * vandermonde_a[k][j];
+        vandermonde_b[i][j] -= factor_b * vandermonde_b[k][j];
+      }
+      kernel.a[i] -= factor_a * kernel.a[k];
+      kernel.b[i] -= factor_b * kernel.b[k];
+    }
+  }
+  for (int k = n - 1; k >= 0; --k) {
+    for (int j = k + 1; j < n; ++j) {
+      kernel.a[k] -= vandermonde_a[k][j] * kernel.a[j];
+      kernel.b[k] -= vandermonde_b[k][j] * kernel.b[j];
+    }
+    kernel.a[k] /= vandermonde_a[k][k];
+    kernel.b[k] /= vandermonde_b[k][k];
+  }
+
+  // Verify the closed form on a grid which covers both hemispheres and avoids the nodes
+  // in phi, so that odd powers of cos(theta) or other dependencies on phi are detected.
+  const int n_test_cos_theta = 17;
+  const int n_test_phi = 13;
+  for (int i = 0; i < n_test_cos_theta; ++i) {
+    const double cos_theta = -1. + 2. * i / (n_test_cos_theta - 1);
+    for (int j = 0; j < n_test_phi; ++j) {
+      const double phi = 0.1 + 2. * M_PI * j / n_test_phi;
+      const double w_exact = w(cos_theta, phi);
+      if (std::abs(kernel.Polynomial(cos_theta * cos_theta, cos(2. * phi)) - w_exact) > 1e-9 * (1. + std::abs(w_exact))) {
+        kernel.is_polynomial = false;
+        return kernel;
+      }
+    }
+  }
+
+  return kernel;
+}
+
+AngularDistributionKernel AngularDistribution::Resolve(const double *st, int nst, const double *mix) const {
+  double states[4] = {st[0], st[1], st[2], nst > 3 ? st[3] : 0.};
+  double mixing_ratios[3] = {mix[0], mix[1], nst > 3 ? mix[2] : 0.};
+
+  // Fails here, and not at the first event, if the spin sequence is not implemented.
+  AngDist(0., 0., states, nst, mixing_ratios);
+
+  return Resolve([this, states, nst, mixing_ratios](double cos_theta, double phi) mutable {
+    return AngDist(acos(cos_theta), phi, states, nst, mixing_ratios);
+  });
+}
+
+AngularDistributionKernel AngularDistribution::Resolve(const double *st, const double *alt_st, int nst, const double *mix, double weight) const {
+  double states[4] = {st[0], st[1], st[2], nst > 3 ? st[3] : 0.};
+  double alt_states[4] = {alt_st[0], alt_st[1], alt_st[2], nst > 3 ? alt_st[3] : 0.};
+  double mixing_ratios[3] = {mix[0], mix[1], nst > 3 ? mix[2] : 0.};
+
+  AngDist(0., 0., states, nst, mixing_ratios);
+  AngDist(0., 0., alt_states, nst, mixing_ratios);
+
+  return Resolve([this, states, alt_states, nst, mixing_ratios, weight](double cos_theta, double phi) mutable {
+    const double theta = acos(cos_theta);
+    return weight * (AngDist(theta, phi, states, nst, mixing_ratios) + AngDist(theta, phi, alt_states, nst, mixing_ratios));
+  });
+}
@@ -18,9 +18,13 @@ You should have received a copy of the GNU General Public License
 along with utr.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+
 #include "G4Event.hh"
 #include "G4ParticleGun.hh"
 #include "G4ParticleTable.hh"
+#include "G4Run.hh"
+#include "G4RunManager.hh"
 #include "G4TransportationManager.hh"
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "Randomize.hh"
@@ -32,8 +36,13 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "AngularDistributionMessenger.hh"
 
 #define MAX_ALLOWED_FAIL_CHANCE 1e-6
+// Number of directions drawn from each sampler to compare them in the self-check
+#define N_SAMPLER_COMPARISON 100000
+// Number of cos(theta) and phi bins for the comparison of the samplers
+#define N_COMPARISON_BINS_COS_THETA 10
+#define N_COMPARISON_BINS_PHI 12
 
-AngularDistributionGenerator::AngularDistributionGenerator() : G4VUserPrimaryGeneratorAction(), particleGun(0), angdist(0), checked_position_generator(false) {
+AngularDistributionGenerator::AngularDistributionGenerator() : G4VUserPrimaryGeneratorAction(), particleGun(0), angdist(0), kernel_resolved(false), max_w(0.), max_w_user(0.), position_sampler_method(POSITION_SAMPLER_BOX), checked_position_generator(false), checked_momentum_generator(false), momentum_sampler_method(SAMPLER_REJECTION), table_bins(DEFAULT_TABLE_BINS), tabulated_run_id(-1), envelope_built(false) {
   angDistMessenger = new AngularDistributionMessenger(this);
   angdist = new AngularDistribution();
 
@@ -57,6 +66,94 @@ void AngularDistributionGenerator::GeneratePrimaries(G4Event *anEvent) {
   G4ThreeVector randomOrigin = G4ThreeVector(0., 0., 0.);
   G4ThreeVector randomDirection = G4ThreeVector(0., 0., 1.);
 
+  if (!kernel_resolved) {
+    resolve_kernel();
+  }
+
+  if (momentum_sampler_method == SAMPLER_TABLE) {
+    prepare_table_sampler();
+  } else if (momentum_sampler_method == SAMPLER_ENVELOPE) {
+    prepare_envelope_sampler();
+  }
+
+#ifdef CHECK_POSITION_GENERATOR
+  check_position_generator();
+#endif
+#ifdef CHECK_MOMENTUM_GENERATOR
+  check_momentum_generator();
+#endif
+
+#ifdef PROFILE_GENERATORS
+  // The one-time setup and the self-checks above are not included in the profile
+  profiler.BeginEvent();
+#endif
+
+  G4bool momentum_found = false;
+
+  if (!source_sampler.IsInitialized()) {
+    source_sampler.Initialize(source_PV_names, G4ThreeVector(source_x, source_y, source_z), G4ThreeVector(range_x, range_y, range_z), position_sampler_method, (G4int)MAX_TRIES_POSITION);
+  }
+
+#ifdef PROFILE_GENERATORS
+  const G4long position_trials = source_sampler.GetNTrials();
+  const G4long positions = source_sampler.GetNAccepted();
+#endif
+  G4bool position_found = source_sampler.Sample(randomOrigin);
+#ifdef PROFILE_GENERATORS
+  profiler.CountPositionTrials(source_sampler.GetNTrials() - position_trials, source_sampler.GetNAccepted() - positions);
+#endif
+  if (position_found) {
+    particleGun->SetParticlePosition(randomOrigin);
+  }
+
+  if (momentum_sampler_method == SAMPLER_TABLE) {
+    sample_momentum_table(randomDirection);
+    momentum_found = true;
+  } else if (momentum_sampler_method == SAMPLER_ENVELOPE) {
+    momentum_found = sample_momentum_envelope(randomDirection);
+  } else {
+    momentum_found = sample_momentum_rejection(randomDirection);
+  }
+  if (momentum_found) {
+    particleGun->SetParticleMomentumDirection(randomDirection);
+  }
+
+  if (!position_found)
+    G4cout << "Warning: AngularDistributionGenerator: Monte-Carlo method could not determine a starting point after " << MAX_TRIES_POSITION << " iterations" << G4endl;
+  if (!momentum_found)
+    G4cout << "Warning: AngularDistributionGenerator: Monte-Carlo method could not determine a starting velocity vector after " << MAX_TRIES_MOMENTUM << " iterations" << G4endl;
+
+  particleGun->GeneratePrimaryVertex(anEvent);
+
+#ifdef PROFILE_GENERATORS
+  profiler.EndEvent(1);
+#endif
+}
+
+void AngularDistributionGenerator::SetMomentumSampler(G4String sampler_name) {
+  if (sampler_name == "table") {
+    momentum_sampler_method = SAMPLER_TABLE;
+  } else if (sampler_name == "envelope") {
+    momentum_sampler_method = SAMPLER_ENVELOPE;
+  } else {
+    momentum_sampler_method = SAMPLER_REJECTION;
+  }
+  // The self-check also covers the selected sampler
+  checked_momentum_generator = false;
+}
+
+G4String AngularDistributionGenerator::GetMomentumSampler() {
+  switch (momentum_sampler_method) {
+  case SAMPLER_ENVELOPE:
+    return "envelope";
+  case SAMPLER_TABLE:
+    return "table";
+  default:
+    return "rejection";
+  }
+}
+
+void AngularDistributionGenerator::resolve_kernel() {
   for (G4int i = 0; i < 4; ++i)
     alt_states[i] = states[i];
   if (states[1] == 0.) {
@@ -67,79 +164,190 @@ void AngularDistributionGenerator::GeneratePrimaries(G4Event *anEvent) {
     alt_states[1] = -states[1];
   }
 
-#ifdef CHECK_POSITION_GENERATOR
-  check_position_generator();
-#endif
-#ifdef CHECK_MOMENTUM_GENERATOR
-  check_momentum_generator();
-#endif
+  if (is_polarized) {
+    kernel = angdist->Resolve(states, nstates, mixing_ratios);
+  } else {
+    kernel = angdist->Resolve(states, alt_states, nstates, mixing_ratios, 0.5);
+  }
 
-  G4bool position_found = false;
-  G4double random_x;
-  G4double random_y;
-  G4double random_z;
-  G4String pv;
+  if (!kernel.IsPolynomial()) {
+    G4cout << "Warning: AngularDistributionGenerator: No closed form found for the angular distribution, evaluating it directly." << G4endl;
+  }
 
-  G4bool momentum_found = false;
-  G4double random_theta;
-  G4double random_phi;
-  G4double random_w;
+  if (max_w_user > 0.) {
+    max_w = max_w_user;
+  } else {
+    max_w = kernel.Envelope();
+  }
+  if (max_w <= 0.) {
+    G4cerr << "ERROR: AngularDistributionGenerator: The angular distribution is not positive anywhere. Aborting..." << G4endl;
+    throw std::exception();
+  }
 
-  for (int i = 0; i < MAX_TRIES_POSITION; i++) {
-    random_x = (G4UniformRand() - 0.5) * range_x + source_x;
-    random_y = (G4UniformRand() - 0.5) * range_y + source_y;
-    random_z = (G4UniformRand() - 0.5) * range_z + source_z;
-    randomOrigin = G4ThreeVector(random_x, random_y, random_z);
+  kernel_resolved = true;
+  // Directions, envelope and table from the previous angular distribution are no longer valid
+  accepted_directions.clear();
+  envelope_built = false;
+  tabulated_run_id = -1;
+  checked_momentum_generator = false;
+}
 
-    pv = navi->LocateGlobalPointAndSetup(randomOrigin)->GetName();
+G4bool AngularDistributionGenerator::sample_momentum_rejection(G4ThreeVector &direction) {
+  if (accepted_directions.empty()) {
+    fill_momentum_buffer();
+  }
+#ifdef PROFILE_GENERATORS
+  profiler.CountBufferedMomentum(0, !accepted_directions.empty());
+#endif
+  if (accepted_directions.empty()) {
+    return false;
+  }
 
-    for (auto source_pv : source_PV_names) {
-      if (pv == source_pv) {
-        particleGun->SetParticlePosition(randomOrigin);
-        position_found = true;
-        break;
+  direction = accepted_directions.back();
+  accepted_directions.pop_back();
+  return true;
+}
+
+void AngularDistributionGenerator::fill_momentum_buffer() {
+  // All candidates are independent, so every accepted direction of a block is a valid
+  // sample. The ones which are not used in the current event are kept for the next events.
+  G4double random_cos_theta[MOMENTUM_BLOCK_SIZE];
+  G4double random_cos_phi[MOMENTUM_BLOCK_SIZE];
+  G4double random_sin_phi[MOMENTUM_BLOCK_SIZE];
+  G4double random_w[MOMENTUM_BLOCK_SIZE];
+  G4double w[MOMENTUM_BLOCK_SIZE];
+
+  for (int i = 0; i < MAX_TRIES_MOMENTUM; i += MOMENTUM_BLOCK_SIZE) {
+    for (int j = 0; j < MOMENTUM_BLOCK_SIZE; ++j) {
+      random_cos_theta[j] = 2. * G4UniformRand() - 1.;
+      random_unit_circle(random_cos_phi[j], random_sin_phi[j]);
+      random_w[j] = G4UniformRand() * max_w;
+    }
+
+    kernel.Evaluate(MOMENTUM_BLOCK_SIZE, random_cos_theta, random_cos_phi, random_sin_phi, w);
+
+    for (int j = 0; j < MOMENTUM_BLOCK_SIZE; ++j) {
+      if (random_w[j] <= w[j]) {
+        const G4double sin_theta = sqrt(1. - random_cos_theta[j] * random_cos_theta[j]);
+        accepted_directions.push_back(G4ThreeVector(sin_theta * random_cos_phi[j], sin_theta * random_sin_phi[j], random_cos_theta[j]));
       }
     }
 
-    if (position_found) {
-      break;
+#ifdef PROFILE_GENERATORS
+    // The buffer was empty before this block
+    profiler.CountBufferedMomentumTrials(0, MOMENTUM_BLOCK_SIZE, (G4long)accepted_directions.size());
+    profiler.CountWEvaluations(MOMENTUM_BLOCK_SIZE);
+#endif
+
+    if (!accepted_directions.empty()) {
+      return;
     }
   }
+}
 
-  for (int i = 0; i < MAX_TRIES_MOMENTUM; i++) {
-    random_theta = acos(2. * G4UniformRand() - 1.);
-    random_phi = twopi * G4UniformRand();
-    random_w = G4UniformRand() * MAX_W;
+void AngularDistributionGenerator::random_unit_circle(G4double &cos_phi, G4double &sin_phi) {
+  G4double x, y, r2;
+  do {
+    x = 2. * G4UniformRand() - 1.;
+    y = 2. * G4UniformRand() - 1.;
+    r2 = x * x + y * y;
+  } while (r2 > 1. || r2 == 0.);
+
+  const G4double r_inv = 1. / sqrt(r2);
+  cos_phi = x * r_inv;
+  sin_phi = y * r_inv;
+}
 
-    if (is_polarized) {
-      if (random_w <= angdist->AngDist(random_theta, random_phi, states, nstates, mixing_ratios))
-        momentum_found = true;
-    } else {
-      if (random_w <= (angdist->AngDist(random_theta, random_phi, states, nstates, mixing_ratios) + angdist->AngDist(random_theta, random_phi, alt_states, nstates, mixing_ratios)) / 2.)
-        momentum_found = true;
+G4bool AngularDistributionGenerator::sample_momentum_envelope(G4ThreeVector &direction) {
+  G4double random_cos_theta;
+  G4double random_phi;
+  size_t cell;
+
+  // The cell is selected with a probability proportional to its envelope, and the candidate
+  // is uniformly distributed inside the cell. Accepting it with a probability of
+  // W / envelope yields the angular distribution.
+  for (int i = 0; i < MAX_TRIES_MOMENTUM; ++i) {
+    envelope_sampler.Sample(G4UniformRand(), G4UniformRand(), random_cos_theta, random_phi, cell);
+#ifdef PROFILE_GENERATORS
+    profiler.CountWEvaluations(1);
+#endif
+    if (G4UniformRand() * envelope_w[cell] <= W(random_cos_theta, random_phi)) {
+#ifdef PROFILE_GENERATORS
+      profiler.CountMomentumTrials(i + 1, 1);
+#endif
+      const G4double sin_theta = sqrt(1. - random_cos_theta * random_cos_theta);
+      direction = G4ThreeVector(sin_theta * cos(random_phi), sin_theta * sin(random_phi), random_cos_theta);
+      return true;
     }
-    if (momentum_found) {
-      randomDirection = G4ThreeVector(sin(random_theta) * cos(random_phi), sin(random_theta) * sin(random_phi), cos(random_theta));
-      particleGun->SetParticleMomentumDirection(randomDirection);
-      break;
+  }
+
+#ifdef PROFILE_GENERATORS
+  profiler.CountMomentumTrials((G4long)MAX_TRIES_MOMENTUM, 0);
+#endif
+  return false;
+}
+
+void AngularDistributionGenerator::prepare_envelope_sampler() {
+  if (envelope_built) {
+    return;
+  }
+
+  const unsigned int n_cos_theta = ENVELOPE_BINS;
+  const unsigned int n_phi = 2 * ENVELOPE_BINS;
+  envelope_w.resize(n_cos_theta * n_phi);
+
+  for (unsigned int i = 0; i < n_cos_theta; ++i) {
+    for (unsigned int j = 0; j < n_phi; ++j) {
+      envelope_w[i * n_phi + j] = kernel.Envelope(-1. + 2. * i / n_cos_theta, -1. + 2. * (i + 1) / n_cos_theta, twopi * j / n_phi, twopi * (j + 1) / n_phi);
     }
   }
 
-  if (!position_found)
-    G4cout << "Warning: AngularDistributionGenerator: Monte-Carlo method could not determine a starting point after " << MAX_TRIES_POSITION << " iterations" << G4endl;
-  if (!momentum_found)
-    G4cout << "Warning: AngularDistributionGenerator: Monte-Carlo method could not determine a starting velocity vector after " << MAX_TRIES_MOMENTUM << " iterations" << G4endl;
+  if (!envelope_sampler.Build(envelope_w, n_cos_theta, n_phi)) {
+    G4cerr << "ERROR: AngularDistributionGenerator: The envelope of the angular distribution vanishes everywhere. Aborting..." << G4endl;
+    throw std::exception();
+  }
+  envelope_built = true;
+}
 
-  particleGun->GeneratePrimaryVertex(anEvent);
+void AngularDistributionGenerator::sample_momentum_table(G4ThreeVector &direction) {
+  G4double random_cos_theta;
+  G4double random_phi;
+
+  sampler.Sample(G4UniformRand(), G4UniformRand(), random_cos_theta, random_phi);
+#ifdef PROFILE_GENERATORS
+  profiler.CountMomentumTrials(1, 1);
+#endif
+
+  const G4double sin_theta = sqrt(1. - random_cos_theta * random_cos_theta);
+  direction = G4ThreeVector(sin_theta * cos(random_phi), sin_theta * sin(random_phi), random_cos_theta);
+}
+
+void AngularDistributionGenerator::prepare_table_sampler() {
+  // Tabulate the angular distribution once per run. Settings may only change between runs.
+  const G4int run_id = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+  if (sampler.IsTabulated() && tabulated_run_id == run_id) {
+    return;
+  }
+
+  const unsigned int n_cos_theta = (unsigned int)table_bins;
+  if (!sampler.Tabulate([this](double cos_theta, double phi) { return W(cos_theta, phi); }, n_cos_theta, 2 * n_cos_theta)) {
+    G4cerr << "ERROR: AngularDistributionGenerator: The angular distribution vanishes everywhere on the " << n_cos_theta << " x " << 2 * n_cos_theta << " grid of the tabulated sampler. Aborting..." << G4endl;
+    throw std::exception();
+  }
+  if (sampler.GetNNegative() > 0) {
+    G4cout << "Warning: AngularDistributionGenerator: The angular distribution was negative in " << sampler.GetNNegative() << " cells of the tabulated sampler. These cells were set to zero." << G4endl;
+  }
+  tabulated_run_id = run_id;
 }
 
 void AngularDistributionGenerator::check_momentum_generator() {
   if (checked_momentum_generator)
     return;
 
-  G4double random_theta;
+  G4double random_cos_theta;
   G4double random_phi;
   G4double random_w;
+  G4double w;
   G4int momentum_success = 0;
   unsigned int max_w_overflow_counter = 0;
   G4double occurred_max_w = -1.;
@@ -149,41 +357,58 @@ void AngularDistributionGenerator::check_momentum_generator() {
   G4cout << "Checking Monte-Carlo momentum generator with " << MAX_TRIES_MOMENTUM << " 3D vectors..." << G4endl;
 
   for (int i = 0; i < MAX_TRIES_MOMENTUM; i++) {
-    random_theta = acos(2. * G4UniformRand() - 1.);
+    random_cos_theta = 2. * G4UniformRand() - 1.;
     random_phi = twopi * G4UniformRand();
-    random_w = G4UniformRand() * MAX_W;
+    random_w = G4UniformRand() * max_w;
+    w = W(random_cos_theta, random_phi);
+
+    if (random_w <= w)
+      momentum_success++;
+    if (max_w < w)
+      max_w_overflow_counter++;
+    if (occurred_max_w < w)
+      occurred_max_w = w;
+  }
 
-    if (is_polarized) {
-      if (random_w <= angdist->AngDist(random_theta, random_phi, states, nstates, mixing_ratios))
-        momentum_success++;
-    } else {
-      if (random_w <= (angdist->AngDist(random_theta, random_phi, states, nstates, mixing_ratios) + angdist->AngDist(random_theta, random_phi, alt_states, nstates, mixing_ratios)) / 2.)
-        momentum_success++;
-    }
+  G4double p = (double)momentum_success / MAX_TRIES_MOMENTUM;
 
-    if (is_polarized) {
-      if (MAX_W < angdist->AngDist(random_theta, random_phi, states, nstates, mixing_ratios))
-        max_w_overflow_counter++;
-    } else {
-      if (MAX_W < (angdist->AngDist(random_theta, random_phi, states, nstates, mixing_ratios) + angdist->AngDist(random_theta, random_phi, alt_states, nstates, mixing_ratios)) / 2.)
-        max_w_overflow_counter++;
+  G4cout << "Check finished. Of " << MAX_TRIES_MOMENTUM
+         << " random 3D momentum vectors, " << momentum_success
+         << " were valid ( " << p / perCent << " % )" << G4endl;
+  G4cout << "Acceptance rate of rejection sampling with MAX_W == " << max_w << (max_w_user > 0. ? " (user-defined)" : " (automatic)") << ": " << p / perCent << " %" << G4endl;
+  if (max_w_overflow_counter == 0) {
+    G4cout << "MAX_W == " << max_w << " seems to be high enough as the maximal occurred value of the angular distribution was " << occurred_max_w << G4endl;
+  } else {
+    p_max_w = (double)max_w_overflow_counter / MAX_TRIES_MOMENTUM;
+    G4cout << G4endl;
+    G4cerr << "ERROR: In " << max_w_overflow_counter << " out of " << MAX_TRIES_MOMENTUM << " cases (" << p_max_w / perCent << " % ) W(random_theta, random_phi) > MAX_W == " << max_w << " was valid. This means that MAX_W is set too low and the angular distribution is truncated! The maximal occurred value of the angular distribution was " << occurred_max_w << ". Aborting..." << G4endl;
+    throw std::exception();
+  }
+
+  if (momentum_sampler_method == SAMPLER_ENVELOPE) {
+    size_t cell;
+    G4int envelope_success = 0;
+    unsigned int envelope_overflow_counter = 0;
+
+    for (int i = 0; i < MAX_TRIES_MOMENTUM; i++) {
+      envelope_sampler.Sample(G4UniformRand(), G4UniformRand(), random_cos_theta, random_phi, cell);
+      w = W(random_cos_theta, random_phi);
+
+      if (G4UniformRand() * envelope_w[cell] <= w)
+        envelope_success++;
+      if (envelope_w[cell] < w)
+        envelope_overflow_counter++;
     }
 
-    if (is_polarized) {
-      if (occurred_max_w < angdist->AngDist(random_theta, random_phi, states, nstates, mixing_ratios))
-        occurred_max_w = angdist->AngDist(random_theta, random_phi, states, nstates, mixing_ratios);
-    } else {
-      if (occurred_max_w < (angdist->AngDist(random_theta, random_phi, states, nstates, mixing_ratios) + angdist->AngDist(random_theta, random_phi, alt_states, nstates, mixing_ratios)) / 2.)
-        occurred_max_w = (angdist->AngDist(random_theta, random_phi, states, nstates, mixing_ratios) + angdist->AngDist(random_theta, random_phi, alt_states, nstates, mixing_ratios)) / 2.;
+    p = (double)envelope_success / MAX_TRIES_MOMENTUM;
+    G4cout << "Acceptance rate of rejection sampling with the piecewise envelope (" << envelope_sampler.GetNCosTheta() << " x " << envelope_sampler.GetNPhi() << " cells): " << p / perCent << " %" << G4endl;
+    if (envelope_overflow_counter > 0) {
+      G4cerr << "ERROR: In " << envelope_overflow_counter << " out of " << MAX_TRIES_MOMENTUM << " cases the angular distribution was larger than the piecewise envelope. This means that the angular distribution is truncated! Aborting..." << G4endl;
+      throw std::exception();
     }
   }
 
-  G4double p = (double)momentum_success / MAX_TRIES_MOMENTUM;
   G4double pnot = 1. - p;
-
-  G4cout << "Check finished. Of " << MAX_TRIES_MOMENTUM
-         << " random 3D momentum vectors, " << momentum_success
-         << " were valid ( " << p / perCent << " % )" << G4endl;
   G4cout << "Probability of failure: pow( " << pnot << ", "
          << MAX_TRIES_MOMENTUM
          << " ) = " << pow(pnot, MAX_TRIES_MOMENTUM) / perCent << " %"
@@ -192,16 +417,73 @@ void AngularDistributionGenerator::check_momentum_generator() {
     G4cerr << "ERROR: Probability of failure for Monte-Carlo momentum generation of " << pow(pnot, MAX_TRIES_MOMENTUM) / perCent << " % was deemed to high! Aborting..." << G4endl;
     throw std::exception();
   }
-  if (max_w_overflow_counter == 0) {
-    G4cout << "MAX_W == " << MAX_W << " seems to be high enough as the maximal occurred value of the angular distribution was " << occurred_max_w << G4endl;
+  G4cout << "========================================================================" << G4endl << G4endl;
+
+  if (momentum_sampler_method == SAMPLER_TABLE) {
+    compare_momentum_samplers();
+  }
+
+  checked_momentum_generator = true;
+}
+
+void AngularDistributionGenerator::compare_momentum_samplers() {
+  // Draw the same number of directions with the rejection method and from the table and
+  // compare the two samples with a chi^2 test for two binned distributions with equal
+  // numbers of entries.
+  vector<G4int> n_rejection(N_COMPARISON_BINS_COS_THETA * N_COMPARISON_BINS_PHI, 0);
+  vector<G4int> n_table(N_COMPARISON_BINS_COS_THETA * N_COMPARISON_BINS_PHI, 0);
+
+  G4cout << "========================================================================" << G4endl;
+  G4cout << "Comparing tabulated momentum sampler (" << sampler.GetNCosTheta() << " x " << sampler.GetNPhi() << " cells) to rejection sampling with " << N_SAMPLER_COMPARISON << " 3D vectors each..." << G4endl;
+
+  G4ThreeVector direction;
+  G4int bin_cos_theta, bin_phi;
+  G4int n_rejection_failed = 0;
+
+  for (int i = 0; i < N_SAMPLER_COMPARISON; ++i) {
+    if (!sample_momentum_rejection(direction)) {
+      ++n_rejection_failed;
+      continue;
+    }
+    bin_cos_theta = std::min((G4int)((direction.z() + 1.) * 0.5 * N_COMPARISON_BINS_COS_THETA), N_COMPARISON_BINS_COS_THETA - 1);
+    bin_phi = std::min((G4int)((direction.phi() < 0. ? direction.phi() + twopi : direction.phi()) / twopi * N_COMPARISON_BINS_PHI), N_COMPARISON_BINS_PHI - 1);
+    ++n_rejection[bin_cos_theta * N_COMPARISON_BINS_PHI + bin_phi];
+
+    sample_momentum_table(direction);
+    bin_cos_theta = std::min((G4int)((direction.z() + 1.) * 0.5 * N_COMPARISON_BINS_COS_THETA), N_COMPARISON_BINS_COS_THETA - 1);
+    bin_phi = std::min((G4int)((direction.phi() < 0. ? direction.phi() + twopi : direction.phi()) / twopi * N_COMPARISON_BINS_PHI), N_COMPARISON_BINS_PHI - 1);
+    ++n_table[bin_cos_theta * N_COMPARISON_BINS_PHI + bin_phi];
+  }
+
+  G4double chi2 = 0.;
+  G4int ndf = -1;
+  for (size_t i = 0; i < n_rejection.size(); ++i) {
+    if (n_rejection[i] + n_table[i] > 0) {
+      chi2 += pow(n_rejection[i] - n_table[i], 2) / (n_rejection[i] + n_table[i]);
+      ++ndf;
+    }
+  }
+
+  if (n_rejection_failed > 0) {
+    G4cout << "Warning: Rejection sampling failed for " << n_rejection_failed << " directions, which were omitted from the comparison." << G4endl;
+  }
+
+  if (ndf < 1) {
+    G4cout << "All directions fell into a single bin, no comparison possible." << G4endl;
+    G4cout << "========================================================================" << G4endl << G4endl;
+    return;
+  }
+
+  // Wilson-Hilferty approximation: (chi2/ndf)^(1/3) is approximately normally distributed
+  const G4double z = (pow(chi2 / ndf, 1. / 3.) - (1. - 2. / (9. * ndf))) / sqrt(2. / (9. * ndf));
+
+  G4cout << "Check finished. chi^2 / ndf = " << chi2 << " / " << ndf << " = " << chi2 / ndf << " ( " << z << " standard deviations from the expectation )" << G4endl;
+  if (z > 5.) {
+    G4cout << "Warning: The tabulated sampler deviates significantly from rejection sampling. Consider to increase the number of bins using /ang/tableBins." << G4endl;
   } else {
-    p_max_w = (double)max_w_overflow_counter / MAX_TRIES_MOMENTUM;
-    G4cout << G4endl;
-    G4cerr << "ERROR: In " << max_w_overflow_counter << " out of " << MAX_TRIES_MOMENTUM << " cases (" << p_max_w / perCent << " % ) W(random_theta, random_phi) > MAX_W == " << MAX_W << " was valid. This means that MAX_W is set too low and the angular distribution is truncated! The maximal occurred value of the angular distribution was " << occurred_max_w << ". Aborting..." << G4endl;
-    throw std::exception();
+    G4cout << "The tabulated sampler and rejection sampling are compatible." << G4endl;
   }
   G4cout << "========================================================================" << G4endl << G4endl;
-  checked_momentum_generator = true;
 }
 
 void AngularDistributionGenerator::check_position_generator() {
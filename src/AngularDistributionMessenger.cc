@@ -138,6 +138,37 @@ AngularDistributionMessenger::AngularDistributionMessenger(
   polarizationCmd->SetParameterName("is_polarized", true);
   polarizationCmd->SetDefaultValue(true);
 
+  samplerCmd = new G4UIcmdWithAString("/ang/sampler", this);
+  samplerCmd->SetGuidance("Set the method to sample the momentum direction.");
+  samplerCmd->SetGuidance("rejection: Rejection sampling with a constant envelope (default)");
+  samplerCmd->SetGuidance("envelope: Rejection sampling with a piecewise constant envelope over (cos(theta), phi) cells");
+  samplerCmd->SetGuidance("table: Inverse-CDF sampling from a table of the angular distribution, which is built once per run");
+  samplerCmd->SetParameterName("sampler", true);
+  samplerCmd->SetCandidates("rejection envelope table");
+  samplerCmd->SetDefaultValue("rejection");
+
+  tableBinsCmd = new G4UIcmdWithAnInteger("/ang/tableBins", this);
+  tableBinsCmd->SetGuidance("Set number of cos(theta) bins of the tabulated sampler. Twice as many bins are used for phi.");
+  tableBinsCmd->SetGuidance("Default: 256");
+  tableBinsCmd->SetParameterName("tableBins", true);
+  tableBinsCmd->SetRange("tableBins > 0");
+  tableBinsCmd->SetDefaultValue(DEFAULT_TABLE_BINS);
+
+  positionSamplerCmd = new G4UIcmdWithAString("/ang/positionSampler", this);
+  positionSamplerCmd->SetGuidance("Set the method to sample the position inside the source volumes.");
+  positionSamplerCmd->SetGuidance("box: Uniform sampling in the container box and lookup of the volume (default)");
+  positionSamplerCmd->SetGuidance("solid: Uniform sampling inside the solids of the source volumes, restricted to the container box");
+  positionSamplerCmd->SetParameterName("positionSampler", true);
+  positionSamplerCmd->SetCandidates("box solid");
+  positionSamplerCmd->SetDefaultValue("box");
+
+  maxWCmd = new G4UIcmdWithADouble("/ang/maxW", this);
+  maxWCmd->SetGuidance("Set upper limit of the angular distribution for rejection sampling.");
+  maxWCmd->SetGuidance("Default: 0. (determine the maximum of the angular distribution automatically)");
+  maxWCmd->SetParameterName("maxW", true);
+  maxWCmd->SetRange("maxW >= 0.");
+  maxWCmd->SetDefaultValue(0.);
+
   energyCmd = new G4UIcmdWithADoubleAndUnit("/ang/energy", this);
 
   angularDistributionGenerator->SetParticleDefinition(
@@ -254,6 +285,20 @@ void AngularDistributionMessenger::SetNewValue(G4UIcommand *command,
     angularDistributionGenerator->SetPolarized(
         polarizationCmd->GetNewBoolValue(newValues));
   }
+  if (command == samplerCmd) {
+    angularDistributionGenerator->SetMomentumSampler(newValues);
+  }
+  if (command == tableBinsCmd) {
+    angularDistributionGenerator->SetTableBins(
+        tableBinsCmd->GetNewIntValue(newValues));
+  }
+  if (command == positionSamplerCmd) {
+    angularDistributionGenerator->SetPositionSampler(newValues);
+  }
+  if (command == maxWCmd) {
+    angularDistributionGenerator->SetMaxW(
+        maxWCmd->GetNewDoubleValue(newValues));
+  }
 }
 
 G4String AngularDistributionMessenger::GetCurrentValue(G4UIcommand *command) {
@@ -337,6 +382,20 @@ G4String AngularDistributionMessenger::GetCurrentValue(G4UIcommand *command) {
     return polarizationCmd->ConvertToString(
         angularDistributionGenerator->IsPolarized());
   }
+  if (command == samplerCmd) {
+    return angularDistributionGenerator->GetMomentumSampler();
+  }
+  if (command == tableBinsCmd) {
+    return tableBinsCmd->ConvertToString(
+        angularDistributionGenerator->GetTableBins());
+  }
+  if (command == positionSamplerCmd) {
+    return angularDistributionGenerator->GetPositionSampler();
+  }
+  if (command == maxWCmd) {
+    return maxWCmd->ConvertToString(
+        angularDistributionGenerator->GetMaxW());
+  }
 
   return cv;
 }
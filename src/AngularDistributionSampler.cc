@@ -0,0 +1,120 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "AngularDistributionSampler.hh"
+
+bool AngularDistributionSampler::Tabulate(const std::function<double(double, double)> &w, unsigned int n_ct, unsigned int n_ph) {
+  if (n_ct == 0 || n_ph == 0) {
+    n_cos_theta = 0;
+    n_phi = 0;
+    return false;
+  }
+
+  const double d_cos_theta = 2. / n_ct;
+  const double d_phi = 2. * M_PI / n_ph;
+
+  vector<double> cell_weights(static_cast<size_t>(n_ct) * n_ph);
+  for (unsigned int i = 0; i < n_ct; ++i) {
+    const double cos_theta = -1. + (i + 0.5) * d_cos_theta;
+    for (unsigned int j = 0; j < n_ph; ++j) {
+      cell_weights[static_cast<size_t>(i) * n_ph + j] = w(cos_theta, (j + 0.5) * d_phi);
+    }
+  }
+
+  return Build(cell_weights, n_ct, n_ph);
+}
+
+bool AngularDistributionSampler::Build(const vector<double> &cell_weights, unsigned int n_ct, unsigned int n_ph) {
+  n_cos_theta = 0;
+  n_phi = 0;
+  n_negative = 0;
+
+  if (n_ct == 0 || n_ph == 0 || cell_weights.size() != static_cast<size_t>(n_ct) * n_ph) {
+    return false;
+  }
+
+  row_cdf.assign(n_ct + 1, 0.);
+  cell_cdf.assign(static_cast<size_t>(n_ct) * (n_ph + 1), 0.);
+
+  double w_cell;
+  for (unsigned int i = 0; i < n_ct; ++i) {
+    double *row = &cell_cdf[static_cast<size_t>(i) * (n_ph + 1)];
+
+    for (unsigned int j = 0; j < n_ph; ++j) {
+      w_cell = cell_weights[static_cast<size_t>(i) * n_ph + j];
+      if (w_cell < 0.) {
+        ++n_negative;
+        w_cell = 0.;
+      }
+      row[j + 1] = row[j] + w_cell;
+    }
+
+    row_cdf[i + 1] = row_cdf[i] + row[n_ph];
+
+    // Normalize the row. A row without any weight will never be selected, but it still
+    // gets a valid (flat) table to keep Sample() free of special cases.
+    if (row[n_ph] > 0.) {
+      const double norm = 1. / row[n_ph];
+      for (unsigned int j = 1; j < n_ph; ++j) {
+        row[j] *= norm;
+      }
+    } else {
+      for (unsigned int j = 1; j < n_ph; ++j) {
+        row[j] = static_cast<double>(j) / n_ph;
+      }
+    }
+    row[n_ph] = 1.;
+  }
+
+  if (row_cdf[n_ct] <= 0.) {
+    return false;
+  }
+
+  const double norm = 1. / row_cdf[n_ct];
+  for (unsigned int i = 1; i < n_ct; ++i) {
+    row_cdf[i] *= norm;
+  }
+  row_cdf[n_ct] = 1.;
+
+  n_cos_theta = n_ct;
+  n_phi = n_ph;
+
+  return true;
+}
+
+void AngularDistributionSampler::Sample(double random_1, double random_2, double &cos_theta, double &phi, size_t &cell) const {
+  // Find the interval [cdf[k], cdf[k+1]) which contains the random number. Intervals of
+  // zero width, i.e. cells without any weight, can never be selected this way.
+  auto row_it = std::upper_bound(row_cdf.begin() + 1, row_cdf.end() - 1, random_1) - 1;
+  const size_t i = static_cast<size_t>(row_it - row_cdf.begin());
+  const double row_fraction = (random_1 - row_it[0]) / (row_it[1] - row_it[0]);
+
+  const auto row_begin = cell_cdf.begin() + static_cast<long>(i * (n_phi + 1));
+  auto cell_it = std::upper_bound(row_begin + 1, row_begin + n_phi, random_2) - 1;
+  const size_t j = static_cast<size_t>(cell_it - row_begin);
+  const double cell_fraction = (random_2 - cell_it[0]) / (cell_it[1] - cell_it[0]);
+
+  cos_theta = -1. + (static_cast<double>(i) + row_fraction) * 2. / n_cos_theta;
+  phi = (static_cast<double>(j) + cell_fraction) * 2. * M_PI / n_phi;
+  cell = i * n_phi + j;
+}
@@ -30,6 +30,7 @@ using std::stringstream;
 #include "G4VisAttributes.hh"
 
 #include "CeBr3_2x2.hh"
+#include "utrRegionTools.hh"
 
 void CeBr3_2x2::Construct(G4ThreeVector global_coordinates, G4double theta, G4double phi, G4double dist_from_center, G4double intrinsic_rotation_angle) const {
   /*********** Dimensions ***********/
@@ -104,6 +105,7 @@ void CeBr3_2x2::Construct(G4ThreeVector global_coordinates, G4double theta, G4do
 
   auto *main_case_solid = new G4Tubs(detector_name + "_main_case_solid", 0., main_case_outer_radius, main_case_length / 2., 0., twopi);
   auto *main_case_logical = new G4LogicalVolume(main_case_solid, nist->FindOrBuildMaterial(main_case_material), detector_name + "_main_case_logical");
+  utrRegionTools::addLogicalVolume("detector", main_case_logical);
   main_case_logical->SetVisAttributes(G4Color::Grey());
   new G4PVPlacement(rotation_matrix, global_coordinates + (dist_from_center + main_case_length / 2.) * e_r, main_case_logical, detector_name + "_main_case", world_Logical, 0, 0, false);
 
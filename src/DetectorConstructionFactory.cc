@@ -0,0 +1,133 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DetectorConstructionFactory.hh"
+
+#include "G4UIcommand.hh"
+
+#include <algorithm>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <limits.h>
+#include <unistd.h>
+
+map<G4String, G4String> DetectorConstructionFactory::parameters = map<G4String, G4String>();
+const DetectorConstructionFactory::Entry *DetectorConstructionFactory::createdEntry = nullptr;
+const G4VUserDetectorConstruction *DetectorConstructionFactory::createdDetectorConstruction = nullptr;
+
+map<G4String, DetectorConstructionFactory::Entry> &DetectorConstructionFactory::registry() {
+  static map<G4String, Entry> geometries;
+  return geometries;
+}
+
+void DetectorConstructionFactory::Register(const G4String &name, Creator creator, MaxSensitiveDetectorIDGetter getter) {
+  registry()[name] = Entry{creator, getter};
+}
+
+// The modules are located in the directory 'geometries' next to the utr executable
+G4String DetectorConstructionFactory::moduleDirectory() {
+  char executable[PATH_MAX];
+  const ssize_t length = readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+  if (length <= 0) {
+    return "geometries";
+  }
+  executable[length] = '\0';
+  G4String directory(executable);
+  return directory.substr(0, directory.find_last_of('/')) + "/geometries";
+}
+
+G4bool DetectorConstructionFactory::loadModule(const G4String &name) {
+  const G4String filename = moduleDirectory() + "/" + name + ".so";
+  if (access(filename.c_str(), F_OK) != 0) {
+    return false;
+  }
+
+  // The Registrar of the geometry is constructed when the module is loaded.
+  // The module stays loaded until the end of the program.
+  if (dlopen(filename.c_str(), RTLD_NOW | RTLD_LOCAL) == nullptr) {
+    G4cerr << "ERROR: Could not load geometry module '" << filename << "': " << dlerror() << G4endl;
+    return false;
+  }
+  return registry().count(name) > 0;
+}
+
+vector<G4String> DetectorConstructionFactory::GetGeometries() {
+  vector<G4String> geometries;
+  for (const auto &geometry : registry()) {
+    geometries.push_back(geometry.first);
+  }
+
+  const G4String directory = moduleDirectory();
+  DIR *campaigns = opendir(directory.c_str());
+  if (campaigns != nullptr) {
+    for (dirent *campaign = readdir(campaigns); campaign != nullptr; campaign = readdir(campaigns)) {
+      const G4String campaignName = campaign->d_name;
+      DIR *modules = campaignName[0] == '.' ? nullptr : opendir((directory + "/" + campaignName).c_str());
+      if (modules == nullptr) {
+        continue;
+      }
+      for (dirent *module = readdir(modules); module != nullptr; module = readdir(modules)) {
+        const G4String moduleName = module->d_name;
+        if (moduleName.size() > 3 && moduleName.substr(moduleName.size() - 3) == ".so") {
+          const G4String geometry = campaignName + "/" + moduleName.substr(0, moduleName.size() - 3);
+          if (std::find(geometries.begin(), geometries.end(), geometry) == geometries.end()) {
+            geometries.push_back(geometry);
+          }
+        }
+      }
+      closedir(modules);
+    }
+    closedir(campaigns);
+  }
+
+  std::sort(geometries.begin(), geometries.end());
+  return geometries;
+}
+
+G4VUserDetectorConstruction *DetectorConstructionFactory::Create(const G4String &name) {
+  if (registry().count(name) == 0 && !loadModule(name)) {
+    G4cerr << "ERROR: Unknown geometry '" << name << "'. Available geometries are:" << G4endl;
+    for (const auto &geometry : GetGeometries()) {
+      G4cerr << "  " << geometry << G4endl;
+    }
+    G4cerr << "Aborting..." << G4endl;
+    throw std::exception();
+  }
+
+  createdEntry = &registry()[name];
+  G4VUserDetectorConstruction *detectorConstruction = createdEntry->creator();
+  createdDetectorConstruction = detectorConstruction;
+  return detectorConstruction;
+}
+
+unsigned int DetectorConstructionFactory::GetMaxSensitiveDetectorID() {
+  return createdEntry->getter(createdDetectorConstruction);
+}
+
+G4String DetectorConstructionFactory::GetParameter(const G4String &name, const G4String &defaultValue) {
+  const auto parameter = parameters.find(name);
+  const G4String value = parameter == parameters.end() ? defaultValue : parameter->second;
+  G4cout << "DetectorConstructionFactory: Geometry parameter " << name << " = '" << value << "'" << (parameter == parameters.end() ? " (default)" : "") << G4endl;
+  return value;
+}
+
+G4bool DetectorConstructionFactory::GetBoolParameter(const G4String &name, G4bool defaultValue) {
+  return G4UIcommand::ConvertToBool(GetParameter(name, defaultValue ? "true" : "false").c_str());
+}
@@ -19,9 +19,8 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "EnergyDepositionSD.hh"
-#include "DetectorConstruction.hh"
+#include "DetectorConstructionFactory.hh"
 #include "G4HCofThisEvent.hh"
-#include "G4RootAnalysisManager.hh"
 #include "G4RunManager.hh"
 #include "G4SDManager.hh"
 #include "G4Step.hh"
@@ -31,12 +30,19 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "G4ios.hh"
 #include "RunAction.hh"
 #include "TargetHit.hh"
+#include "utrBiasingTools.hh"
+#include "utrHistogramTools.hh"
+#include "utrOutputTools.hh"
 
 #include "utrConfig.h"
 
 EnergyDepositionSD::EnergyDepositionSD(const G4String &name,
                                        const G4String &hitsCollectionName)
-    : G4VSensitiveDetector(name), hitsCollection(NULL), detectorID(0), eventID(0) {
+    : G4VSensitiveDetector(name),
+#ifdef EDEP_HITS_COLLECTION
+      hitsCollection(NULL),
+#endif
+      detectorID(0), eventID(0) {
 
   collectionName.insert(hitsCollectionName);
 }
@@ -45,18 +51,56 @@ EnergyDepositionSD::~EnergyDepositionSD() {}
 
 void EnergyDepositionSD::Initialize(G4HCofThisEvent *hce) {
 
+#ifdef EDEP_HITS_COLLECTION
   hitsCollection =
       new TargetHitsCollection(SensitiveDetectorName, collectionName[0]);
 
   G4int hcID =
       G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
   hce->AddHitsCollection(hcID, hitsCollection);
+#else
+  (void)hce;
+#endif
 
   eventID = G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID();
+  depositions.clear();
 }
 
 G4bool EnergyDepositionSD::ProcessHits(G4Step *aStep, G4TouchableHistory *) {
 
+  // The output only needs the total energy deposition and the quantities of the first hit for each weight in
+  // each event, so they are accumulated here instead of allocating a TargetHit for each step
+  const G4double weight = aStep->GetTrack()->GetWeight();
+  WeightedDeposition *deposition = nullptr;
+  for (auto &d : depositions) {
+    if (d.weight == weight) {
+      deposition = &d;
+      break;
+    }
+  }
+
+  if (!deposition) {
+    G4Track *track = aStep->GetTrack();
+
+    depositions.emplace_back();
+    deposition = &depositions.back();
+    deposition->weight = weight;
+    deposition->energyDeposition = 0.;
+    deposition->kineticEnergy = aStep->GetPreStepPoint()->GetKineticEnergy();
+    deposition->particleType = 0;
+    if (utrOutputTools::recordsParticle()) {
+      deposition->particleType = track->GetDefinition()->GetPDGEncoding();
+    }
+    if (utrOutputTools::recordsPosition()) {
+      deposition->position = track->GetPosition();
+    }
+    if (utrOutputTools::recordsMomentum()) {
+      deposition->momentum = track->GetMomentum();
+    }
+  }
+  deposition->energyDeposition += aStep->GetTotalEnergyDeposit();
+
+#ifdef EDEP_HITS_COLLECTION
   TargetHit *hit = new TargetHit();
 
   G4Track *track = aStep->GetTrack();
@@ -70,6 +114,7 @@ G4bool EnergyDepositionSD::ProcessHits(G4Step *aStep, G4TouchableHistory *) {
   hit->SetMomentum(track->GetMomentum());
 
   hitsCollection->insert(hit);
+#endif
 
   return true;
 }
@@ -77,75 +122,77 @@ G4bool EnergyDepositionSD::ProcessHits(G4Step *aStep, G4TouchableHistory *) {
 // Initialize static member needed for EVENT_EVENTWISE mode, actual initialization values is, however, set in utr.cc
 std::vector<bool> EnergyDepositionSD::anyDetectorHitInEvent = std::vector<bool>();
 
+// Thread-local buffers for EVENT_EVENTWISE_SPARSE mode, created by the first call of the getters in each thread
+G4ThreadLocal std::vector<G4int> *EnergyDepositionSD::hitDetectorIDs = 0;
+G4ThreadLocal std::vector<sparse_edep_type> *EnergyDepositionSD::hitEnergyDepositions = 0;
+
+std::vector<G4int> &EnergyDepositionSD::GetHitDetectorIDs() {
+  if (!hitDetectorIDs) {
+    hitDetectorIDs = new std::vector<G4int>();
+  }
+  return *hitDetectorIDs;
+}
+
+std::vector<sparse_edep_type> &EnergyDepositionSD::GetHitEnergyDepositions() {
+  if (!hitEnergyDepositions) {
+    hitEnergyDepositions = new std::vector<sparse_edep_type>();
+  }
+  return *hitEnergyDepositions;
+}
+
 void EnergyDepositionSD::EndOfEvent(G4HCofThisEvent *) {
 
-  G4int nHits = hitsCollection->entries();
-  G4double totalEnergyDeposition = 0.;
+#ifdef FORCED_INTERACTION
+  for (const auto &deposition : depositions) {
+    if (deposition.energyDeposition > 0.) {
+      utrBiasingTools::addHit(deposition.weight);
+    }
+  }
+#endif
 
-  for (G4int i = 0; i < nHits; i++) {
-    totalEnergyDeposition += (*hitsCollection)[i]->GetEnergyDeposition();
+#if defined(EVENT_EVENTWISE_SPARSE) || defined(EVENT_EVENTWISE)
+  // The eventwise layouts have no weights (see utrConfig.h), so the depositions are summed
+  G4double totalEnergyDeposition = 0.;
+  for (const auto &deposition : depositions) {
+    totalEnergyDeposition += deposition.energyDeposition;
   }
+#endif
 
-#ifdef EVENT_EVENTWISE
-  G4RootAnalysisManager *analysisManager = G4RootAnalysisManager::Instance();
+#if defined(EVENT_HISTOGRAM)
+  for (const auto &deposition : depositions) {
+    if (deposition.energyDeposition > 0.) {
+      utrHistogramTools::addEnergyDeposition(GetDetectorID(), deposition.energyDeposition, deposition.weight);
+    }
+  }
+#elif defined(EVENT_EVENTWISE_SPARSE)
   if (totalEnergyDeposition > 0.) {
-    analysisManager->FillNtupleDColumn(0, GetDetectorID(), totalEnergyDeposition);
+    GetHitDetectorIDs().push_back(GetDetectorID());
+    GetHitEnergyDepositions().push_back((sparse_edep_type)totalEnergyDeposition);
+  }
+#elif defined(EVENT_EVENTWISE)
+  if (totalEnergyDeposition > 0.) {
+    RunAction::FillRealColumn(GetDetectorID(), totalEnergyDeposition);
     anyDetectorHitInEvent[G4Threading::G4GetThreadId()] = true;
   }
-  if (anyDetectorHitInEvent[G4Threading::G4GetThreadId()] && GetDetectorID() == ((DetectorConstruction *)G4RunManager::GetRunManager()->GetUserDetectorConstruction())->Max_Sensitive_Detector_ID) {
-    analysisManager->AddNtupleRow();
+  if (anyDetectorHitInEvent[G4Threading::G4GetThreadId()] && GetDetectorID() == DetectorConstructionFactory::GetMaxSensitiveDetectorID()) {
+    RunAction::AddNtupleRow();
     anyDetectorHitInEvent[G4Threading::G4GetThreadId()] = false;
   }
 #else
-  if (totalEnergyDeposition > 0.) {
-    G4RootAnalysisManager *analysisManager = G4RootAnalysisManager::Instance();
-
-    unsigned int nentry = 0;
-
-#ifdef EVENT_ID
-    analysisManager->FillNtupleDColumn(nentry, eventID);
-    ++nentry;
-#endif
-#ifdef EVENT_EDEP
-    analysisManager->FillNtupleDColumn(nentry, totalEnergyDeposition);
-    ++nentry;
-#endif
-#ifdef EVENT_EKIN
-    analysisManager->FillNtupleDColumn(nentry, (*hitsCollection)[0]->GetKineticEnergy());
-    ++nentry;
-#endif
-#ifdef EVENT_PARTICLE
-    analysisManager->FillNtupleDColumn(nentry, (*hitsCollection)[0]->GetParticleType());
-    ++nentry;
-#endif
-#ifdef EVENT_VOLUME
-    analysisManager->FillNtupleDColumn(nentry, GetDetectorID());
-    ++nentry;
-#endif
-#ifdef EVENT_POSX
-    analysisManager->FillNtupleDColumn(nentry, (*hitsCollection)[0]->GetPosition().x());
-    ++nentry;
-#endif
-#ifdef EVENT_POSY
-    analysisManager->FillNtupleDColumn(nentry, (*hitsCollection)[0]->GetPosition().y());
-    ++nentry;
-#endif
-#ifdef EVENT_POSZ
-    analysisManager->FillNtupleDColumn(nentry, (*hitsCollection)[0]->GetPosition().z());
-    ++nentry;
-#endif
-#ifdef EVENT_MOMX
-    analysisManager->FillNtupleDColumn(nentry, (*hitsCollection)[0]->GetMomentum().x());
-    ++nentry;
-#endif
-#ifdef EVENT_MOMY
-    analysisManager->FillNtupleDColumn(nentry, (*hitsCollection)[0]->GetMomentum().y());
-    ++nentry;
-#endif
-#ifdef EVENT_MOMZ
-    analysisManager->FillNtupleDColumn(nentry, (*hitsCollection)[0]->GetMomentum().z());
-#endif
-    analysisManager->AddNtupleRow();
+  // One row for each weight
+  for (const auto &deposition : depositions) {
+    if (deposition.energyDeposition > 0.) {
+      OutputRecord record;
+      record.eventID = eventID;
+      record.edep = deposition.energyDeposition;
+      record.ekin = deposition.kineticEnergy;
+      record.particle = deposition.particleType;
+      record.volume = GetDetectorID();
+      record.position = deposition.position;
+      record.momentum = deposition.momentum;
+      record.weight = deposition.weight;
+      utrOutputTools::fill(record);
+    }
   }
 #endif
 }
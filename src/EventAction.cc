@@ -19,7 +19,8 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "EventAction.hh"
-#include "DetectorConstruction.hh"
+#include "EnergyDepositionSD.hh"
+#include "RunAction.hh"
 #include "G4Event.hh"
 #include "G4MTRunManager.hh"
 #include "G4RunManager.hh"
@@ -27,6 +28,7 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "G4LogicalVolume.hh"
 #include "utrConfig.h"
+#include "utrHistogramTools.hh"
 
 using std::setw;
 using std::string;
@@ -40,6 +42,19 @@ EventAction::EventAction() : n_threads(1) {}
 EventAction::~EventAction() {}
 
 void EventAction::EndOfEventAction(const G4Event *event) {
+#if defined(EVENT_HISTOGRAM)
+  // The sensitive detectors have buffered their energy depositions at this point
+  utrHistogramTools::fillEvent();
+#elif defined(EVENT_EVENTWISE_SPARSE)
+  // The sensitive detectors have appended their energy depositions at this point, write a single row if any detector was hit
+  std::vector<G4int> &hitDetectorIDs = EnergyDepositionSD::GetHitDetectorIDs();
+  if (!hitDetectorIDs.empty()) {
+    RunAction::AddNtupleRow();
+    hitDetectorIDs.clear();
+    EnergyDepositionSD::GetHitEnergyDepositions().clear();
+  }
+#endif
+
   int eID = event->GetEventID();
   if (0 == (eID % print_progress)) {
 #ifdef G4MULTITHREADED
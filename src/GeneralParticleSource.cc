@@ -30,5 +30,12 @@ GeneralParticleSource::GeneralParticleSource()
 GeneralParticleSource::~GeneralParticleSource() { delete particleGun; }
 
 void GeneralParticleSource::GeneratePrimaries(G4Event *anEvent) {
+#ifdef PROFILE_GENERATORS
+  // G4GeneralParticleSource does not expose its trials, only the time is measured
+  profiler.BeginEvent();
+#endif
   particleGun->GeneratePrimaryVertex(anEvent);
+#ifdef PROFILE_GENERATORS
+  profiler.EndEvent(anEvent->GetNumberOfPrimaryVertex());
+#endif
 }
@@ -28,15 +28,18 @@ using std::stringstream;
 
 #include "G4Box.hh"
 #include "G4Color.hh"
+#include "G4IntersectionSolid.hh"
 #include "G4NistManager.hh"
 #include "G4PVPlacement.hh"
 #include "G4PhysicalConstants.hh"
+#include "G4Polycone.hh"
 #include "G4SubtractionSolid.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4Tubs.hh"
 #include "G4VisAttributes.hh"
 
 #include "HPGe_Clover.hh"
+#include "utrRegionTools.hh"
 
 void HPGe_Clover::Construct(G4ThreeVector global_coordinates, G4double theta, G4double phi, G4double dist_from_center, G4double intrinsic_rotation_angle) const {
 
@@ -54,6 +57,7 @@ void HPGe_Clover::Construct(G4ThreeVector global_coordinates, G4double theta, G4
 
   G4VSolid *end_cap_front_solid = rounded_box("_end_cap_front_solid", properties.end_cap_front_side_length, properties.end_cap_front_length, properties.end_cap_front_rounding_radius, 20);
   G4LogicalVolume *end_cap_front_logical = new G4LogicalVolume(end_cap_front_solid, nist->FindOrBuildMaterial(properties.end_cap_material), detector_name + "_end_cap_front_logical");
+  utrRegionTools::addLogicalVolume("detector", end_cap_front_logical);
   new G4PVPlacement(rotation, global_coordinates + (dist_from_center + 0.5 * properties.end_cap_front_length) * symmetry_axis, end_cap_front_logical, detector_name + "_end_cap_front", world_Logical, 0, 0, false);
 
   /******** Vacuum around crystal ********/
@@ -74,34 +78,27 @@ void HPGe_Clover::Construct(G4ThreeVector global_coordinates, G4double theta, G4
 
   /******** Crystals ********/
 
-  G4Tubs *crystal_full_solid = new G4Tubs(detector_name + "_crystal_full_solid", 0., properties.crystal_radius, properties.crystal_length * 0.5, 0., twopi);
-  G4Tubs *anode_solid = new G4Tubs(detector_name + "_anode_solid", 0., properties.anode_radius, properties.anode_length * 0.5, 0., twopi);
-  G4SubtractionSolid *crystal_original = new G4SubtractionSolid(detector_name + "_crystal_original", crystal_full_solid, anode_solid, 0, G4ThreeVector(0., 0., 0.5 * properties.crystal_length - 0.5 * properties.anode_length));
-  G4Box *subtraction_solid = new G4Box(detector_name + "_subtraction_solid", properties.crystal_radius, properties.crystal_radius, properties.crystal_length);
-  G4SubtractionSolid *crystal_step1_solid = new G4SubtractionSolid(detector_name + "_crystal_step1_solid", crystal_original, subtraction_solid, 0, G4ThreeVector(properties.crystal_radius + 23. * mm, 0., 0.));
-  G4SubtractionSolid *crystal_step2_solid = new G4SubtractionSolid(detector_name + "_crystal_step2_solid", crystal_step1_solid, subtraction_solid, 0, G4ThreeVector(-properties.crystal_radius - 22. * mm, 0., 0.));
-  G4SubtractionSolid *crystal_step3_solid = new G4SubtractionSolid(detector_name + "_crystal_step3_solid", crystal_step2_solid, subtraction_solid, 0, G4ThreeVector(0., -properties.crystal_radius - 22. * mm, 0.));
-  G4SubtractionSolid *crystal_step4_solid = new G4SubtractionSolid(detector_name + "_crystal_step4_solid", crystal_step3_solid, subtraction_solid, 0, G4ThreeVector(0., properties.crystal_radius + 23. * mm, 0.));
+  G4VSolid *crystal_final_solid = use_subtraction_crystals ? crystal_solid_subtraction() : crystal_solid();
 
-  G4LogicalVolume *crystal1_logical = new G4LogicalVolume(crystal_step4_solid, nist->FindOrBuildMaterial("G4_Ge"), detector_name + "_1");
+  G4LogicalVolume *crystal1_logical = new G4LogicalVolume(crystal_final_solid, nist->FindOrBuildMaterial("G4_Ge"), detector_name + "_1");
   crystal1_logical->SetVisAttributes(new G4VisAttributes(G4Color::Blue()));
   new G4PVPlacement(0, G4ThreeVector(22. * mm + 0.5 * properties.crystal_gap, 22. * mm + 0.5 * properties.crystal_gap, -0.5 * properties.vacuum_length + 0.5 * properties.crystal_length + properties.end_cap_to_crystal_gap_front), crystal1_logical, detector_name + "_crystal_1", vacuum_logical, 0, 0, false);
 
   G4RotationMatrix *rotate2 = new G4RotationMatrix();
   rotate2->rotateZ(-90. * deg);
-  G4LogicalVolume *crystal2_logical = new G4LogicalVolume(crystal_step4_solid, nist->FindOrBuildMaterial("G4_Ge"), detector_name + "_2");
+  G4LogicalVolume *crystal2_logical = new G4LogicalVolume(crystal_final_solid, nist->FindOrBuildMaterial("G4_Ge"), detector_name + "_2");
   crystal2_logical->SetVisAttributes(new G4VisAttributes(G4Color::Red()));
   new G4PVPlacement(rotate2, G4ThreeVector(-22. * mm - 0.5 * properties.crystal_gap, 22. * mm + 0.5 * properties.crystal_gap, -0.5 * properties.vacuum_length + 0.5 * properties.crystal_length + properties.end_cap_to_crystal_gap_front), crystal2_logical, detector_name + "_crystal_2", vacuum_logical, 0, 0, false);
 
   G4RotationMatrix *rotate3 = new G4RotationMatrix();
   rotate3->rotateZ(-180. * deg);
-  G4LogicalVolume *crystal3_logical = new G4LogicalVolume(crystal_step4_solid, nist->FindOrBuildMaterial("G4_Ge"), detector_name + "_3");
+  G4LogicalVolume *crystal3_logical = new G4LogicalVolume(crystal_final_solid, nist->FindOrBuildMaterial("G4_Ge"), detector_name + "_3");
   crystal3_logical->SetVisAttributes(new G4VisAttributes(G4Color::Green()));
   new G4PVPlacement(rotate3, G4ThreeVector(-22. * mm - 0.5 * properties.crystal_gap, -22. * mm - 0.5 * properties.crystal_gap, -0.5 * properties.vacuum_length + 0.5 * properties.crystal_length + properties.end_cap_to_crystal_gap_front), crystal3_logical, detector_name + "_crystal_3", vacuum_logical, 0, 0, false);
 
   G4RotationMatrix *rotate4 = new G4RotationMatrix();
   rotate4->rotateZ(-270. * deg);
-  G4LogicalVolume *crystal4_logical = new G4LogicalVolume(crystal_step4_solid, nist->FindOrBuildMaterial("G4_Ge"), detector_name + "_4");
+  G4LogicalVolume *crystal4_logical = new G4LogicalVolume(crystal_final_solid, nist->FindOrBuildMaterial("G4_Ge"), detector_name + "_4");
   crystal4_logical->SetVisAttributes(new G4VisAttributes(G4Color::Brown()));
   new G4PVPlacement(rotate4, G4ThreeVector(22. * mm + 0.5 * properties.crystal_gap, -22. * mm - 0.5 * properties.crystal_gap, -0.5 * properties.vacuum_length + 0.5 * properties.crystal_length + properties.end_cap_to_crystal_gap_front), crystal4_logical, detector_name + "_crystal_4", vacuum_logical, 0, 0, false);
 
@@ -169,6 +166,39 @@ void HPGe_Clover::Construct(G4ThreeVector global_coordinates, G4double theta, G4
   Construct(global_coordinates, theta, phi, dist_from_center, 0.);
 }
 
+G4VSolid *HPGe_Clover::crystal_solid() const {
+  // The anode hole is a step of the inner radius of the polycone
+  const G4double anode_start = 0.5 * properties.crystal_length - properties.anode_length;
+  vector<G4double> z_planes, r_inner;
+  if (properties.anode_radius <= 0. || properties.anode_length <= 0.) {
+    z_planes = {-0.5 * properties.crystal_length, 0.5 * properties.crystal_length};
+    r_inner = {0., 0.};
+  } else if (anode_start <= -0.5 * properties.crystal_length) {
+    z_planes = {-0.5 * properties.crystal_length, 0.5 * properties.crystal_length};
+    r_inner = {properties.anode_radius, properties.anode_radius};
+  } else {
+    z_planes = {-0.5 * properties.crystal_length, anode_start, anode_start, 0.5 * properties.crystal_length};
+    r_inner = {0., 0., properties.anode_radius, properties.anode_radius};
+  }
+  vector<G4double> r_outer(z_planes.size(), properties.crystal_radius);
+  G4Polycone *crystal_full_solid = new G4Polycone(detector_name + "_crystal_full_solid", 0., twopi, (G4int)z_planes.size(), z_planes.data(), r_inner.data(), r_outer.data());
+
+  // Same flat sides at x = -22 mm, x = 23 mm, y = -22 mm and y = 23 mm as in crystal_solid_subtraction
+  G4Box *intersection_solid = new G4Box(detector_name + "_intersection_solid", 22.5 * mm, 22.5 * mm, properties.crystal_length);
+  return new G4IntersectionSolid(detector_name + "_crystal_solid", crystal_full_solid, intersection_solid, 0, G4ThreeVector(0.5 * mm, 0.5 * mm, 0.));
+}
+
+G4VSolid *HPGe_Clover::crystal_solid_subtraction() const {
+  G4Tubs *crystal_full_solid = new G4Tubs(detector_name + "_crystal_full_solid", 0., properties.crystal_radius, properties.crystal_length * 0.5, 0., twopi);
+  G4Tubs *anode_solid = new G4Tubs(detector_name + "_anode_solid", 0., properties.anode_radius, properties.anode_length * 0.5, 0., twopi);
+  G4SubtractionSolid *crystal_original = new G4SubtractionSolid(detector_name + "_crystal_original", crystal_full_solid, anode_solid, 0, G4ThreeVector(0., 0., 0.5 * properties.crystal_length - 0.5 * properties.anode_length));
+  G4Box *subtraction_solid = new G4Box(detector_name + "_subtraction_solid", properties.crystal_radius, properties.crystal_radius, properties.crystal_length);
+  G4SubtractionSolid *crystal_step1_solid = new G4SubtractionSolid(detector_name + "_crystal_step1_solid", crystal_original, subtraction_solid, 0, G4ThreeVector(properties.crystal_radius + 23. * mm, 0., 0.));
+  G4SubtractionSolid *crystal_step2_solid = new G4SubtractionSolid(detector_name + "_crystal_step2_solid", crystal_step1_solid, subtraction_solid, 0, G4ThreeVector(-properties.crystal_radius - 22. * mm, 0., 0.));
+  G4SubtractionSolid *crystal_step3_solid = new G4SubtractionSolid(detector_name + "_crystal_step3_solid", crystal_step2_solid, subtraction_solid, 0, G4ThreeVector(0., -properties.crystal_radius - 22. * mm, 0.));
+  return new G4SubtractionSolid(detector_name + "_crystal_step4_solid", crystal_step3_solid, subtraction_solid, 0, G4ThreeVector(0., properties.crystal_radius + 23. * mm, 0.));
+}
+
 G4VSolid *HPGe_Clover::rounded_box(const G4String name, const G4double side_length, const G4double length, const G4double rounding_radius, const G4int n_points_per_corner) const {
 
   G4double inverse_n_points_per_corner = 1. / (n_points_per_corner - 1.);
@@ -31,6 +31,7 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "Filter_Case.hh"
 #include "HPGe_Coaxial.hh"
 #include "OptimizePolycone.hh"
+#include "utrRegionTools.hh"
 
 using std::stringstream;
 
@@ -55,18 +56,21 @@ void HPGe_Coaxial::Construct(G4ThreeVector global_coordinates, G4double theta, G
 
   G4Tubs *end_cap_side_solid = new G4Tubs(detector_name + "_end_cap_side_solid", end_cap_inner_radius, end_cap_outer_radius, end_cap_side_length * 0.5, 0., twopi);
   G4LogicalVolume *end_cap_side_logical = new G4LogicalVolume(end_cap_side_solid, nist->FindOrBuildMaterial(properties.end_cap_material), detector_name + "_end_cap_side_logical");
+  utrRegionTools::addLogicalVolume("detector", end_cap_side_logical);
   end_cap_side_logical->SetVisAttributes(new G4VisAttributes(G4Color::White()));
   new G4PVPlacement(rotation, global_coordinates + (dist_from_center + properties.end_cap_window_thickness + end_cap_side_length * 0.5) * symmetry_axis, end_cap_side_logical, detector_name + "_end_cap_side", world_Logical, 0, 0, false);
 
   // End cap window
   G4Tubs *end_cap_window_solid = new G4Tubs(detector_name + "_end_cap_window_solid", 0., end_cap_outer_radius, properties.end_cap_window_thickness * 0.5, 0., twopi);
   G4LogicalVolume *end_cap_window_logical = new G4LogicalVolume(end_cap_window_solid, nist->FindOrBuildMaterial(properties.end_cap_window_material), detector_name + "_end_cap_window_logical");
+  utrRegionTools::addLogicalVolume("detector", end_cap_window_logical);
   end_cap_window_logical->SetVisAttributes(new G4VisAttributes(G4Color::White()));
   new G4PVPlacement(rotation, global_coordinates + (dist_from_center + properties.end_cap_window_thickness * 0.5) * symmetry_axis, end_cap_window_logical, detector_name + "_end_cap_window", world_Logical, 0, 0, false);
 
   // Vacuum inside end cap
   G4Tubs *end_cap_vacuum_solid = new G4Tubs(detector_name + "_end_cap_vacuum_solid", 0., end_cap_inner_radius, end_cap_side_length * 0.5, 0., twopi);
   G4LogicalVolume *end_cap_vacuum_logical = new G4LogicalVolume(end_cap_vacuum_solid, nist->FindOrBuildMaterial("G4_Galactic"), detector_name + "_end_cap_vacuum_logical");
+  utrRegionTools::addLogicalVolume("detector", end_cap_vacuum_logical);
   end_cap_vacuum_logical->SetVisAttributes(G4VisAttributes::GetInvisible());
   new G4PVPlacement(rotation, global_coordinates + (dist_from_center + properties.end_cap_window_thickness + end_cap_side_length * 0.5) * symmetry_axis, end_cap_vacuum_logical, detector_name + "_end_cap_vacuum", world_Logical, 0, 0, false);
 
@@ -35,6 +35,7 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "Filter_Case.hh"
 #include "LaBr_3x3.hh"
 #include "Units.hh"
+#include "utrRegionTools.hh"
 
 using std::stringstream;
 
@@ -89,6 +90,7 @@ void LaBr_3x3::Construct(G4ThreeVector global_coordinates, G4double theta, G4dou
 
   auto *crystal_housing_solid = new G4Tubs(detector_name + "_crystal_housing_solid", 0., crystal_housing_outer_radius, crystal_housing_length / 2., 0., twopi);
   auto *crystal_housing_logical = new G4LogicalVolume(crystal_housing_solid, nist->FindOrBuildMaterial("G4_Al"), detector_name + "_crystal_housing_logical");
+  utrRegionTools::addLogicalVolume("detector", crystal_housing_logical);
   crystal_housing_logical->SetVisAttributes(G4Color::Grey());
   new G4PVPlacement(rotation, global_coordinates + (dist_from_center + crystal_housing_length / 2.) * symmetry_axis, crystal_housing_logical, detector_name + "_crystal_housing", world_Logical, 0, 0, false);
 
@@ -0,0 +1,84 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PhaseSpace.hh"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+PhaseSpaceFile::PhaseSpaceFile() : filename(""), data(nullptr), size(0), header(nullptr), records(nullptr) {}
+
+PhaseSpaceFile::~PhaseSpaceFile() { Close(); }
+
+void PhaseSpaceFile::Open(const G4String &fname) {
+  Close();
+
+  const int fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0) {
+    G4cerr << "ERROR: Phase-space file '" << fname << "' could not be opened! Aborting..." << G4endl;
+    throw std::exception();
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(PhaseSpaceHeader)) {
+    close(fd);
+    G4cerr << "ERROR: '" << fname << "' is not a phase-space file! Aborting..." << G4endl;
+    throw std::exception();
+  }
+  size = (size_t)status.st_size;
+
+  void *mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the file descriptor has been closed
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    G4cerr << "ERROR: Phase-space file '" << fname << "' could not be mapped into memory! Aborting..." << G4endl;
+    throw std::exception();
+  }
+  data = mapped;
+  filename = fname;
+  header = static_cast<const PhaseSpaceHeader *>(data);
+  records = reinterpret_cast<const PhaseSpaceRecord *>(static_cast<const char *>(data) + sizeof(PhaseSpaceHeader));
+
+  if (std::memcmp(header->magic, PHASESPACE_MAGIC, sizeof(header->magic)) != 0 || header->version != PHASESPACE_VERSION || header->record_size != sizeof(PhaseSpaceRecord)) {
+    Close();
+    G4cerr << "ERROR: '" << fname << "' is not a phase-space file of version " << PHASESPACE_VERSION << "! Aborting..." << G4endl;
+    throw std::exception();
+  }
+  if (header->n_records == 0 || size != sizeof(PhaseSpaceHeader) + header->n_records * sizeof(PhaseSpaceRecord)) {
+    const uint64_t n_records = header->n_records;
+    Close();
+    G4cerr << "ERROR: Phase-space file '" << fname << "' is empty or its size does not match the " << n_records << " records in the header! Aborting..." << G4endl;
+    throw std::exception();
+  }
+}
+
+void PhaseSpaceFile::Close() {
+  if (data) {
+    munmap(data, size);
+  }
+  filename = "";
+  data = nullptr;
+  size = 0;
+  header = nullptr;
+  records = nullptr;
+}
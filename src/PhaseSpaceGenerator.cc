@@ -0,0 +1,135 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PhaseSpaceGenerator.hh"
+
+#include <algorithm>
+
+#include "G4Event.hh"
+#include "G4IonTable.hh"
+#include "G4ParticleTable.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+#include "Randomize.hh"
+
+#include "utrPhaseSpaceTools.hh"
+
+PhaseSpaceGenerator::PhaseSpaceGenerator()
+    : G4VUserPrimaryGeneratorAction() {}
+
+PhaseSpaceGenerator::~PhaseSpaceGenerator() {}
+
+void PhaseSpaceGenerator::open() {
+  const G4String &filename = utrPhaseSpaceTools::getReplayFilename();
+  if (file.IsOpen() && file.GetFilename() == filename) {
+    return;
+  }
+  if (filename == "") {
+    G4cerr << "ERROR: No phase-space file was given with /utr/phaseSpace/replay! Aborting..." << G4endl;
+    throw std::exception();
+  }
+
+  file.Open(filename);
+
+  if (G4Threading::G4GetThreadId() <= 0) {
+    const G4double primaries_per_record = (G4double)file.GetNumberOfPrimaries() / (G4double)file.GetNumberOfRecords();
+    G4cout << "========================================================================" << G4endl;
+    G4cout << "PhaseSpaceGenerator: Replaying '" << filename << "'" << G4endl;
+    G4cout << "Records                  : " << file.GetNumberOfRecords() << G4endl;
+    G4cout << "Events of the first stage: " << file.GetNumberOfPrimaries() << G4endl;
+    G4cout << "Access                   : " << (utrPhaseSpaceTools::getSequentialAccess() ? "sequential" : "random") << G4endl;
+    G4cout << "Recycling                : " << utrPhaseSpaceTools::getRecycle() << " times per record" << G4endl;
+    G4cout << "Each event corresponds to " << primaries_per_record << " events of the first stage." << G4endl;
+    G4cout << "Runs with more than " << file.GetNumberOfRecords() * (uint64_t)utrPhaseSpaceTools::getRecycle() << " events reuse the phase space." << G4endl;
+    G4cout << "========================================================================" << G4endl;
+  }
+}
+
+uint64_t PhaseSpaceGenerator::nextIndex() {
+  const uint64_t n_records = file.GetNumberOfRecords();
+  if (!utrPhaseSpaceTools::getSequentialAccess()) {
+    return std::min((uint64_t)(G4UniformRand() * n_records), n_records - 1);
+  }
+
+  // The uses of a record are consecutive, and each use is drawn by exactly one event
+  const uint64_t recycle = (uint64_t)utrPhaseSpaceTools::getRecycle();
+  const uint64_t use = utrPhaseSpaceTools::nextSequentialUse();
+  if (use == n_records * recycle) {
+    G4cout << "WARNING: All records of the phase-space file have been used. Starting again from the beginning." << G4endl;
+  }
+  return (use / recycle) % n_records;
+}
+
+G4ParticleDefinition *PhaseSpaceGenerator::findParticle(G4int pdg) {
+  // Phase-space files usually contain few different particles
+  static G4ThreadLocal G4int lastPDG = 0;
+  static G4ThreadLocal G4ParticleDefinition *lastParticle = nullptr;
+  if (lastParticle && pdg == lastPDG) {
+    return lastParticle;
+  }
+
+  // PDG encodings of ions have the form 100ZZZAAAI
+  G4ParticleDefinition *particle = pdg > 1000000000 ? G4IonTable::GetIonTable()->GetIon(pdg) : G4ParticleTable::GetParticleTable()->FindParticle(pdg);
+  if (!particle) {
+    G4cerr << "ERROR: Unknown particle with PDG encoding " << pdg << " in the phase-space file '" << file.GetFilename() << "'! Aborting..." << G4endl;
+    throw std::exception();
+  }
+  lastPDG = pdg;
+  lastParticle = particle;
+  return particle;
+}
+
+void PhaseSpaceGenerator::GeneratePrimaries(G4Event *anEvent) {
+#ifdef PROFILE_GENERATORS
+  profiler.BeginEvent();
+#endif
+  open();
+
+  const PhaseSpaceRecord &record = file.GetRecord(nextIndex());
+
+  G4ThreeVector position(record.position[0] * mm, record.position[1] * mm, record.position[2] * mm);
+  G4ThreeVector direction(record.direction[0], record.direction[1], record.direction[2]);
+  G4ThreeVector polarization(record.polarization[0], record.polarization[1], record.polarization[2]);
+  // A recycled particle is rotated about the beam axis, which assumes that the phase space is
+  // symmetric with respect to phi. This is not the case for a linearly polarized beam.
+  if (utrPhaseSpaceTools::getRecycle() > 1) {
+    const G4double phi = twopi * G4UniformRand();
+    position.rotateZ(phi);
+    direction.rotateZ(phi);
+    polarization.rotateZ(phi);
+  }
+
+  G4PrimaryParticle *particle = new G4PrimaryParticle(findParticle(record.particle));
+  particle->SetKineticEnergy(record.kinetic_energy * MeV);
+  particle->SetMomentumDirection(direction.unit());
+  particle->SetPolarization(polarization);
+  particle->SetWeight(record.weight);
+
+  G4PrimaryVertex *vertex = new G4PrimaryVertex(position, 0.);
+  vertex->SetPrimary(particle);
+  anEvent->AddPrimaryVertex(vertex);
+
+#ifdef PROFILE_GENERATORS
+  profiler.EndEvent(1);
+#endif
+}
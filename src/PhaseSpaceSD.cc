@@ -0,0 +1,75 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PhaseSpaceSD.hh"
+#include "G4Event.hh"
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+#include "utrPhaseSpaceTools.hh"
+
+PhaseSpaceSD::PhaseSpaceSD(const G4String &name, const G4String &hitsCollectionName)
+    : ParticleSD(name, hitsCollectionName) {}
+
+PhaseSpaceSD::~PhaseSpaceSD() {}
+
+G4bool PhaseSpaceSD::ProcessHits(G4Step *aStep, G4TouchableHistory *) {
+  if (!utrPhaseSpaceTools::isRecording()) {
+    return false;
+  }
+
+  G4StepPoint *preStepPoint = aStep->GetPreStepPoint();
+  // Only particles that enter the volume through its surface cross the plane. This excludes the
+  // primaries of a replay, which start inside the volume.
+  if (preStepPoint->GetStepStatus() != fGeomBoundary || preStepPoint->GetKineticEnergy() == 0.)
+    return false;
+
+  G4Track *track = aStep->GetTrack();
+
+  G4int trackID = track->GetTrackID();
+  G4int eventID = G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID();
+
+  if (trackID == getCurrentTrackID() && eventID == getCurrentEventID())
+    return false;
+  setCurrentTrackID(trackID);
+  setCurrentEventID(eventID);
+
+  const G4ThreeVector &position = preStepPoint->GetPosition();
+  const G4ThreeVector &direction = preStepPoint->GetMomentumDirection();
+  const G4ThreeVector &polarization = preStepPoint->GetPolarization();
+
+  PhaseSpaceRecord record;
+  record.particle = track->GetDefinition()->GetPDGEncoding();
+  for (int i = 0; i < 3; ++i) {
+    record.position[i] = (float)(position[i] / CLHEP::mm);
+    record.direction[i] = (float)direction[i];
+    record.polarization[i] = (float)polarization[i];
+  }
+  record.kinetic_energy = (float)(preStepPoint->GetKineticEnergy() / CLHEP::MeV);
+  record.weight = (float)track->GetWeight();
+  utrPhaseSpaceTools::write(record);
+
+  // The particle is transported further in the second stage
+  if (utrPhaseSpaceTools::getKillRecorded()) {
+    track->SetTrackStatus(fStopAndKill);
+  }
+
+  return true;
+}
@@ -19,9 +19,10 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "Physics.hh"
+#include "utrRegionTools.hh"
 
 // Electromagnetic modular physics lists
-#ifdef EM_FAST
+#if defined(EM_FAST) || defined(EM_REGIONS)
 #include "G4EmStandardPhysics_option1.hh"
 #endif
 
@@ -67,6 +68,11 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "G4EmExtraPhysics.hh"
 #endif
 
+#ifdef FORCED_INTERACTION
+#include "G4GenericBiasingPhysics.hh"
+#include "utrBiasingTools.hh"
+#endif
+
 Physics::Physics() {
   G4cout << "================================================================"
             "================"
@@ -94,6 +100,11 @@ Physics::Physics() {
   G4cout << "\tG4EmStandardPhysics_option4 ..." << G4endl;
   RegisterPhysics(new G4EmStandardPhysics_option4());
 #endif
+// The precise models are added to the detector and target regions by utrRegionTools
+#ifdef EM_REGIONS
+  G4cout << "\tG4EmStandardPhysics_option1 with G4EmLivermore in the detector and target regions ..." << G4endl;
+  RegisterPhysics(new G4EmStandardPhysics_option1());
+#endif
 
 // EM extra physics. Contains photonuclear processes.
 #ifdef EM_EXTRA
@@ -133,7 +144,31 @@ Physics::Physics() {
   RegisterPhysics(new G4HadronPhysicsShieldingLEND());
 #endif
 
+// Wraps the photon processes that can be forced in the target material by utrBiasingTools.
+// The non-physics biasing is needed to split the photons into an interacting and an uncollided copy.
+#ifdef FORCED_INTERACTION
+  G4cout << "\tG4GenericBiasingPhysics for compt, Rayl and phot of gamma ..." << G4endl;
+  G4GenericBiasingPhysics *biasingPhysics = new G4GenericBiasingPhysics();
+  biasingPhysics->PhysicsBias("gamma", {"compt", "Rayl", "phot"});
+  biasingPhysics->NonPhysicsBias("gamma");
+  RegisterPhysics(biasingPhysics);
+#endif
+
   G4cout << "================================================================"
             "================"
          << G4endl;
 }
+
+void Physics::ConstructProcess() {
+  // The EM physics of the regions has to be known when the EM physics constructor is called
+  utrRegionTools::addEmPhysics();
+  G4VModularPhysicsList::ConstructProcess();
+#ifdef FORCED_INTERACTION
+  utrBiasingTools::attachOperators();
+#endif
+}
+
+void Physics::SetCuts() {
+  G4VModularPhysicsList::SetCuts();
+  utrRegionTools::applyProductionCuts();
+}
@@ -0,0 +1,139 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+#include "G4RunManager.hh"
+
+#include "PrimaryGeneratorProfiler.hh"
+#include "Run.hh"
+
+using std::setw;
+
+PrimaryGeneratorProfile::PrimaryGeneratorProfile() : events(0), primaries(0), position_trials(0), positions(0), momentum_trials(0), momenta(0), w_evaluations(0), time_ns(0), max_position_trials(0), max_momentum_trials(0), position_trials_per_event(PROFILE_MAX_TRIALS + 1, 0), momentum_trials_per_event(PROFILE_MAX_TRIALS + 1, 0) {}
+
+void PrimaryGeneratorProfile::AddEvent(G4long n_primaries, G4long n_position_trials, G4long n_positions, G4long n_momentum_trials, G4long n_momenta, G4long n_w_evaluations, G4long t_ns, G4long attributed_position_trials, G4long attributed_momentum_trials) {
+  ++events;
+  primaries += n_primaries;
+  position_trials += n_position_trials;
+  positions += n_positions;
+  momentum_trials += n_momentum_trials;
+  momenta += n_momenta;
+  w_evaluations += n_w_evaluations;
+  time_ns += t_ns;
+
+  max_position_trials = std::max(max_position_trials, attributed_position_trials);
+  max_momentum_trials = std::max(max_momentum_trials, attributed_momentum_trials);
+  ++position_trials_per_event[(size_t)std::min(attributed_position_trials, (G4long)PROFILE_MAX_TRIALS)];
+  ++momentum_trials_per_event[(size_t)std::min(attributed_momentum_trials, (G4long)PROFILE_MAX_TRIALS)];
+}
+
+void PrimaryGeneratorProfile::Merge(const PrimaryGeneratorProfile &profile) {
+  events += profile.events;
+  primaries += profile.primaries;
+  position_trials += profile.position_trials;
+  positions += profile.positions;
+  momentum_trials += profile.momentum_trials;
+  momenta += profile.momenta;
+  w_evaluations += profile.w_evaluations;
+  time_ns += profile.time_ns;
+
+  max_position_trials = std::max(max_position_trials, profile.max_position_trials);
+  max_momentum_trials = std::max(max_momentum_trials, profile.max_momentum_trials);
+  for (size_t i = 0; i <= PROFILE_MAX_TRIALS; ++i) {
+    position_trials_per_event[i] += profile.position_trials_per_event[i];
+    momentum_trials_per_event[i] += profile.momentum_trials_per_event[i];
+  }
+}
+
+G4long PrimaryGeneratorProfile::percentile(const vector<G4long> &histogram, G4double fraction) {
+  G4long total = 0;
+  for (auto n : histogram) {
+    total += n;
+  }
+
+  G4long cumulative = 0;
+  for (size_t i = 0; i < histogram.size(); ++i) {
+    cumulative += histogram[i];
+    if (cumulative >= fraction * total) {
+      return (G4long)i;
+    }
+  }
+  return (G4long)histogram.size() - 1;
+}
+
+void PrimaryGeneratorProfile::Print(G4double thread_time_ns) const {
+  G4cout << "========================================================================" << G4endl;
+  G4cout << "Primary generator profile: " << events << " events, " << primaries << " primaries" << G4endl;
+  if (events == 0) {
+    G4cout << "========================================================================" << G4endl << G4endl;
+    return;
+  }
+
+  G4cout << setw(26) << "trials per event" << setw(12) << "mean" << setw(10) << "50 %" << setw(10) << "90 %" << setw(10) << "99 %" << setw(10) << "max" << setw(14) << "acceptance" << G4endl;
+  G4cout << setw(26) << "position" << setw(12) << std::setprecision(4) << (G4double)position_trials / events << setw(10) << percentile(position_trials_per_event, 0.5) << setw(10) << percentile(position_trials_per_event, 0.9) << setw(10) << percentile(position_trials_per_event, 0.99) << setw(10) << max_position_trials << setw(12) << (position_trials > 0 ? 100. * positions / position_trials : 0.) << " %" << G4endl;
+  G4cout << setw(26) << "momentum" << setw(12) << std::setprecision(4) << (G4double)momentum_trials / events << setw(10) << percentile(momentum_trials_per_event, 0.5) << setw(10) << percentile(momentum_trials_per_event, 0.9) << setw(10) << percentile(momentum_trials_per_event, 0.99) << setw(10) << max_momentum_trials << setw(12) << (momentum_trials > 0 ? 100. * momenta / momentum_trials : 0.) << " %" << G4endl;
+  G4cout << "(A percentile of " << PROFILE_MAX_TRIALS << " means " << PROFILE_MAX_TRIALS << " or more trials.)" << G4endl;
+  G4cout << "Evaluations of W          : " << w_evaluations << " ( " << (G4double)w_evaluations / events << " per event )" << G4endl;
+  G4cout << "Primary generation time   : " << time_ns * 1e-9 << " s ( " << (primaries > 0 ? (G4double)time_ns / primaries : 0.) << " ns per primary, " << (G4double)time_ns / events << " ns per event )" << G4endl;
+  if (thread_time_ns > 0.) {
+    G4cout << "Fraction of thread time   : " << 100. * time_ns / thread_time_ns << " %" << G4endl;
+  }
+  G4cout << "========================================================================" << G4endl << G4endl;
+}
+
+void PrimaryGeneratorProfiler::CountBufferedMomentumTrials(size_t buffer, G4long trials, G4long accepted) {
+  momentum_trials += trials;
+  momenta += accepted;
+  if (buffer >= momentum_cost.size()) {
+    momentum_cost.resize(buffer + 1, 0.);
+    pending_momentum_trials.resize(buffer + 1, 0);
+  }
+  pending_momentum_trials[buffer] += trials;
+  if (accepted > 0) {
+    momentum_cost[buffer] = (G4double)pending_momentum_trials[buffer] / (G4double)accepted;
+    pending_momentum_trials[buffer] = 0;
+  }
+}
+
+void PrimaryGeneratorProfiler::CountBufferedMomentum(size_t buffer, bool found) {
+  if (buffer >= momentum_cost.size()) {
+    return;
+  }
+  if (found) {
+    attributed_momentum_trials += momentum_cost[buffer];
+  } else {
+    // The unsuccessful trials belong to the event that made them
+    attributed_momentum_trials += (G4double)pending_momentum_trials[buffer];
+    pending_momentum_trials[buffer] = 0;
+  }
+}
+
+void PrimaryGeneratorProfiler::EndEvent(G4long n_primaries) {
+  const G4long t_ns = (G4long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+  // Each thread has its own run, so no synchronization is needed
+  Run *run = dynamic_cast<Run *>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  if (run) {
+    run->GetGeneratorProfile().AddEvent(n_primaries, position_trials, positions, momentum_trials, momenta, w_evaluations, t_ns, std::lround(attributed_position_trials), std::lround(attributed_momentum_trials));
+  }
+}
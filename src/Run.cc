@@ -0,0 +1,45 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Run.hh"
+
+Run::Run() : G4Run(), start(std::chrono::steady_clock::now()), worker_time_ns(0.) {}
+
+void Run::Merge(const G4Run *run) {
+  const Run *worker_run = static_cast<const Run *>(run);
+
+  // The worker threads merge their runs at the end of their event loop
+  worker_time_ns += worker_run->elapsed_time();
+  generator_profile.Merge(worker_run->generator_profile);
+  stacking_profile.Merge(worker_run->stacking_profile);
+  escape_culling_profile.Merge(worker_run->escape_culling_profile);
+  weight_tally.Merge(worker_run->weight_tally);
+
+  G4Run::Merge(run);
+}
+
+G4double Run::GetThreadTime() const {
+  // In sequential mode, there are no worker runs
+  return worker_time_ns > 0. ? worker_time_ns : elapsed_time();
+}
+
+G4double Run::elapsed_time() const {
+  return (G4double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
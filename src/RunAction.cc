@@ -28,65 +28,99 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "G4FileUtilities.hh"
 
-#include "DetectorConstruction.hh"
+#include "DetectorConstructionFactory.hh"
+#include "EnergyDepositionSD.hh"
 #include "G4RootAnalysisManager.hh"
+#include "Run.hh"
 #include "RunAction.hh"
+#include "StackingAction.hh"
+#include "SteppingAction.hh"
 #include "utrFilenameTools.hh"
+#include "utrHistogramTools.hh"
+#include "utrOutputTools.hh"
+#include "utrPhaseSpaceTools.hh"
+#include "utrScanTools.hh"
 #include <limits.h>
 
 #include "utrConfig.h"
 
+G4ThreadLocal G4int RunAction::firstNtupleID = 0;
+G4ThreadLocal G4int RunAction::ntupleID = 0;
+
 RunAction::RunAction() : G4UserRunAction() {}
 
 RunAction::~RunAction() { delete G4RootAnalysisManager::Instance(); }
 
+G4Run *RunAction::GenerateRun() { return new Run(); }
+
 void RunAction::BeginOfRunAction(const G4Run *) {
   // Get analysis manager
   G4RootAnalysisManager *analysisManager = G4RootAnalysisManager::Instance();
 
-#ifdef EVENT_EVENTWISE
-  analysisManager->CreateNtuple("edep", "Energy Deposition");
-  auto max_sensitive_detector_ID = ((DetectorConstruction *)G4RunManager::GetRunManager()->GetUserDetectorConstruction())->Max_Sensitive_Detector_ID;
-  for (size_t i = 0; i < max_sensitive_detector_ID + 1; ++i) {
-    analysisManager->CreateNtupleDColumn("det" + std::to_string(i));
+  // In a scan (/utr/scan/beamOn), the histograms or ntuples of all points are created and the output file is
+  // opened in the first run. The following runs only select the histograms or ntuple of their point.
+  const unsigned int point = utrScanTools::getCurrentPoint();
+
+  // Like the output file, the phase-space file is written once for all points of a scan
+  if (point == 0 && IsMaster() && utrPhaseSpaceTools::isRecording()) {
+    utrPhaseSpaceTools::beginRun();
+  }
+#ifdef GENERATOR_PHASESPACE
+  if (IsMaster()) {
+    utrPhaseSpaceTools::beginReplay();
   }
-#else
-  analysisManager->CreateNtuple("utr", "Particle information");
-#ifdef EVENT_ID
-  analysisManager->CreateNtupleDColumn("event");
-#endif
-#ifdef EVENT_EDEP
-  analysisManager->CreateNtupleDColumn("edep");
-#endif
-#ifdef EVENT_EKIN
-  analysisManager->CreateNtupleDColumn("ekin");
-#endif
-#ifdef EVENT_PARTICLE
-  analysisManager->CreateNtupleDColumn("particle");
-#endif
-#ifdef EVENT_VOLUME
-  analysisManager->CreateNtupleDColumn("volume");
-#endif
-#ifdef EVENT_POSX
-  analysisManager->CreateNtupleDColumn("x");
-#endif
-#ifdef EVENT_POSY
-  analysisManager->CreateNtupleDColumn("y");
 #endif
-#ifdef EVENT_POSZ
-  analysisManager->CreateNtupleDColumn("z");
+
+  if (point > 0) {
+#ifdef EVENT_HISTOGRAM
+    utrHistogramTools::selectSet(point);
+#else
+    ntupleID = firstNtupleID + (G4int)point;
 #endif
-#ifdef EVENT_MOMX
-  analysisManager->CreateNtupleDColumn("vx");
+    return;
+  }
+  const vector<string> prefixes = utrScanTools::getOutputPrefixes();
+
+#ifndef EVENT_HISTOGRAM
+  // Has to be set in all threads before the ntuple is created
+  if (utrFilenameTools::getMergeNtuples()) {
+    analysisManager->SetNtupleMerging(true);
+  }
 #endif
-#ifdef EVENT_MOMY
-  analysisManager->CreateNtupleDColumn("vy");
+
+#if defined(EVENT_HISTOGRAM)
+  utrHistogramTools::book(DetectorConstructionFactory::GetMaxSensitiveDetectorID(), prefixes);
+#else
+  // With merging, the entries of a single event may be split between the blocks of different threads. getHistogram
+  // recognizes such ntuples by their title and refuses to add back their energy depositions.
+  const G4String titleSuffix = utrFilenameTools::getMergeNtuples() ? " (merged)" : "";
+  for (size_t i = 0; i < prefixes.size(); ++i) {
+#if defined(EVENT_EVENTWISE_SPARSE)
+    const G4int id = analysisManager->CreateNtuple(prefixes[i] + "edep", "Energy Deposition" + titleSuffix);
+    analysisManager->CreateNtupleIColumn("detector", EnergyDepositionSD::GetHitDetectorIDs());
+#ifdef EVENT_FLOAT_COLUMNS
+    analysisManager->CreateNtupleFColumn("edep", EnergyDepositionSD::GetHitEnergyDepositions());
+#else
+    analysisManager->CreateNtupleDColumn("edep", EnergyDepositionSD::GetHitEnergyDepositions());
 #endif
-#ifdef EVENT_MOMZ
-  analysisManager->CreateNtupleDColumn("vz");
+#elif defined(EVENT_EVENTWISE)
+    const G4int id = analysisManager->CreateNtuple(prefixes[i] + "edep", "Energy Deposition" + titleSuffix);
+    auto max_sensitive_detector_ID = DetectorConstructionFactory::GetMaxSensitiveDetectorID();
+    for (size_t j = 0; j < max_sensitive_detector_ID + 1; ++j) {
+      CreateRealColumn("det" + std::to_string(j));
+    }
+#else
+    const G4int id = analysisManager->CreateNtuple(prefixes[i] + "utr", "Particle information" + titleSuffix);
+    // The columns are the quantities selected with the EVENT_* build options or the /utr/output/ commands
+    utrOutputTools::book(i == 0);
 #endif
+    analysisManager->FinishNtuple();
+    if (i == 0) {
+      firstNtupleID = id;
+    }
+  }
+  ntupleID = firstNtupleID;
 #endif
-  analysisManager->FinishNtuple();
 
   // Open an output file
   // Geant4 in Multithreading mode creates files with naming convention
@@ -94,8 +128,40 @@ void RunAction::BeginOfRunAction(const G4Run *) {
   // <filename>_t<threadId>.root
   //
   // where the filename is given by the user in analysisManager->OpenFile()
+  //
+  // If ntuple merging is activated (/utr/mergeNtuples), the worker threads send their
+  // ntuple rows to the master thread, which writes a single file <filename>.root.
+  //
+  // In EVENT_HISTOGRAM mode, only the master thread opens a file, into which the
+  // histograms of all worker threads are merged by analysisManager->Write().
 
-  if (IsMaster()) { // G4UserRunAction::IsMaster should be equivalent to G4Threading::G4GetThreadId() == -1
+#ifdef EVENT_HISTOGRAM
+  if (IsMaster()) {
+    if (utrFilenameTools::getUseFilenameID()) {
+      utrFilenameTools::incrementFilenameID();
+    }
+    G4FileUtilities fu;
+    if (fu.FileExists(utrHistogramTools::getHistogramFilename())) {
+      G4cerr << "ERROR: Designated outputfile '" << utrHistogramTools::getHistogramFilename() << "' already exists! Aborting..." << G4endl;
+      throw std::exception();
+    }
+    analysisManager->OpenFile(utrHistogramTools::getHistogramFilename());
+  }
+#else
+  if (utrFilenameTools::getMergeNtuples()) {
+    if (IsMaster()) {
+      if (utrFilenameTools::getUseFilenameID()) {
+        utrFilenameTools::incrementFilenameID();
+      }
+      G4FileUtilities fu;
+      if (fu.FileExists(utrFilenameTools::getMergedFilename())) {
+        G4cerr << "ERROR: Designated outputfile '" << utrFilenameTools::getMergedFilename() << "' already exists! Aborting..." << G4endl;
+        throw std::exception();
+      }
+    }
+    // All threads open the same file, but only the master thread creates it
+    analysisManager->OpenFile(utrFilenameTools::getMergedFilename());
+  } else if (IsMaster()) { // G4UserRunAction::IsMaster should be equivalent to G4Threading::G4GetThreadId() == -1
     // Master thread (running this function before all other threads) increments the file ID to use, if used
     if (utrFilenameTools::getUseFilenameID()) {
       utrFilenameTools::incrementFilenameID();
@@ -119,17 +185,87 @@ void RunAction::BeginOfRunAction(const G4Run *) {
       analysisManager->OpenFile(filename.str());
     }
   }
+#endif
 }
 
-void RunAction::EndOfRunAction(const G4Run *) {
+void RunAction::EndOfRunAction(const G4Run *run) {
   G4RootAnalysisManager *analysisManager = G4RootAnalysisManager::Instance();
 
+  // The master thread has merged the profiles of all worker threads at this point
+  if (IsMaster()) {
+    const Run *utrRun = static_cast<const Run *>(run);
+#ifdef PROFILE_GENERATORS
+    utrRun->GetGeneratorProfile().Print(utrRun->GetThreadTime());
+#endif
+    if (!StackingAction::GetRules().empty()) {
+      utrRun->GetStackingProfile().Print(utrRun->GetThreadTime());
+    }
+#ifdef ESCAPE_CULLING
+    if (!SteppingAction::GetRoomScatter()) {
+      utrRun->GetEscapeCullingProfile().Print(utrRun->GetThreadTime());
+    }
+#endif
+#ifdef FORCED_INTERACTION
+    utrRun->GetWeightTally().Print(utrRun->GetThreadTime());
+#endif
+  }
+
+  if (utrPhaseSpaceTools::isRecording()) {
+    utrPhaseSpaceTools::endRun(run->GetNumberOfEvent(), IsMaster(), utrScanTools::isLastPoint());
+  }
+
+  // The output file stays open until the last point of a scan
+  if (!utrScanTools::isLastPoint()) {
+    return;
+  }
+
   analysisManager->Write();
+#ifdef EVENT_HISTOGRAM
+  if (IsMaster()) {
+    analysisManager->CloseFile();
+    G4cout << "Wrote histograms to '" << utrHistogramTools::getHistogramFilename() << "'" << G4endl;
+  }
+#else
   analysisManager->CloseFile();
+#endif
 
   delete G4RootAnalysisManager::Instance();
 }
 
+void RunAction::AddNtupleRow() { G4RootAnalysisManager::Instance()->AddNtupleRow(ntupleID); }
+
+G4int RunAction::CreateIntColumn(const G4String &name) {
+#ifdef EVENT_INT_COLUMNS
+  return G4RootAnalysisManager::Instance()->CreateNtupleIColumn(name);
+#else
+  return G4RootAnalysisManager::Instance()->CreateNtupleDColumn(name);
+#endif
+}
+
+G4int RunAction::CreateRealColumn(const G4String &name) {
+#ifdef EVENT_FLOAT_COLUMNS
+  return G4RootAnalysisManager::Instance()->CreateNtupleFColumn(name);
+#else
+  return G4RootAnalysisManager::Instance()->CreateNtupleDColumn(name);
+#endif
+}
+
+void RunAction::FillIntColumn(G4int column, G4int value) {
+#ifdef EVENT_INT_COLUMNS
+  G4RootAnalysisManager::Instance()->FillNtupleIColumn(ntupleID, column, value);
+#else
+  G4RootAnalysisManager::Instance()->FillNtupleDColumn(ntupleID, column, value);
+#endif
+}
+
+void RunAction::FillRealColumn(G4int column, G4double value) {
+#ifdef EVENT_FLOAT_COLUMNS
+  G4RootAnalysisManager::Instance()->FillNtupleFColumn(ntupleID, column, (G4float)value);
+#else
+  G4RootAnalysisManager::Instance()->FillNtupleDColumn(ntupleID, column, value);
+#endif
+}
+
 G4String RunAction::GetOutputFlagName(unsigned int n) {
   switch (n) {
     case ID:
@@ -154,6 +290,8 @@ G4String RunAction::GetOutputFlagName(unsigned int n) {
       return "MOMY";
     case MOMZ:
       return "MOMZ";
+    case WEIGHT:
+      return "WEIGHT";
     default:
       G4cout << "RunAction: Error! Output flag index not found." << G4endl;
       return "";
@@ -21,7 +21,6 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "SecondarySD.hh"
 #include "G4Event.hh"
 #include "G4HCofThisEvent.hh"
-#include "G4RootAnalysisManager.hh"
 #include "G4RunManager.hh"
 #include "G4SDManager.hh"
 #include "G4Step.hh"
@@ -29,7 +28,7 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "G4ThreeVector.hh"
 #include "G4VProcess.hh"
 #include "G4ios.hh"
-#include "RunAction.hh"
+#include "utrOutputTools.hh"
 
 #include "utrConfig.h"
 
@@ -62,55 +61,22 @@ G4bool SecondarySD::ProcessHits(G4Step *aStep, G4TouchableHistory *) {
     if (track->GetKineticEnergy() == 0.)
       return false;
 
-    G4RootAnalysisManager *analysisManager = G4RootAnalysisManager::Instance();
-
-    unsigned int nentry = 0;
-
-#ifdef EVENT_ID
-    analysisManager->FillNtupleDColumn(nentry, eventID);
-    ++nentry;
-#endif
-#ifdef EVENT_EDEP
-    analysisManager->FillNtupleDColumn(nentry, aStep->GetTotalEnergyDeposit());
-    ++nentry;
-#endif
-#ifdef EVENT_EKIN
-    analysisManager->FillNtupleDColumn(nentry, aStep->GetPreStepPoint()->GetKineticEnergy());
-    ++nentry;
-#endif
-#ifdef EVENT_PARTICLE
-    analysisManager->FillNtupleDColumn(nentry, track->GetDefinition()->GetPDGEncoding());
-    ++nentry;
-#endif
-#ifdef EVENT_VOLUME
-    analysisManager->FillNtupleDColumn(nentry, getDetectorID());
-    ++nentry;
-#endif
-#ifdef EVENT_POSX
-    analysisManager->FillNtupleDColumn(nentry, track->GetPosition().x());
-    ++nentry;
-#endif
-#ifdef EVENT_POSY
-    analysisManager->FillNtupleDColumn(nentry, track->GetPosition().y());
-    ++nentry;
-#endif
-#ifdef EVENT_POSZ
-    analysisManager->FillNtupleDColumn(nentry, track->GetPosition().z());
-    ++nentry;
-#endif
-#ifdef EVENT_MOMX
-    analysisManager->FillNtupleDColumn(nentry, track->GetMomentum().x());
-    ++nentry;
-#endif
-#ifdef EVENT_MOMY
-    analysisManager->FillNtupleDColumn(nentry, track->GetMomentum().y());
-    ++nentry;
-#endif
-#ifdef EVENT_MOMZ
-    analysisManager->FillNtupleDColumn(nentry, track->GetMomentum().z());
-#endif
-
-    analysisManager->AddNtupleRow();
+    OutputRecord record;
+    record.eventID = eventID;
+    record.edep = aStep->GetTotalEnergyDeposit();
+    record.ekin = aStep->GetPreStepPoint()->GetKineticEnergy();
+    if (utrOutputTools::recordsParticle()) {
+      record.particle = track->GetDefinition()->GetPDGEncoding();
+    }
+    record.volume = getDetectorID();
+    if (utrOutputTools::recordsPosition()) {
+      record.position = track->GetPosition();
+    }
+    if (utrOutputTools::recordsMomentum()) {
+      record.momentum = track->GetMomentum();
+    }
+    record.weight = track->GetWeight();
+    utrOutputTools::fill(record);
   }
 
   return true;
@@ -0,0 +1,228 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include "G4LogicalVolume.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4Point3D.hh"
+#include "G4TransportationManager.hh"
+#include "Randomize.hh"
+
+#include "SourceVolumeSampler.hh"
+
+SourceVolumeSampler::SourceVolumeSampler() : initialized(false), sampler_method(POSITION_SAMPLER_BOX), max_tries(0), pool_position(0), n_trials(0), n_accepted(0) {
+  navigator = new G4Navigator();
+}
+
+SourceVolumeSampler::~SourceVolumeSampler() {
+  delete navigator;
+}
+
+void SourceVolumeSampler::Initialize(const vector<G4String> &pv_names, G4ThreeVector box_center, G4ThreeVector box_size, position_sampler method, G4int max_t) {
+  sampler_method = method;
+  max_tries = max_t;
+
+  box_min = box_center - 0.5 * box_size;
+  box_max = box_center + 0.5 * box_size;
+
+  // Use a private navigator, so that the state of the navigator for tracking is not changed
+  G4VPhysicalVolume *world = G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume();
+  navigator->SetWorldVolume(world);
+
+  source_pvs.clear();
+  for (auto name : pv_names) {
+    G4bool found = false;
+    for (auto pv : *G4PhysicalVolumeStore::GetInstance()) {
+      if (pv->GetName() == name) {
+        source_pvs.push_back(pv);
+        found = true;
+      }
+    }
+    if (!found) {
+      G4cout << "Warning: SourceVolumeSampler: Source volume " << name << " does not exist in the geometry." << G4endl;
+    }
+  }
+
+  placements.clear();
+  placement_cdf.clear();
+  if (sampler_method == POSITION_SAMPLER_SOLID) {
+    G4bool placements_found = find_placements(world, G4Transform3D());
+    for (auto pv : source_pvs) {
+      if (std::none_of(placements.begin(), placements.end(), [pv](const Placement &p) { return p.pv == pv; })) {
+        placements_found = false;
+      }
+    }
+
+    if (placements_found && !placements.empty()) {
+      G4double cumulative_volume = 0.;
+      for (auto &p : placements) {
+        const G4ThreeVector extent = p.bounding_max - p.bounding_min;
+        cumulative_volume += extent.x() * extent.y() * extent.z();
+        placement_cdf.push_back(cumulative_volume);
+      }
+    } else {
+      G4cout << "Warning: SourceVolumeSampler: Not all source volumes are simple placements. Sampling positions in the container box instead." << G4endl;
+      placements.clear();
+      sampler_method = POSITION_SAMPLER_BOX;
+    }
+  }
+
+  pool.clear();
+  pool_position = 0;
+  initialized = true;
+}
+
+G4bool SourceVolumeSampler::Sample(G4ThreeVector &position) {
+  if (pool_position >= pool.size() && !fill_pool()) {
+    return false;
+  }
+
+  position = pool[pool_position];
+  ++pool_position;
+  return true;
+}
+
+G4bool SourceVolumeSampler::fill_pool() {
+  pool.clear();
+  pool_position = 0;
+
+  G4ThreeVector position;
+  for (int i = 0; i < POSITION_POOL_SIZE; ++i) {
+    if (!(sampler_method == POSITION_SAMPLER_SOLID ? sample_solid(position) : sample_box(position))) {
+      break;
+    }
+    pool.push_back(position);
+  }
+  n_accepted += (G4long)pool.size();
+
+  return !pool.empty();
+}
+
+G4bool SourceVolumeSampler::sample_box(G4ThreeVector &position) {
+  const G4ThreeVector extent = box_max - box_min;
+
+  for (int i = 0; i < max_tries; ++i) {
+    ++n_trials;
+    position = G4ThreeVector(box_min.x() + G4UniformRand() * extent.x(), box_min.y() + G4UniformRand() * extent.y(), box_min.z() + G4UniformRand() * extent.z());
+
+    if (is_source(navigator->LocateGlobalPointAndSetup(position, nullptr, false))) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+G4bool SourceVolumeSampler::sample_solid(G4ThreeVector &position) {
+  G4ThreeVector local;
+  G4ThreeVector extent;
+  G4bool inside_daughter;
+
+  for (int i = 0; i < max_tries; ++i) {
+    ++n_trials;
+    const size_t n = std::min((size_t)(std::upper_bound(placement_cdf.begin(), placement_cdf.end(), G4UniformRand() * placement_cdf.back()) - placement_cdf.begin()), placements.size() - 1);
+    const Placement &p = placements[n];
+
+    extent = p.bounding_max - p.bounding_min;
+    local = G4ThreeVector(p.bounding_min.x() + G4UniformRand() * extent.x(), p.bounding_min.y() + G4UniformRand() * extent.y(), p.bounding_min.z() + G4UniformRand() * extent.z());
+
+    if (p.solid->Inside(local) != kInside) {
+      continue;
+    }
+
+    // Points inside a daughter volume do not belong to the source volume itself
+    inside_daughter = false;
+    for (size_t j = 0; j < p.daughter_solids.size(); ++j) {
+      const G4Point3D daughter_local = p.local_to_daughter[j] * G4Point3D(local);
+      if (p.daughter_solids[j]->Inside(G4ThreeVector(daughter_local.x(), daughter_local.y(), daughter_local.z())) != kOutside) {
+        inside_daughter = true;
+        break;
+      }
+    }
+    if (inside_daughter) {
+      continue;
+    }
+
+    const G4Point3D global = p.local_to_global * G4Point3D(local);
+    position = G4ThreeVector(global.x(), global.y(), global.z());
+
+    if (inside_box(position)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+G4bool SourceVolumeSampler::inside_box(const G4ThreeVector &position) const {
+  return position.x() >= box_min.x() && position.x() <= box_max.x() &&
+         position.y() >= box_min.y() && position.y() <= box_max.y() &&
+         position.z() >= box_min.z() && position.z() <= box_max.z();
+}
+
+G4bool SourceVolumeSampler::is_source(const G4VPhysicalVolume *pv) const {
+  return std::find(source_pvs.begin(), source_pvs.end(), pv) != source_pvs.end();
+}
+
+G4bool SourceVolumeSampler::find_placements(const G4VPhysicalVolume *mother, const G4Transform3D &mother_to_global) {
+  const G4LogicalVolume *mother_lv = mother->GetLogicalVolume();
+
+  for (size_t i = 0; i < (size_t)mother_lv->GetNoDaughters(); ++i) {
+    G4VPhysicalVolume *daughter = mother_lv->GetDaughter((G4int)i);
+
+    // The coordinate transformation of replicated volumes depends on the copy number.
+    // Source volumes below them are not found, which is detected by the caller.
+    if (daughter->IsReplicated()) {
+      if (is_source(daughter)) {
+        return false;
+      }
+      continue;
+    }
+
+    const G4Transform3D daughter_to_global = mother_to_global * G4Transform3D(daughter->GetObjectRotationValue(), daughter->GetObjectTranslation());
+
+    if (is_source(daughter)) {
+      Placement placement;
+      placement.pv = daughter;
+      placement.solid = daughter->GetLogicalVolume()->GetSolid();
+      placement.local_to_global = daughter_to_global;
+      placement.solid->BoundingLimits(placement.bounding_min, placement.bounding_max);
+
+      const G4LogicalVolume *source_lv = daughter->GetLogicalVolume();
+      for (size_t j = 0; j < (size_t)source_lv->GetNoDaughters(); ++j) {
+        const G4VPhysicalVolume *grand_daughter = source_lv->GetDaughter((G4int)j);
+        if (grand_daughter->IsReplicated()) {
+          return false;
+        }
+        placement.daughter_solids.push_back(grand_daughter->GetLogicalVolume()->GetSolid());
+        placement.local_to_daughter.push_back(G4Transform3D(grand_daughter->GetObjectRotationValue(), grand_daughter->GetObjectTranslation()).inverse());
+      }
+
+      placements.push_back(placement);
+    }
+
+    if (!find_placements(daughter, daughter_to_global)) {
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,166 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <iomanip>
+
+#include "G4LossTableManager.hh"
+#include "G4Region.hh"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4TransportationManager.hh"
+#include "G4UnitsTable.hh"
+#include "G4VSensitiveDetector.hh"
+
+#include "Run.hh"
+#include "StackingAction.hh"
+
+using std::setw;
+
+vector<StackingRule> StackingAction::rules = vector<StackingRule>();
+
+StackingProfile::StackingProfile() : secondaries(0), kills(StackingAction::GetRules().size(), 0), killed_energy(StackingAction::GetRules().size(), 0.) {}
+
+void StackingProfile::AddKill(size_t rule, G4double kinetic_energy) {
+  if (rule >= kills.size()) {
+    kills.resize(rule + 1, 0);
+    killed_energy.resize(rule + 1, 0.);
+  }
+  ++kills[rule];
+  killed_energy[rule] += kinetic_energy;
+}
+
+void StackingProfile::Merge(const StackingProfile &profile) {
+  secondaries += profile.secondaries;
+  if (profile.kills.size() > kills.size()) {
+    kills.resize(profile.kills.size(), 0);
+    killed_energy.resize(profile.kills.size(), 0.);
+  }
+  for (size_t i = 0; i < profile.kills.size(); ++i) {
+    kills[i] += profile.kills[i];
+    killed_energy[i] += profile.killed_energy[i];
+  }
+}
+
+void StackingProfile::Print(G4double thread_time_ns) const {
+  const vector<StackingRule> &rules = StackingAction::GetRules();
+
+  G4long total_kills = 0;
+  for (auto n : kills) {
+    total_kills += n;
+  }
+
+  G4cout << "========================================================================" << G4endl;
+  G4cout << "Stacking action: " << secondaries << " secondaries, " << total_kills << " killed";
+  if (secondaries > 0) {
+    G4cout << " ( " << std::setprecision(4) << 100. * total_kills / secondaries << " % )";
+  }
+  G4cout << G4endl;
+  G4cout << setw(46) << "rule" << setw(12) << "killed" << setw(14) << "energy" << G4endl;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    const G4long n = i < kills.size() ? kills[i] : 0;
+    const G4double energy = i < killed_energy.size() ? killed_energy[i] : 0.;
+    G4cout << setw(46) << rules[i].description << setw(12) << n << setw(14) << G4BestUnit(energy, "Energy") << G4endl;
+  }
+  G4cout << "(The energy is the sum of the kinetic energies of the killed tracks.)" << G4endl;
+  if (thread_time_ns > 0.) {
+    G4cout << "Thread time               : " << thread_time_ns * 1e-9 << " s" << G4endl;
+  }
+  G4cout << "========================================================================" << G4endl << G4endl;
+}
+
+StackingAction::StackingAction() : G4UserStackingAction(), navigator(nullptr), profile(nullptr) {}
+
+StackingAction::~StackingAction() { delete navigator; }
+
+void StackingAction::PrepareNewEvent() {
+  // Each thread has its own run, so no synchronization is needed
+  Run *run = dynamic_cast<Run *>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  profile = run ? &run->GetStackingProfile() : nullptr;
+}
+
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track *track) {
+  if (rules.empty() || track->GetParentID() == 0) {
+    return G4UserStackingAction::ClassifyNewTrack(track);
+  }
+
+  if (profile) {
+    profile->AddSecondary();
+  }
+  for (size_t i = 0; i < rules.size(); ++i) {
+    if (Matches(rules[i], track)) {
+      if (profile) {
+        profile->AddKill(i, track->GetKineticEnergy());
+      }
+      return fKill;
+    }
+  }
+  return G4UserStackingAction::ClassifyNewTrack(track);
+}
+
+G4bool StackingAction::Matches(const StackingRule &rule, const G4Track *track) {
+  // The cheapest conditions are checked first
+  if (rule.particle != "" && track->GetDefinition()->GetParticleName() != rule.particle) {
+    return false;
+  }
+  if (rule.max_energy > 0. && track->GetKineticEnergy() >= rule.max_energy) {
+    return false;
+  }
+  if (rule.volume != "" || rule.region != "") {
+    // A new secondary is in the volume of the post-step point of its creator
+    const G4VPhysicalVolume *volume = track->GetVolume();
+    if (volume == nullptr) {
+      return false;
+    }
+    const G4LogicalVolume *logical = volume->GetLogicalVolume();
+    if (rule.volume != "" && logical->GetName() != rule.volume) {
+      return false;
+    }
+    if (rule.region != "" && (logical->GetRegion() == nullptr || logical->GetRegion()->GetName() != rule.region)) {
+      return false;
+    }
+  }
+  if (rule.unreachable && !CannotReachSensitiveDetector(track)) {
+    return false;
+  }
+  return true;
+}
+
+G4bool StackingAction::CannotReachSensitiveDetector(const G4Track *track) {
+  if (track->GetDefinition()->GetPDGCharge() == 0.) {
+    return false;
+  }
+
+  if (navigator == nullptr) {
+    navigator = new G4Navigator();
+    navigator->SetWorldVolume(G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume());
+  }
+
+  const G4ThreeVector &position = track->GetPosition();
+  const G4VPhysicalVolume *volume = navigator->LocateGlobalPointAndSetup(position, nullptr, false, true);
+  if (volume == nullptr || volume->GetLogicalVolume()->GetSensitiveDetector() != nullptr) {
+    return false;
+  }
+
+  // The range from the restricted stopping power is longer than the CSDA range, so this is conservative.
+  // Particles without energy loss tables have an infinite range.
+  const G4double range = G4LossTableManager::Instance()->GetRange(track->GetDefinition(), track->GetKineticEnergy(), volume->GetLogicalVolume()->GetMaterialCutsCouple());
+  return range < navigator->ComputeSafety(position);
+}
@@ -0,0 +1,234 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cfloat>
+
+#include "G4LogicalVolume.hh"
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+#include "G4Threading.hh"
+#include "G4TransportationManager.hh"
+#include "G4UnitsTable.hh"
+#include "G4VSolid.hh"
+
+#include "PhaseSpaceSD.hh"
+#include "Run.hh"
+#include "SteppingAction.hh"
+#include "utrPhaseSpaceTools.hh"
+
+G4bool SteppingAction::room_scatter = false;
+G4double SteppingAction::margin = 0.;
+G4int SteppingAction::sample_every = 100;
+
+void EscapeCullingProfile::Merge(const EscapeCullingProfile &profile) {
+  bounding_radius = std::max(bounding_radius, profile.bounding_radius);
+  culled_tracks += profile.culled_tracks;
+  sampled_tracks += profile.sampled_tracks;
+  sampled_steps += profile.sampled_steps;
+  sampled_time_ns += profile.sampled_time_ns;
+}
+
+void EscapeCullingProfile::Print(G4double thread_time_ns) const {
+  G4cout << "========================================================================" << G4endl;
+  G4cout << "Escape culling: " << culled_tracks << " tracks culled outside of a radius of " << G4BestUnit(bounding_radius, "Length") << G4endl;
+  if (sampled_tracks == 0) {
+    G4cout << "No escaping track was sampled to estimate the saved steps and time (see /utr/cull/sampleEvery)." << G4endl;
+    G4cout << "========================================================================" << G4endl << G4endl;
+    return;
+  }
+  const G4double steps_per_track = (G4double)sampled_steps / sampled_tracks;
+  const G4double time_per_track_ns = sampled_time_ns / sampled_tracks;
+  G4cout << "Sampled tracks            : " << sampled_tracks << " ( " << steps_per_track << " steps and " << time_per_track_ns << " ns per track )" << G4endl;
+  G4cout << "Saved steps (estimate)    : " << culled_tracks * steps_per_track << G4endl;
+  G4cout << "Saved time (estimate)     : " << culled_tracks * time_per_track_ns * 1e-9 << " s";
+  if (thread_time_ns > 0.) {
+    G4cout << " ( " << 100. * culled_tracks * time_per_track_ns / thread_time_ns << " % of the thread time )";
+  }
+  G4cout << G4endl;
+  G4cout << "(The secondaries of the escaping tracks are not included in the estimate.)" << G4endl;
+  G4cout << "========================================================================" << G4endl << G4endl;
+}
+
+SteppingAction::SteppingAction() : G4UserSteppingAction(), bounding_radius(-1.), escaping_tracks(0), sampled_track_id(-1), sampled_step_number(0) {}
+
+void SteppingAction::UserSteppingAction(const G4Step *step) {
+  G4Track *track = step->GetTrack();
+
+  // The steps of a track are processed one after the other, so the sample ends with the first
+  // step of another track
+  if (sampled_track_id >= 0) {
+    if (track->GetTrackID() == sampled_track_id && track->GetCurrentStepNumber() == sampled_step_number + 1) {
+      const auto now = std::chrono::steady_clock::now();
+      Run *run = dynamic_cast<Run *>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+      if (run) {
+        run->GetEscapeCullingProfile().AddSampledStep((G4double)std::chrono::duration_cast<std::chrono::nanoseconds>(now - sampled_step_time).count());
+      }
+      sampled_step_number = track->GetCurrentStepNumber();
+      sampled_step_time = now;
+      SuppressSampledOutput(step);
+      return;
+    }
+    sampled_track_id = -1;
+  }
+
+  if (room_scatter || track->GetTrackStatus() != fAlive) {
+    return;
+  }
+
+  if (bounding_radius < 0.) {
+    ComputeBoundingRadius();
+  }
+
+  // Outside of the sphere, a straight trajectory with a positive radial component never enters it again
+  const G4StepPoint *post_step_point = step->GetPostStepPoint();
+  const G4ThreeVector &position = post_step_point->GetPosition();
+  const G4double radius = bounding_radius + margin;
+  if (position.mag2() <= radius * radius || position.dot(post_step_point->GetMomentumDirection()) <= 0.) {
+    return;
+  }
+
+  Run *run = dynamic_cast<Run *>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  ++escaping_tracks;
+  if (sample_every > 0 && escaping_tracks % sample_every == 0) {
+    sampled_track_id = track->GetTrackID();
+    sampled_step_number = track->GetCurrentStepNumber();
+    sampled_step_time = std::chrono::steady_clock::now();
+    if (run) {
+      run->GetEscapeCullingProfile().AddSampledTrack();
+    }
+    return;
+  }
+
+  track->SetTrackStatus(fStopAndKill);
+  if (run) {
+    run->GetEscapeCullingProfile().SetBoundingRadius(radius);
+    run->GetEscapeCullingProfile().AddCulledTrack();
+  }
+}
+
+void SteppingAction::ComputeBoundingRadius() {
+  const G4VPhysicalVolume *world = G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume();
+
+  bounding_radius = 0.;
+  if (!ExtendBoundingRadius(world, G4Transform3D())) {
+    // Without sensitive detectors, nothing is culled
+    bounding_radius = DBL_MAX;
+    if (G4Threading::G4GetThreadId() <= 0) {
+      G4cout << "SteppingAction: The geometry has no sensitive detectors, the escape culling is switched off." << G4endl;
+    }
+    return;
+  }
+
+  // Later runs set the radius when they cull a track
+  Run *run = dynamic_cast<Run *>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  if (run) {
+    run->GetEscapeCullingProfile().SetBoundingRadius(bounding_radius + margin);
+  }
+
+  if (G4Threading::G4GetThreadId() <= 0) {
+    if (!utrPhaseSpaceTools::isRecording()) {
+      G4cout << "SteppingAction: No phase-space file is recorded, the PhaseSpaceSD volumes do not extend the culling radius." << G4endl;
+    }
+    G4cout << "SteppingAction: Tracks are culled when they move outwards outside of a radius of " << G4BestUnit(bounding_radius, "Length") << " (+ a margin of " << G4BestUnit(margin, "Length") << ")" << G4endl;
+  }
+}
+
+G4bool SteppingAction::ExtendBoundingRadius(const G4VPhysicalVolume *physical, const G4Transform3D &local_to_global) {
+  const G4LogicalVolume *logical = physical->GetLogicalVolume();
+
+  // The daughters of a sensitive volume are inside of it
+  if (IsSensitive(logical)) {
+    ExtendBoundingRadius(logical->GetSolid(), local_to_global);
+    return true;
+  }
+
+  G4bool any_sensitive = false;
+  for (size_t i = 0; i < (size_t)logical->GetNoDaughters(); ++i) {
+    const G4VPhysicalVolume *daughter = logical->GetDaughter((G4int)i);
+
+    // The coordinate transformation of replicated volumes depends on the copy number, but
+    // all copies are inside of the mother volume
+    if (daughter->IsReplicated()) {
+      if (ContainsSensitiveDetector(daughter->GetLogicalVolume())) {
+        ExtendBoundingRadius(logical->GetSolid(), local_to_global);
+        any_sensitive = true;
+      }
+      continue;
+    }
+
+    if (ExtendBoundingRadius(daughter, local_to_global * G4Transform3D(daughter->GetObjectRotationValue(), daughter->GetObjectTranslation()))) {
+      any_sensitive = true;
+    }
+  }
+
+  return any_sensitive;
+}
+
+void SteppingAction::ExtendBoundingRadius(const G4VSolid *solid, const G4Transform3D &local_to_global) {
+  G4ThreeVector bounding_min, bounding_max;
+  solid->BoundingLimits(bounding_min, bounding_max);
+
+  for (int i = 0; i < 8; ++i) {
+    const G4Point3D corner = local_to_global * G4Point3D(i & 1 ? bounding_max.x() : bounding_min.x(), i & 2 ? bounding_max.y() : bounding_min.y(), i & 4 ? bounding_max.z() : bounding_min.z());
+    bounding_radius = std::max(bounding_radius, corner.mag());
+  }
+}
+
+void SteppingAction::SuppressSampledOutput(const G4Step *step) {
+  // The secondaries of the first sampled step would also exist with the culling, since a culled track is
+  // killed after its step. The ones of the following steps would not.
+  const std::vector<const G4Track *> *secondaries = step->GetSecondaryInCurrentStep();
+  if (secondaries) {
+    for (auto secondary : *secondaries) {
+      const_cast<G4Track *>(secondary)->SetTrackStatus(fStopAndKill);
+    }
+  }
+
+  // The hits of a step are processed in the volume of its pre-step point, so a track that has just
+  // entered a sensitive volume is killed before it deposits any energy there
+  const G4VPhysicalVolume *next_volume = step->GetPostStepPoint()->GetPhysicalVolume();
+  if (next_volume != nullptr && IsSensitive(next_volume->GetLogicalVolume())) {
+    step->GetTrack()->SetTrackStatus(fStopAndKill);
+  }
+}
+
+G4bool SteppingAction::IsSensitive(const G4LogicalVolume *logical) {
+  G4VSensitiveDetector *sd = logical->GetSensitiveDetector();
+  if (sd == nullptr) {
+    return false;
+  }
+  // A phase-space plane only records anything if a phase-space file is given. Otherwise, it may
+  // be far away from the detectors, for example behind the collimator, and would inflate the
+  // bounding sphere.
+  return utrPhaseSpaceTools::isRecording() || dynamic_cast<PhaseSpaceSD *>(sd) == nullptr;
+}
+
+G4bool SteppingAction::ContainsSensitiveDetector(const G4LogicalVolume *logical) {
+  if (IsSensitive(logical)) {
+    return true;
+  }
+  for (size_t i = 0; i < (size_t)logical->GetNoDaughters(); ++i) {
+    if (ContainsSensitiveDetector(logical->GetDaughter((G4int)i)->GetLogicalVolume())) {
+      return true;
+    }
+  }
+  return false;
+}
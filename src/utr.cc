@@ -26,11 +26,13 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 #include "G4VisManager.hh"
 
 #include "ActionInitialization.hh"
-#include "DetectorConstruction.hh"
+#include "DetectorConstructionFactory.hh"
 #include "Physics.hh"
 #include "utrFilenameTools.hh"
 #include "utrMessenger.hh"
 
+#include "utrConfig.h"
+
 #ifdef EVENT_EVENTWISE
 #include "EnergyDepositionSD.hh"
 #endif
@@ -55,6 +57,10 @@ static struct argp_option options[] = {
     {"nthreads", 't', "THREAD", 0, "Number of threads", 0},
     {"outputdir", 'o', "OUTPUTDIR", 0, "Output directory", 0},
     {"filename", 'f', "PREFIX", 0, "Output files' name prefix", 0},
+    {"seed", 's', "SEED", 0, "Random number seed (default: current time)", 0},
+    {"geometry", 'g', "CAMPAIGN/DETECTOR_CONSTRUCTION", 0, "Geometry (default: the one selected by the CAMPAIGN and DETECTOR_CONSTRUCTION build options)", 0},
+    {"geometry-parameter", 'p', "NAME=VALUE", 0, "Set a parameter of the geometry, can be used multiple times", 0},
+    {"list-geometries", 'l', 0, 0, "List the available geometries and exit", 0},
     {0, 0, 0, 0, 0, 0}};
 
 struct arguments {
@@ -62,6 +68,10 @@ struct arguments {
   char *macrofile = 0;
   string outputdir = "output";
   string filenameprefix = "utr";
+  bool useseed = false;
+  long seed = 0;
+  string geometry = default_geometry;
+  bool listgeometries = false;
 };
 
 static error_t parse_opt(int key, char *arg, struct argp_state *state) {
@@ -79,6 +89,25 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
     case 'f':
       arguments->filenameprefix = arg;
       break;
+    case 's':
+      arguments->useseed = true;
+      arguments->seed = atol(arg);
+      break;
+    case 'g':
+      arguments->geometry = arg;
+      break;
+    case 'p': {
+      const string parameter = arg;
+      const size_t separator = parameter.find('=');
+      if (separator == string::npos) {
+        argp_error(state, "Geometry parameters must be given as NAME=VALUE, got '%s'", arg);
+      }
+      DetectorConstructionFactory::SetParameter(parameter.substr(0, separator), parameter.substr(separator + 1));
+      break;
+    }
+    case 'l':
+      arguments->listgeometries = true;
+      break;
     default:
       return ARGP_ERR_UNKNOWN;
   }
@@ -92,12 +121,23 @@ int main(int argc, char *argv[]) {
   struct arguments arguments;
   argp_parse(&argp, argc, argv, 0, 0, &arguments);
 
+  if (arguments.listgeometries) {
+    for (auto geometry : DetectorConstructionFactory::GetGeometries()) {
+      G4cout << geometry << G4endl;
+    }
+    return 0;
+  }
+
   G4Random::setTheEngine(new CLHEP::RanecuEngine);
-  // 'Real' random results
-  time_t timer;
-  G4Random::setTheSeed(time(&timer));
-  // Deterministic results
-  // G4Random::setTheSeed(1);
+  if (arguments.useseed) {
+    // Deterministic results
+    G4Random::setTheSeed(arguments.seed);
+  } else {
+    // 'Real' random results
+    time_t timer;
+    G4Random::setTheSeed(time(&timer));
+  }
+  G4cout << "Random number seed: " << G4Random::getTheSeed() << G4endl;
 
   // Pass output directory and filenamePrefix to RunAction via utrFilenameTools, also find next free filename ID
   utrFilenameTools::setOutputDir(arguments.outputdir);
@@ -111,8 +151,8 @@ int main(int argc, char *argv[]) {
   G4RunManager *runManager = new G4RunManager;
 #endif
 
-  G4cout << "Initializing DetectorConstruction..." << G4endl;
-  runManager->SetUserInitialization(new DetectorConstruction);
+  G4cout << "Initializing DetectorConstruction " << arguments.geometry << "..." << G4endl;
+  runManager->SetUserInitialization(DetectorConstructionFactory::Create(arguments.geometry));
 
   G4cout << "Initializing PhysicsList..." << G4endl;
   Physics *physicsList = new Physics();
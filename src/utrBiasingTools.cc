@@ -0,0 +1,127 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "utrBiasingTools.hh"
+
+#include <cmath>
+
+#include "G4BOptrForceCollision.hh"
+#include "G4RunManager.hh"
+#include "G4Threading.hh"
+#include "G4VPhysicalVolume.hh"
+
+#include "Run.hh"
+
+void WeightTally::Merge(const WeightTally &tally) {
+  hits += tally.hits;
+  sum_of_weights += tally.sum_of_weights;
+  sum_of_squared_weights += tally.sum_of_squared_weights;
+}
+
+void WeightTally::Print(G4double thread_time_ns) const {
+  G4cout << "========================================================================" << G4endl;
+  G4cout << "Forced interaction in the target material: " << (utrBiasingTools::getForcedInteraction() ? "on" : "off (analog simulation)") << G4endl;
+  G4cout << "Detector hits             : " << hits << G4endl;
+  if (hits == 0) {
+    G4cout << "========================================================================" << G4endl << G4endl;
+    return;
+  }
+  G4cout << "Sum of the weights        : " << sum_of_weights << G4endl;
+
+  // The variance of the weighted number of hits is estimated by the sum of the squared weights
+  const G4double relative_error = std::sqrt(sum_of_squared_weights) / sum_of_weights;
+  G4cout << "Relative error            : " << relative_error << G4endl;
+
+  // An analog simulation with the same number of primaries would have about sum_of_weights hits with a
+  // Poisson variance of the same size
+  if (utrBiasingTools::getForcedInteraction()) {
+    G4cout << "Variance reduction        : " << sum_of_weights / sum_of_squared_weights << " (estimate for the same number of primaries)" << G4endl;
+  }
+
+  if (thread_time_ns > 0.) {
+    const G4double thread_time_h = thread_time_ns * 1e-9 / 3600.;
+    const G4double figure_of_merit = 1. / (relative_error * relative_error * thread_time_h);
+    G4cout << "Thread time               : " << thread_time_ns * 1e-9 << " s" << G4endl;
+    G4cout << "Figure of merit           : " << figure_of_merit << " / h" << G4endl;
+    if (utrBiasingTools::getForcedInteraction()) {
+      if (utrBiasingTools::getAnalogFigureOfMerit() > 0.) {
+        G4cout << "Gain per CPU hour         : " << figure_of_merit / utrBiasingTools::getAnalogFigureOfMerit() << " (analog figure of merit: " << utrBiasingTools::getAnalogFigureOfMerit() << " / h)" << G4endl;
+      } else {
+        G4cout << "(Set the figure of merit of an analog run with /utr/bias/analogFOM to obtain the gain per CPU hour.)" << G4endl;
+      }
+    }
+  }
+  G4cout << "========================================================================" << G4endl << G4endl;
+}
+
+utrBiasingTools::utrBiasingTools() {}
+utrBiasingTools::~utrBiasingTools() {}
+
+bool utrBiasingTools::forcedInteraction = true;
+G4double utrBiasingTools::analogFigureOfMerit = -1.;
+std::set<G4LogicalVolume *> utrBiasingTools::targetVolumes;
+
+G4ThreadLocal G4BOptrForceCollision *utrBiasingTools::forceCollision = nullptr;
+
+void utrBiasingTools::attachOperators() {
+  if (!forcedInteraction || forceCollision != nullptr) {
+    return;
+  }
+
+  if (targetVolumes.empty()) {
+    if (G4Threading::IsMasterThread()) {
+      G4cout << "utrBiasingTools: The geometry has registered no target-material volume with utrBiasingTools::addTargetVolume, no interaction is forced." << G4endl;
+    }
+    return;
+  }
+
+  forceCollision = new G4BOptrForceCollision("gamma", "utrForceCollision");
+  std::set<G4LogicalVolume *> attached;
+  for (auto logical : targetVolumes) {
+    attachOperator(logical, attached);
+  }
+
+  if (G4Threading::IsMasterThread()) {
+    G4cout << "utrBiasingTools: Forcing the interaction of photons in " << attached.size() << " target-material logical volume(s)" << G4endl;
+  }
+}
+
+void utrBiasingTools::attachOperator(G4LogicalVolume *logical, std::set<G4LogicalVolume *> &attached) {
+  if (!attached.insert(logical).second) {
+    return;
+  }
+  forceCollision->AttachTo(logical);
+
+  // A daughter of the same material, like the irradiated part of a target, is still target material.
+  // Without the operator, the photons would traverse it unbiased.
+  for (size_t i = 0; i < logical->GetNoDaughters(); ++i) {
+    G4LogicalVolume *daughter = logical->GetDaughter(i)->GetLogicalVolume();
+    if (daughter->GetMaterial() == logical->GetMaterial()) {
+      attachOperator(daughter, attached);
+    }
+  }
+}
+
+void utrBiasingTools::addHit(G4double weight) {
+  Run *run = dynamic_cast<Run *>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  if (run) {
+    run->GetWeightTally().Add(weight);
+  }
+}
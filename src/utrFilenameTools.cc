@@ -40,21 +40,26 @@ string utrFilenameTools::filenamePrefix = "utr";
 unsigned int utrFilenameTools::filenameID = 0;
 bool utrFilenameTools::useFilenameID = true;
 string utrFilenameTools::masterFilename = "";
+bool utrFilenameTools::mergeNtuples = false;
 
 unsigned int utrFilenameTools::findNextFreeFilenameID() {
   // Determine the next free filename (with ID) by searching for files with the name
-  // '{utrFilenameTools::filenamePrefix}N.root' or '{utrFilenameTools::filenamePrefix}N_t0.root' in the requested directory
+  // '{utrFilenameTools::filenamePrefix}N.root', '{utrFilenameTools::filenamePrefix}N_t0.root' or
+  // '{utrFilenameTools::filenamePrefix}N_hist.root' (EVENT_HISTOGRAM mode) in the requested directory
   G4FileUtilities fileutil;
   stringstream filename_single;
   stringstream filename_multi;
+  stringstream filename_hist;
   unsigned int fid = 0;
   for (fid = 0; fid < INT_MAX; ++fid) {
     filename_single << outputDir << "/" << filenamePrefix << fid << ".root";
     filename_multi << outputDir << "/" << filenamePrefix << fid << "_t0.root";
+    filename_hist << outputDir << "/" << filenamePrefix << fid << "_hist.root";
 
-    if (fileutil.FileExists(filename_single.str()) || fileutil.FileExists(filename_multi.str())) {
+    if (fileutil.FileExists(filename_single.str()) || fileutil.FileExists(filename_multi.str()) || fileutil.FileExists(filename_hist.str())) {
       filename_single.str("");
       filename_multi.str("");
+      filename_hist.str("");
       continue;
     }
     break;
@@ -105,3 +110,13 @@ void utrFilenameTools::deleteMasterFilename() {
     std::remove(masterFilename.c_str());
   }
 }
+
+string utrFilenameTools::getMergedFilename() {
+  stringstream filename;
+  filename << outputDir << "/" << filenamePrefix;
+  if (useFilenameID) {
+    filename << filenameID;
+  }
+  filename << ".root";
+  return filename.str();
+}
@@ -0,0 +1,196 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "utrHistogramTools.hh"
+#include "utrFilenameTools.hh"
+
+#include "G4RootAnalysisManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+#include "globals.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using std::stringstream;
+
+// Approximate memory of a histogram bin of Geant4 (number of entries, sums of the weights, the squared weights
+// and the weighted first and second moments, the latter two in a vector per bin)
+#define HISTOGRAM_BYTES_PER_BIN 100
+// Histograms of all points of a scan that need more memory per thread than this trigger a warning
+#define HISTOGRAM_MEMORY_WARNING (1024. * 1024. * 1024.)
+
+utrHistogramTools::utrHistogramTools() {}
+utrHistogramTools::~utrHistogramTools() {}
+
+// Defaults are the same as the ones of getHistogram
+G4double utrHistogramTools::binning = 1. * keV;
+G4double utrHistogramTools::maxEnergy = 10. * MeV;
+vector<vector<unsigned int>> utrHistogramTools::addbackGroups = vector<vector<unsigned int>>();
+
+G4ThreadLocal vector<utrHistogramTools::WeightedDeposition> *utrHistogramTools::depositionBuffer = 0;
+G4ThreadLocal vector<G4double> *utrHistogramTools::edepBuffer = 0;
+G4ThreadLocal vector<unsigned int> *utrHistogramTools::hitDetectors = 0;
+G4ThreadLocal vector<G4int> *utrHistogramTools::addbackGroupOfDetector = 0;
+G4ThreadLocal G4int utrHistogramTools::firstHistogramID = 0;
+G4ThreadLocal G4int utrHistogramTools::firstSetHistogramID = 0;
+
+bool utrHistogramTools::addAddbackGroup(const vector<unsigned int> &group) {
+  for (auto det : group) {
+    for (const auto &existingGroup : addbackGroups) {
+      for (auto existingDet : existingGroup) {
+        if (det == existingDet) {
+          return false;
+        }
+      }
+    }
+  }
+  addbackGroups.push_back(group);
+  return true;
+}
+
+string utrHistogramTools::getHistogramFilename() {
+  stringstream filename;
+  filename << utrFilenameTools::getOutputDir() << "/" << utrFilenameTools::getFilenamePrefix();
+  if (utrFilenameTools::getUseFilenameID()) {
+    filename << utrFilenameTools::getFilenameID();
+  }
+  filename << "_hist.root";
+  return filename.str();
+}
+
+void utrHistogramTools::book(unsigned int max_detector_ID, const vector<string> &prefixes) {
+  G4RootAnalysisManager *analysisManager = G4RootAnalysisManager::Instance();
+
+  // Same binning as in getHistogram: The first bin is centered around 0, and the upper limit is rounded up to match the binning
+  const G4double emin = -0.5 * binning;
+  const G4int nbins = (G4int)ceil((maxEnergy - emin) / binning);
+  const G4double emax = emin + nbins * binning;
+
+  // All sets are booked at the start of a scan, because the histograms of the worker threads are only merged into the
+  // master thread when the output file is written after the last point. Their memory grows with the number of points.
+  const G4double bytes = (G4double)prefixes.size() * (max_detector_ID + 2) * (nbins + 2) * HISTOGRAM_BYTES_PER_BIN;
+  if (bytes > HISTOGRAM_MEMORY_WARNING && G4Threading::IsMasterThread()) {
+    G4cout << "WARNING: utrHistogramTools: The histograms of " << prefixes.size() << " scan point(s) with " << max_detector_ID + 2 << " histograms of " << nbins << " bins each need about " << bytes / (1024. * 1024.) << " MiB in each thread, including the master thread. Consider a coarser binning (/utr/histogram/binning), a lower maximum energy (/utr/histogram/maxEnergy) or fewer points per scan." << G4endl;
+  }
+
+  // The histograms of a set have IDs firstHistogramID + detector ID, the sum histogram comes last.
+  // Geant4 stores the bin contents as doubles, so they are written as TH1D.
+  for (size_t set = 0; set < prefixes.size(); ++set) {
+    for (unsigned int i = 0; i <= max_detector_ID; ++i) {
+      const G4int id = analysisManager->CreateH1(prefixes[set] + "det" + std::to_string(i), "Energy deposition in Detector " + std::to_string(i), nbins, emin, emax);
+      if (set == 0 && i == 0) {
+        firstSetHistogramID = id;
+      }
+    }
+    analysisManager->CreateH1(prefixes[set] + "sum", "Sum spectrum of all detectors", nbins, emin, emax);
+  }
+  firstHistogramID = firstSetHistogramID;
+
+  if (!edepBuffer) {
+    depositionBuffer = new vector<WeightedDeposition>();
+    edepBuffer = new vector<G4double>();
+    hitDetectors = new vector<unsigned int>();
+    addbackGroupOfDetector = new vector<G4int>();
+  }
+  depositionBuffer->clear();
+  edepBuffer->assign(max_detector_ID + 1, 0.);
+  hitDetectors->clear();
+  hitDetectors->reserve(max_detector_ID + 1);
+  addbackGroupOfDetector->assign(max_detector_ID + 1, -1);
+  for (size_t i = 0; i < addbackGroups.size(); ++i) {
+    for (auto det : addbackGroups[i]) {
+      if (det > max_detector_ID) {
+        G4cerr << "ERROR: utrHistogramTools: Detector " << det << " of an addback group exceeds the maximum sensitive detector ID " << max_detector_ID << ". Aborting..." << G4endl;
+        throw std::exception();
+      }
+      (*addbackGroupOfDetector)[det] = (G4int)i;
+    }
+  }
+}
+
+void utrHistogramTools::selectSet(unsigned int set) {
+  // Each set consists of the detector histograms and the sum histogram
+  firstHistogramID = firstSetHistogramID + (G4int)set * ((G4int)edepBuffer->size() + 1);
+}
+
+void utrHistogramTools::addEnergyDeposition(unsigned int detector_ID, G4double edep, G4double weight) {
+  depositionBuffer->push_back({detector_ID, edep, weight});
+}
+
+void utrHistogramTools::fillEvent() {
+  if (depositionBuffer->empty()) {
+    return;
+  }
+
+  // Without FORCED_INTERACTION, all depositions of an event usually have the same weight
+  if (depositionBuffer->size() > 1) {
+    std::stable_sort(depositionBuffer->begin(), depositionBuffer->end(), [](const WeightedDeposition &a, const WeightedDeposition &b) { return a.weight < b.weight; });
+  }
+  for (size_t first = 0; first < depositionBuffer->size();) {
+    const G4double weight = (*depositionBuffer)[first].weight;
+    size_t last = first;
+    for (; last < depositionBuffer->size() && (*depositionBuffer)[last].weight == weight; ++last) {
+      const unsigned int det = (*depositionBuffer)[last].detector_ID;
+      if ((*edepBuffer)[det] == 0.) {
+        hitDetectors->push_back(det);
+      }
+      (*edepBuffer)[det] += (*depositionBuffer)[last].edep;
+    }
+    fillDetectors(weight);
+    first = last;
+  }
+  depositionBuffer->clear();
+}
+
+void utrHistogramTools::fillDetectors(G4double weight) {
+  G4RootAnalysisManager *analysisManager = G4RootAnalysisManager::Instance();
+  const G4int sumHistogramID = firstHistogramID + (G4int)edepBuffer->size();
+
+  for (auto det : *hitDetectors) {
+    G4double edep = (*edepBuffer)[det];
+    if (edep == 0.) { // Already added back to another detector of the same group
+      continue;
+    }
+    unsigned int target = det;
+    const G4int group = (*addbackGroupOfDetector)[det];
+    if (group >= 0) {
+      // Add back the energy depositions in all detectors of the group to the one with the largest energy deposition
+      edep = 0.;
+      for (auto member : addbackGroups[group]) {
+        edep += (*edepBuffer)[member];
+        if ((*edepBuffer)[member] > (*edepBuffer)[target]) {
+          target = member;
+        }
+      }
+      for (auto member : addbackGroups[group]) {
+        (*edepBuffer)[member] = 0.;
+      }
+    }
+    analysisManager->FillH1(firstHistogramID + (G4int)target, edep, weight);
+    analysisManager->FillH1(sumHistogramID, edep, weight);
+  }
+
+  for (auto det : *hitDetectors) {
+    (*edepBuffer)[det] = 0.;
+  }
+  hitDetectors->clear();
+}
@@ -19,9 +19,18 @@ along with utr.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "utrMessenger.hh"
-#include "G4UIcmdWithAnInteger.hh"
+#include "G4ParticleTable.hh"
+#include "G4SystemOfUnits.hh"
 #include "G4UImanager.hh"
+#include "StackingAction.hh"
+#include "SteppingAction.hh"
+#include "utrBiasingTools.hh"
 #include "utrFilenameTools.hh"
+#include "utrHistogramTools.hh"
+#include "utrOutputTools.hh"
+#include "utrPhaseSpaceTools.hh"
+#include "utrRegionTools.hh"
+#include "utrScanTools.hh"
 
 utrMessenger::utrMessenger() {
   utrDirectory = new G4UIdirectory("/utr/");
@@ -37,14 +46,260 @@ utrMessenger::utrMessenger() {
   setUseFilenameIDCmd->SetParameterName("useFilenameID", true);
   setUseFilenameIDCmd->SetDefaultValue(true);
 
+  mergeNtuplesCmd = new G4UIcmdWithABool("/utr/mergeNtuples", this);
+  mergeNtuplesCmd->SetGuidance("Set whether the ntuples of all threads are merged into a single output file {PREFIX}{ID}.root instead of one file per thread (default: false)");
+  mergeNtuplesCmd->SetGuidance("The content of the entries is the same, but the order of the entries of different threads is not reproducible.");
+  mergeNtuplesCmd->SetParameterName("mergeNtuples", true);
+  mergeNtuplesCmd->SetDefaultValue(true);
+
   appendZerosToVarCmd = new G4UIcmdWithAString("/utr/appendZerosToVar", this);
   appendZerosToVarCmd->SetGuidance("Set an UI/macro alias (a variable) to the given numerical value appending a decimal dot and the requested number of zeros if necessary");
   appendZerosToVarCmd->SetParameterName("variableName> <variableValue> <numberOfDecimalDigits", false);
+
+  scanDirectory = new G4UIdirectory("/utr/scan/");
+  scanDirectory->SetGuidance("Controls for scans, which run the simulation for a list of parameter points in the same process.");
+  scanDirectory->SetGuidance("The output of all points is written to the same output file(s), with the prefix p<POINT>_ in the names of the histograms or ntuples.");
+
+  scanMacroCmd = new G4UIcmdWithAString("/utr/scan/macro", this);
+  scanMacroCmd->SetGuidance("Set the macro that is executed for each point before its run, in which the parameters of the point are available as aliases {NAME}");
+  scanMacroCmd->SetGuidance("For example, a line '/gps/ene/mono {E} MeV' sets the energy of the point. The macro must not contain /run/beamOn.");
+  scanMacroCmd->SetParameterName("macroFile", false);
+
+  scanAddPointCmd = new G4UIcmdWithAString("/utr/scan/addPoint", this);
+  scanAddPointCmd->SetGuidance("Add a point with the given parameter values, for example 'E=2.5 z=10'");
+  scanAddPointCmd->SetParameterName("name1=value1> <name2=value2> <...", false);
+
+  scanClearCmd = new G4UIcmdWithoutParameter("/utr/scan/clear", this);
+  scanClearCmd->SetGuidance("Remove all points");
+
+  scanBeamOnCmd = new G4UIcmdWithAnInteger("/utr/scan/beamOn", this);
+  scanBeamOnCmd->SetGuidance("Run the given number of events for each point and print a summary of the run times");
+  scanBeamOnCmd->SetParameterName("numberOfEvents", false);
+  scanBeamOnCmd->SetRange("numberOfEvents > 0");
+  scanBeamOnCmd->AvailableForStates(G4State_Idle);
+
+  regionDirectory = new G4UIdirectory("/utr/region/");
+  regionDirectory->SetGuidance("Controls for the regions 'detector', 'target', 'shielding' and 'infrastructure' of the geometry.");
+  regionDirectory->SetGuidance("The volumes of each region are defined by the geometry, all other volumes use the global settings.");
+
+  regionCutCmd = new G4UIcmdWithAString("/utr/region/cut", this);
+  regionCutCmd->SetGuidance("Set the production cut of a region, for example 'shielding 1 cm', or 'shielding default' for the global production cut");
+  regionCutCmd->SetParameterName("region> <cut> <unit", false);
+  regionCutCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  regionEmPhysicsCmd = new G4UIcmdWithAString("/utr/region/emPhysics", this);
+  regionEmPhysicsCmd->SetGuidance("Set the EM physics of a region, for example 'detector G4EmLivermore', or 'detector default' for the global EM physics");
+  regionEmPhysicsCmd->SetGuidance("The possible types are the ones of G4EmParameters::AddPhysics, for example G4EmStandard, G4EmStandard_opt1 to G4EmStandard_opt4, G4EmLivermore and G4EmPenelope");
+  regionEmPhysicsCmd->SetParameterName("region> <type", false);
+  regionEmPhysicsCmd->AvailableForStates(G4State_PreInit);
+
+  stackingDirectory = new G4UIdirectory("/utr/stacking/");
+  stackingDirectory->SetGuidance("Rules to kill new secondary tracks which are irrelevant for the sensitive detectors. Primary particles are never killed.");
+  stackingDirectory->SetGuidance("A track is killed by the first rule that matches it. The number of killed tracks of each rule is printed at the end of each run.");
+  stackingDirectory->SetGuidance("The optional particle of a rule is a Geant4 particle name like e- or gamma, 'all' or no particle means all particles.");
+
+  stackingKillParticleCmd = new G4UIcmdWithAString("/utr/stacking/killParticle", this);
+  stackingKillParticleCmd->SetGuidance("Kill all secondary tracks of a particle, for example 'nu_e'");
+  stackingKillParticleCmd->SetParameterName("particle", false);
+  stackingKillParticleCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  stackingKillBelowCmd = new G4UIcmdWithAString("/utr/stacking/killBelow", this);
+  stackingKillBelowCmd->SetGuidance("Kill secondary tracks with a kinetic energy below the given one, for example '10 keV e-'");
+  stackingKillBelowCmd->SetGuidance("Their energy is not deposited. Inside sensitive detectors, this changes the energy depositions.");
+  stackingKillBelowCmd->SetParameterName("energy> <unit> <particle", false);
+  stackingKillBelowCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  stackingKillInVolumeCmd = new G4UIcmdWithAString("/utr/stacking/killInVolume", this);
+  stackingKillInVolumeCmd->SetGuidance("Kill secondary tracks which are created in a logical volume, for example 'BaseSupportZXLV e-' for a part of the Blowfish frame");
+  stackingKillInVolumeCmd->SetParameterName("logicalVolume> <particle", false);
+  stackingKillInVolumeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  stackingKillInRegionCmd = new G4UIcmdWithAString("/utr/stacking/killInRegion", this);
+  stackingKillInRegionCmd->SetGuidance("Kill secondary tracks which are created in one of the regions detector, target, shielding or infrastructure, for example 'shielding e-'");
+  stackingKillInRegionCmd->SetParameterName("region> <particle", false);
+  stackingKillInRegionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  stackingKillUnreachableCmd = new G4UIcmdWithAString("/utr/stacking/killUnreachable", this);
+  stackingKillUnreachableCmd->SetGuidance("Kill charged secondary tracks outside of the sensitive detectors, whose range is shorter than the distance to the closest volume boundary");
+  stackingKillUnreachableCmd->SetGuidance("These tracks deposit their energy in the volume in which they are created, apart from bremsstrahlung and fluorescence photons.");
+  stackingKillUnreachableCmd->SetParameterName("particle", true);
+  stackingKillUnreachableCmd->SetDefaultValue("all");
+  stackingKillUnreachableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  stackingClearCmd = new G4UIcmdWithoutParameter("/utr/stacking/clear", this);
+  stackingClearCmd->SetGuidance("Remove all rules");
+  stackingClearCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+#ifdef ESCAPE_CULLING
+  cullDirectory = new G4UIdirectory("/utr/cull/");
+  cullDirectory->SetGuidance("Controls for the culling of tracks which leave the bounding sphere of the sensitive detectors on an outgoing trajectory.");
+
+  cullRoomScatterCmd = new G4UIcmdWithABool("/utr/cull/roomScatter", this);
+  cullRoomScatterCmd->SetGuidance("Set whether to simulate the scattering outside of the bounding sphere, i.e. switch off the culling (default: false)");
+  cullRoomScatterCmd->SetParameterName("roomScatter", true);
+  cullRoomScatterCmd->SetDefaultValue(true);
+  cullRoomScatterCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  cullMarginCmd = new G4UIcmdWithADoubleAndUnit("/utr/cull/margin", this);
+  cullMarginCmd->SetGuidance("Set the distance that tracks may move outwards beyond the bounding sphere before they are culled (default: 0 mm)");
+  cullMarginCmd->SetParameterName("margin", false);
+  cullMarginCmd->SetDefaultUnit("mm");
+  cullMarginCmd->SetRange("margin >= 0.");
+  cullMarginCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  cullSampleEveryCmd = new G4UIcmdWithAnInteger("/utr/cull/sampleEvery", this);
+  cullSampleEveryCmd->SetGuidance("Follow every n-th escaping track instead of culling it, to estimate the saved steps and time (default: 100, 0 culls all tracks)");
+  cullSampleEveryCmd->SetGuidance("The followed tracks create no secondaries and no hits, so the output is the same as without sampling.");
+  cullSampleEveryCmd->SetParameterName("n", false);
+  cullSampleEveryCmd->SetRange("n >= 0");
+  cullSampleEveryCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+#endif
+
+#ifdef FORCED_INTERACTION
+  biasDirectory = new G4UIdirectory("/utr/bias/");
+  biasDirectory->SetGuidance("Controls for the forced interaction of photons in the target material.");
+
+  biasForcedInteractionCmd = new G4UIcmdWithABool("/utr/bias/forcedInteraction", this);
+  biasForcedInteractionCmd->SetGuidance("Set whether to force the interaction of photons in the target material (default: true)");
+  biasForcedInteractionCmd->SetGuidance("Without it, the simulation is analog, which allows to determine the figure of merit for a comparison.");
+  biasForcedInteractionCmd->SetParameterName("forcedInteraction", true);
+  biasForcedInteractionCmd->SetDefaultValue(true);
+  biasForcedInteractionCmd->AvailableForStates(G4State_PreInit);
+
+  biasAnalogFOMCmd = new G4UIcmdWithADouble("/utr/bias/analogFOM", this);
+  biasAnalogFOMCmd->SetGuidance("Set the figure of merit (in 1/h) of an analog run, to print the gain of the forced interaction at the end of each run");
+  biasAnalogFOMCmd->SetParameterName("fom", false);
+  biasAnalogFOMCmd->SetRange("fom > 0.");
+  biasAnalogFOMCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+#endif
+
+  phaseSpaceDirectory = new G4UIdirectory("/utr/phaseSpace/");
+  phaseSpaceDirectory->SetGuidance("Controls for two-stage simulations, which record the particles that enter a PhaseSpaceSD in a phase-space file and replay them with the PhaseSpaceGenerator.");
+
+  phaseSpaceRecordCmd = new G4UIcmdWithAString("/utr/phaseSpace/record", this);
+  phaseSpaceRecordCmd->SetGuidance("Set the phase-space file to which the particles that enter a PhaseSpaceSD are written at the end of the run (default: '', no recording)");
+  phaseSpaceRecordCmd->SetGuidance("The file must not exist yet.");
+  phaseSpaceRecordCmd->SetParameterName("filename", true);
+  phaseSpaceRecordCmd->SetDefaultValue("");
+  phaseSpaceRecordCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  phaseSpaceKillRecordedCmd = new G4UIcmdWithABool("/utr/phaseSpace/killRecorded", this);
+  phaseSpaceKillRecordedCmd->SetGuidance("Set whether the recorded particles are killed, since they are transported further in the second stage (default: true)");
+  phaseSpaceKillRecordedCmd->SetParameterName("killRecorded", true);
+  phaseSpaceKillRecordedCmd->SetDefaultValue(true);
+  phaseSpaceKillRecordedCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+#ifdef GENERATOR_PHASESPACE
+  phaseSpaceReplayCmd = new G4UIcmdWithAString("/utr/phaseSpace/replay", this);
+  phaseSpaceReplayCmd->SetGuidance("Set the phase-space file that is replayed by the PhaseSpaceGenerator");
+  phaseSpaceReplayCmd->SetParameterName("filename", false);
+  phaseSpaceReplayCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  phaseSpaceAccessCmd = new G4UIcmdWithAString("/utr/phaseSpace/access", this);
+  phaseSpaceAccessCmd->SetGuidance("Set whether the records are read in order, shared by all threads, or at random (default: sequential)");
+  phaseSpaceAccessCmd->SetParameterName("access", false);
+  phaseSpaceAccessCmd->SetCandidates("sequential random");
+  phaseSpaceAccessCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  phaseSpaceRecycleCmd = new G4UIcmdWithAnInteger("/utr/phaseSpace/recycle", this);
+  phaseSpaceRecycleCmd->SetGuidance("Set how many times each record is used (default: 1). The recycled particles are rotated by a random angle about the z axis.");
+  phaseSpaceRecycleCmd->SetParameterName("n", false);
+  phaseSpaceRecycleCmd->SetRange("n >= 1");
+  phaseSpaceRecycleCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+#endif
+
+#if !defined(EVENT_HISTOGRAM) && !defined(EVENT_EVENTWISE_SPARSE) && !defined(EVENT_EVENTWISE)
+  outputDirectory = new G4UIdirectory("/utr/output/");
+  outputDirectory->SetGuidance("Controls for the quantities in the output file (must be set before /run/beamOn).");
+  outputDirectory->SetGuidance("The quantities are ID, EDEP, EKIN, PARTICLE, VOLUME, POSX, POSY, POSZ, MOMX, MOMY, MOMZ and WEIGHT, the default is given by the EVENT_* build options.");
+
+  outputQuantitiesCmd = new G4UIcmdWithAString("/utr/output/quantities", this);
+  outputQuantitiesCmd->SetGuidance("Set the quantities that are saved to the output file, for example 'EDEP PARTICLE VOLUME'");
+  outputQuantitiesCmd->SetParameterName("quantity1> <quantity2> <...", false);
+  outputQuantitiesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  outputRecordCmd = new G4UIcmdWithAString("/utr/output/record", this);
+  outputRecordCmd->SetGuidance("Set whether a single quantity is saved to the output file, for example 'POSX true'");
+  outputRecordCmd->SetParameterName("quantity> <record", false);
+  outputRecordCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+#endif
+
+#ifdef EVENT_HISTOGRAM
+  histogramDirectory = new G4UIdirectory("/utr/histogram/");
+  histogramDirectory->SetGuidance("Controls for the histograms of the EVENT_HISTOGRAM output mode (must be set before /run/beamOn).");
+
+  histogramBinningCmd = new G4UIcmdWithADoubleAndUnit("/utr/histogram/binning", this);
+  histogramBinningCmd->SetGuidance("Set the size of the bins of the energy deposition histograms (default: 1 keV)");
+  histogramBinningCmd->SetParameterName("binning", false);
+  histogramBinningCmd->SetRange("binning > 0.");
+  histogramBinningCmd->SetDefaultUnit("keV");
+
+  histogramMaxEnergyCmd = new G4UIcmdWithADoubleAndUnit("/utr/histogram/maxEnergy", this);
+  histogramMaxEnergyCmd->SetGuidance("Set the maximum energy of the energy deposition histograms, rounded up to match the binning (default: 10 MeV)");
+  histogramMaxEnergyCmd->SetParameterName("maxEnergy", false);
+  histogramMaxEnergyCmd->SetRange("maxEnergy > 0.");
+  histogramMaxEnergyCmd->SetDefaultUnit("MeV");
+
+  histogramAddbackCmd = new G4UIcmdWithAString("/utr/histogram/addback", this);
+  histogramAddbackCmd->SetGuidance("Define a group of detector IDs (for example the crystals of a clover) whose energy depositions in an event are added back.");
+  histogramAddbackCmd->SetGuidance("The sum is filled into the histogram of the detector of the group with the largest energy deposition.");
+  histogramAddbackCmd->SetParameterName("detectorID1> <detectorID2> <...", false);
+
+  histogramClearAddbackCmd = new G4UIcmdWithoutParameter("/utr/histogram/clearAddback", this);
+  histogramClearAddbackCmd->SetGuidance("Remove all addback groups");
+#endif
 }
 
 utrMessenger::~utrMessenger() {
   delete setFilenameCmd;
   delete setUseFilenameIDCmd;
+  delete mergeNtuplesCmd;
+  delete scanMacroCmd;
+  delete scanAddPointCmd;
+  delete scanClearCmd;
+  delete scanBeamOnCmd;
+  delete scanDirectory;
+  delete regionCutCmd;
+  delete regionEmPhysicsCmd;
+  delete regionDirectory;
+  delete stackingKillParticleCmd;
+  delete stackingKillBelowCmd;
+  delete stackingKillInVolumeCmd;
+  delete stackingKillInRegionCmd;
+  delete stackingKillUnreachableCmd;
+  delete stackingClearCmd;
+  delete stackingDirectory;
+#ifdef ESCAPE_CULLING
+  delete cullRoomScatterCmd;
+  delete cullMarginCmd;
+  delete cullSampleEveryCmd;
+  delete cullDirectory;
+#endif
+#ifdef FORCED_INTERACTION
+  delete biasForcedInteractionCmd;
+  delete biasAnalogFOMCmd;
+  delete biasDirectory;
+#endif
+  delete phaseSpaceRecordCmd;
+  delete phaseSpaceKillRecordedCmd;
+#ifdef GENERATOR_PHASESPACE
+  delete phaseSpaceReplayCmd;
+  delete phaseSpaceAccessCmd;
+  delete phaseSpaceRecycleCmd;
+#endif
+  delete phaseSpaceDirectory;
+#if !defined(EVENT_HISTOGRAM) && !defined(EVENT_EVENTWISE_SPARSE) && !defined(EVENT_EVENTWISE)
+  delete outputQuantitiesCmd;
+  delete outputRecordCmd;
+  delete outputDirectory;
+#endif
+#ifdef EVENT_HISTOGRAM
+  delete histogramBinningCmd;
+  delete histogramMaxEnergyCmd;
+  delete histogramAddbackCmd;
+  delete histogramClearAddbackCmd;
+  delete histogramDirectory;
+#endif
   delete utrDirectory;
 }
 
@@ -65,6 +320,14 @@ void utrMessenger::SetNewValue(G4UIcommand *command, G4String newValues) {
       }
       utrFilenameTools::setUseFilenameID(arg);
     }
+  } else if (command == mergeNtuplesCmd) {
+    bool arg = mergeNtuplesCmd->GetNewBoolValue(newValues);
+    if (arg) {
+      G4cout << "Turning on merging of the ntuples of all threads into a single output file" << G4endl;
+    } else {
+      G4cout << "Turning off merging of the ntuples of all threads into a single output file" << G4endl;
+    }
+    utrFilenameTools::setMergeNtuples(arg);
   } else if (command == appendZerosToVarCmd) {
     // This command can be used to append a decimal dot and a number of zeros to an alias if necessary to
     // get more uniform filenames in combination with the setFilename command in macro loops.
@@ -122,6 +385,182 @@ void utrMessenger::SetNewValue(G4UIcommand *command, G4String newValues) {
       G4UImanager *UImanager = G4UImanager::GetUIpointer();
       UImanager->ApplyCommand(aliasCommand.str());
     }
+  } else if (command == scanMacroCmd) {
+    utrScanTools::setMacro(newValues);
+  } else if (command == scanAddPointCmd) {
+    if (!utrScanTools::addPoint(newValues)) {
+      G4cerr << "Error! The parameters of a point must be given as NAME=VALUE!" << G4endl;
+    }
+  } else if (command == scanClearCmd) {
+    utrScanTools::clearPoints();
+  } else if (command == scanBeamOnCmd) {
+    utrScanTools::beamOn(scanBeamOnCmd->GetNewIntValue(newValues));
+  } else if (command == regionCutCmd) {
+    std::vector<G4String> parameters;
+    std::istringstream iStrStream(newValues);
+    for (std::string s; iStrStream >> s;) {
+      parameters.push_back(s);
+    }
+    if (parameters.size() < 2 || !utrRegionTools::isRegionName(parameters[0])) {
+      G4cerr << "Error! Need one of the regions detector, target, shielding or infrastructure and a cut with unit or 'default'!" << G4endl;
+    } else if (parameters[1] == "default") {
+      utrRegionTools::setProductionCut(parameters[0], -1.);
+      utrRegionTools::applyProductionCuts();
+    } else if (parameters.size() != 3) {
+      G4cerr << "Error! The cut needs a unit!" << G4endl;
+    } else {
+      const G4double cut = G4UIcommand::ConvertToDimensionedDouble((parameters[1] + " " + parameters[2]).c_str());
+      if (cut <= 0.) {
+        G4cerr << "Error! The cut has to be positive!" << G4endl;
+      } else {
+        utrRegionTools::setProductionCut(parameters[0], cut);
+        // Between runs, the new cut is used from the next run on
+        utrRegionTools::applyProductionCuts();
+      }
+    }
+  } else if (command == regionEmPhysicsCmd) {
+    std::vector<G4String> parameters;
+    std::istringstream iStrStream(newValues);
+    for (std::string s; iStrStream >> s;) {
+      parameters.push_back(s);
+    }
+    if (parameters.size() != 2 || !utrRegionTools::isRegionName(parameters[0])) {
+      G4cerr << "Error! Need one of the regions detector, target, shielding or infrastructure and an EM physics type or 'default'!" << G4endl;
+    } else {
+      utrRegionTools::setEmPhysics(parameters[0], parameters[1] == "default" ? G4String("") : parameters[1]);
+    }
+  } else if (command == stackingKillParticleCmd || command == stackingKillBelowCmd || command == stackingKillInVolumeCmd || command == stackingKillInRegionCmd || command == stackingKillUnreachableCmd) {
+    std::vector<G4String> parameters;
+    std::istringstream iStrStream(newValues);
+    for (std::string s; iStrStream >> s;) {
+      parameters.push_back(s);
+    }
+
+    StackingRule rule = {"", "", "", 0., false, command->GetCommandName() + " " + newValues};
+    // Number of parameters before the particle
+    size_t nParameters = 0;
+    if (command == stackingKillParticleCmd) {
+      if (parameters.size() != 1) {
+        G4cerr << "Error! Need a particle!" << G4endl;
+        return;
+      }
+    } else if (command == stackingKillBelowCmd) {
+      nParameters = 2;
+      if (parameters.size() < 2 || parameters.size() > 3 || G4UIcommand::ConvertToDimensionedDouble((parameters[0] + " " + parameters[1]).c_str()) <= 0.) {
+        G4cerr << "Error! Need a positive energy with unit and optionally a particle!" << G4endl;
+        return;
+      }
+      rule.max_energy = G4UIcommand::ConvertToDimensionedDouble((parameters[0] + " " + parameters[1]).c_str());
+    } else if (command == stackingKillInVolumeCmd) {
+      nParameters = 1;
+      if (parameters.size() < 1 || parameters.size() > 2) {
+        G4cerr << "Error! Need a logical volume and optionally a particle!" << G4endl;
+        return;
+      }
+      rule.volume = parameters[0];
+    } else if (command == stackingKillInRegionCmd) {
+      nParameters = 1;
+      if (parameters.size() < 1 || parameters.size() > 2 || !utrRegionTools::isRegionName(parameters[0])) {
+        G4cerr << "Error! Need one of the regions detector, target, shielding or infrastructure and optionally a particle!" << G4endl;
+        return;
+      }
+      rule.region = parameters[0];
+    } else {
+      if (parameters.size() > 1) {
+        G4cerr << "Error! Need at most one particle!" << G4endl;
+        return;
+      }
+      rule.unreachable = true;
+    }
+
+    if (parameters.size() > nParameters && parameters[nParameters] != "all") {
+      if (G4ParticleTable::GetParticleTable()->FindParticle(parameters[nParameters]) == nullptr) {
+        G4cerr << "Error! Unknown particle '" << parameters[nParameters] << "'!" << G4endl;
+        return;
+      }
+      rule.particle = parameters[nParameters];
+    }
+    StackingAction::AddRule(rule);
+  } else if (command == stackingClearCmd) {
+    StackingAction::ClearRules();
+#ifdef ESCAPE_CULLING
+  } else if (command == cullRoomScatterCmd) {
+    SteppingAction::SetRoomScatter(cullRoomScatterCmd->GetNewBoolValue(newValues));
+  } else if (command == cullMarginCmd) {
+    SteppingAction::SetMargin(cullMarginCmd->GetNewDoubleValue(newValues));
+  } else if (command == cullSampleEveryCmd) {
+    SteppingAction::SetSampleEvery(cullSampleEveryCmd->GetNewIntValue(newValues));
+#endif
+#ifdef FORCED_INTERACTION
+  } else if (command == biasForcedInteractionCmd) {
+    utrBiasingTools::setForcedInteraction(biasForcedInteractionCmd->GetNewBoolValue(newValues));
+  } else if (command == biasAnalogFOMCmd) {
+    utrBiasingTools::setAnalogFigureOfMerit(biasAnalogFOMCmd->GetNewDoubleValue(newValues));
+#endif
+  } else if (command == phaseSpaceRecordCmd) {
+    utrPhaseSpaceTools::setRecordFilename(newValues);
+  } else if (command == phaseSpaceKillRecordedCmd) {
+    utrPhaseSpaceTools::setKillRecorded(phaseSpaceKillRecordedCmd->GetNewBoolValue(newValues));
+#ifdef GENERATOR_PHASESPACE
+  } else if (command == phaseSpaceReplayCmd) {
+    utrPhaseSpaceTools::setReplayFilename(newValues);
+  } else if (command == phaseSpaceAccessCmd) {
+    utrPhaseSpaceTools::setSequentialAccess(newValues == "sequential");
+  } else if (command == phaseSpaceRecycleCmd) {
+    utrPhaseSpaceTools::setRecycle(phaseSpaceRecycleCmd->GetNewIntValue(newValues));
+#endif
+#if !defined(EVENT_HISTOGRAM) && !defined(EVENT_EVENTWISE_SPARSE) && !defined(EVENT_EVENTWISE)
+  } else if (command == outputQuantitiesCmd) {
+    std::vector<G4String> quantities;
+    std::istringstream iStrStream(newValues);
+    for (std::string s; iStrStream >> s;) {
+      quantities.push_back(s);
+    }
+    if (quantities.empty()) {
+      G4cerr << "Error! At least one quantity has to be saved!" << G4endl;
+    } else if (!utrOutputTools::setRecordQuantities(quantities)) {
+      G4cerr << "Error! Unknown quantity in '" << newValues << "'!" << G4endl;
+    }
+  } else if (command == outputRecordCmd) {
+    std::vector<G4String> parameters;
+    std::istringstream iStrStream(newValues);
+    for (std::string s; iStrStream >> s;) {
+      parameters.push_back(s);
+    }
+    const bool record = parameters.size() < 2 || G4UIcmdWithABool::GetNewBoolValue(parameters[1]);
+    if (parameters.empty() || parameters.size() > 2) {
+      G4cerr << "Error! Need a quantity and optionally true or false!" << G4endl;
+    } else if (!utrOutputTools::setRecordQuantity(parameters[0], record)) {
+      G4cerr << "Error! Unknown quantity '" << parameters[0] << "'!" << G4endl;
+    } else if (utrOutputTools::getSelection() == "") {
+      G4cerr << "Error! At least one quantity has to be saved!" << G4endl;
+      utrOutputTools::setRecordQuantity(parameters[0], true);
+    }
+#endif
+#ifdef EVENT_HISTOGRAM
+  } else if (command == histogramBinningCmd) {
+    utrHistogramTools::setBinning(histogramBinningCmd->GetNewDoubleValue(newValues));
+  } else if (command == histogramMaxEnergyCmd) {
+    utrHistogramTools::setMaxEnergy(histogramMaxEnergyCmd->GetNewDoubleValue(newValues));
+  } else if (command == histogramAddbackCmd) {
+    std::vector<unsigned int> group;
+    std::istringstream iStrStream(newValues);
+    for (std::string s; iStrStream >> s;) {
+      const int detectorID = G4UIcmdWithAnInteger::GetNewIntValue(s);
+      if (detectorID < 0) {
+        G4cerr << "Error! Detector IDs must not be negative!" << G4endl;
+        return;
+      }
+      group.push_back((unsigned int)detectorID);
+    }
+    if (group.size() < 2) {
+      G4cerr << "Error! An addback group needs at least 2 detector IDs!" << G4endl;
+    } else if (!utrHistogramTools::addAddbackGroup(group)) {
+      G4cerr << "Error! A detector can only be part of a single addback group!" << G4endl;
+    }
+  } else if (command == histogramClearAddbackCmd) {
+    utrHistogramTools::clearAddbackGroups();
+#endif
   } else {
     G4cerr << "Error! Unknown command!" << G4endl;
   }
@@ -132,6 +571,85 @@ G4String utrMessenger::GetCurrentValue(G4UIcommand *command) {
     return utrFilenameTools::getFilenamePrefix();
   } else if (command == setUseFilenameIDCmd) {
     return setUseFilenameIDCmd->ConvertToString(utrFilenameTools::getUseFilenameID());
+  } else if (command == mergeNtuplesCmd) {
+    return mergeNtuplesCmd->ConvertToString(utrFilenameTools::getMergeNtuples());
+  } else if (command == scanMacroCmd) {
+    return utrScanTools::getMacro();
+  } else if (command == scanAddPointCmd) {
+    std::stringstream points;
+    for (size_t i = 0; i < utrScanTools::getNPoints(); ++i) {
+      points << "[" << utrScanTools::getPointParameters(i) << "]";
+    }
+    return points.str();
+  } else if (command == regionCutCmd) {
+    std::stringstream cuts;
+    for (const auto &region : utrRegionTools::getRegionNames()) {
+      cuts << "[" << region << " ";
+      if (utrRegionTools::getProductionCut(region) > 0.) {
+        cuts << utrRegionTools::getProductionCut(region) / mm << " mm]";
+      } else {
+        cuts << "default]";
+      }
+    }
+    return cuts.str();
+  } else if (command == stackingKillParticleCmd || command == stackingKillBelowCmd || command == stackingKillInVolumeCmd || command == stackingKillInRegionCmd || command == stackingKillUnreachableCmd) {
+    std::stringstream rules;
+    for (const auto &rule : StackingAction::GetRules()) {
+      rules << "[" << rule.description << "]";
+    }
+    return rules.str();
+#ifdef ESCAPE_CULLING
+  } else if (command == cullRoomScatterCmd) {
+    return cullRoomScatterCmd->ConvertToString(SteppingAction::GetRoomScatter());
+  } else if (command == cullMarginCmd) {
+    return cullMarginCmd->ConvertToString(SteppingAction::GetMargin(), "mm");
+  } else if (command == cullSampleEveryCmd) {
+    return cullSampleEveryCmd->ConvertToString(SteppingAction::GetSampleEvery());
+#endif
+#ifdef FORCED_INTERACTION
+  } else if (command == biasForcedInteractionCmd) {
+    return biasForcedInteractionCmd->ConvertToString(utrBiasingTools::getForcedInteraction());
+  } else if (command == biasAnalogFOMCmd) {
+    return biasAnalogFOMCmd->ConvertToString(utrBiasingTools::getAnalogFigureOfMerit());
+#endif
+  } else if (command == phaseSpaceRecordCmd) {
+    return utrPhaseSpaceTools::getRecordFilename();
+  } else if (command == phaseSpaceKillRecordedCmd) {
+    return phaseSpaceKillRecordedCmd->ConvertToString(utrPhaseSpaceTools::getKillRecorded());
+#ifdef GENERATOR_PHASESPACE
+  } else if (command == phaseSpaceReplayCmd) {
+    return utrPhaseSpaceTools::getReplayFilename();
+  } else if (command == phaseSpaceAccessCmd) {
+    return utrPhaseSpaceTools::getSequentialAccess() ? "sequential" : "random";
+  } else if (command == phaseSpaceRecycleCmd) {
+    return phaseSpaceRecycleCmd->ConvertToString(utrPhaseSpaceTools::getRecycle());
+#endif
+  } else if (command == regionEmPhysicsCmd) {
+    std::stringstream types;
+    for (const auto &region : utrRegionTools::getRegionNames()) {
+      types << "[" << region << " " << (utrRegionTools::getEmPhysics(region) == "" ? G4String("default") : utrRegionTools::getEmPhysics(region)) << "]";
+    }
+    return types.str();
+#if !defined(EVENT_HISTOGRAM) && !defined(EVENT_EVENTWISE_SPARSE) && !defined(EVENT_EVENTWISE)
+  } else if (command == outputQuantitiesCmd) {
+    return utrOutputTools::getSelection();
+#endif
+#ifdef EVENT_HISTOGRAM
+  } else if (command == histogramBinningCmd) {
+    return histogramBinningCmd->ConvertToString(utrHistogramTools::getBinning(), "keV");
+  } else if (command == histogramMaxEnergyCmd) {
+    return histogramMaxEnergyCmd->ConvertToString(utrHistogramTools::getMaxEnergy(), "MeV");
+  } else if (command == histogramAddbackCmd) {
+    std::stringstream groups;
+    for (const auto &group : utrHistogramTools::getAddbackGroups()) {
+      groups << "[";
+      for (size_t i = 0; i < group.size(); ++i) {
+        groups << (i == 0 ? "" : " ") << group[i];
+      }
+      groups << "]";
+    }
+    return groups.str();
+#endif
   }
   return "Error! unknown command!";
 }
@@ -0,0 +1,184 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "utrOutputTools.hh"
+
+#include "G4Threading.hh"
+
+#include "utrConfig.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+using std::stringstream;
+
+utrOutputTools::utrOutputTools() {}
+utrOutputTools::~utrOutputTools() {}
+
+static vector<bool> defaultSelection() {
+  vector<bool> selection(NFLAGS, false);
+
+#ifdef EVENT_ID
+  selection[ID] = true;
+#endif
+#ifdef EVENT_EDEP
+  selection[EDEP] = true;
+#endif
+#ifdef EVENT_EKIN
+  selection[EKIN] = true;
+#endif
+#ifdef EVENT_PARTICLE
+  selection[PARTICLE] = true;
+#endif
+#ifdef EVENT_VOLUME
+  selection[VOLUME] = true;
+#endif
+#ifdef EVENT_POSX
+  selection[POSX] = true;
+#endif
+#ifdef EVENT_POSY
+  selection[POSY] = true;
+#endif
+#ifdef EVENT_POSZ
+  selection[POSZ] = true;
+#endif
+#ifdef EVENT_MOMX
+  selection[MOMX] = true;
+#endif
+#ifdef EVENT_MOMY
+  selection[MOMY] = true;
+#endif
+#ifdef EVENT_MOMZ
+  selection[MOMZ] = true;
+#endif
+#ifdef EVENT_WEIGHT
+  selection[WEIGHT] = true;
+#endif
+
+  return selection;
+}
+
+vector<bool> utrOutputTools::recordQuantity = defaultSelection();
+
+G4ThreadLocal utrOutputTools::ColumnFiller utrOutputTools::fillPlan[NFLAGS];
+G4ThreadLocal G4int utrOutputTools::nColumns = 0;
+G4ThreadLocal bool utrOutputTools::particleInPlan = false;
+G4ThreadLocal bool utrOutputTools::positionInPlan = false;
+G4ThreadLocal bool utrOutputTools::momentumInPlan = false;
+
+// One filler for each quantity, in the order of the output_flags
+static void fillID(G4int column, const OutputRecord &record) { RunAction::FillIntColumn(column, record.eventID); }
+static void fillEdep(G4int column, const OutputRecord &record) { RunAction::FillRealColumn(column, record.edep); }
+static void fillEkin(G4int column, const OutputRecord &record) { RunAction::FillRealColumn(column, record.ekin); }
+static void fillParticle(G4int column, const OutputRecord &record) { RunAction::FillIntColumn(column, record.particle); }
+static void fillVolume(G4int column, const OutputRecord &record) { RunAction::FillIntColumn(column, record.volume); }
+static void fillPosX(G4int column, const OutputRecord &record) { RunAction::FillRealColumn(column, record.position.x()); }
+static void fillPosY(G4int column, const OutputRecord &record) { RunAction::FillRealColumn(column, record.position.y()); }
+static void fillPosZ(G4int column, const OutputRecord &record) { RunAction::FillRealColumn(column, record.position.z()); }
+static void fillMomX(G4int column, const OutputRecord &record) { RunAction::FillRealColumn(column, record.momentum.x()); }
+static void fillMomY(G4int column, const OutputRecord &record) { RunAction::FillRealColumn(column, record.momentum.y()); }
+static void fillMomZ(G4int column, const OutputRecord &record) { RunAction::FillRealColumn(column, record.momentum.z()); }
+static void fillWeight(G4int column, const OutputRecord &record) { RunAction::FillRealColumn(column, record.weight); }
+
+static void (*const fillers[NFLAGS])(G4int, const OutputRecord &) = {fillID, fillEdep, fillEkin, fillParticle, fillVolume, fillPosX, fillPosY, fillPosZ, fillMomX, fillMomY, fillMomZ, fillWeight};
+static const bool isIntQuantity[NFLAGS] = {true, false, false, true, true, false, false, false, false, false, false, false};
+
+// The column names are the same as with the EVENT_* build options
+static const char *const columnNames[NFLAGS] = {"event", "edep", "ekin", "particle", "volume", "x", "y", "z", "vx", "vy", "vz", "weight"};
+
+G4int utrOutputTools::findFlag(const G4String &name) {
+  std::string upperName = name;
+  std::transform(upperName.begin(), upperName.end(), upperName.begin(), [](unsigned char c) { return (char)std::toupper(c); });
+  for (G4int i = 0; i < NFLAGS; ++i) {
+    if (upperName == RunAction::GetOutputFlagName(i)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool utrOutputTools::setRecordQuantity(const G4String &name, bool record) {
+  const G4int flag = findFlag(name);
+  if (flag < 0) {
+    return false;
+  }
+  recordQuantity[flag] = record;
+  return true;
+}
+
+bool utrOutputTools::setRecordQuantities(const vector<G4String> &names) {
+  vector<bool> selection(NFLAGS, false);
+  for (const auto &name : names) {
+    const G4int flag = findFlag(name);
+    if (flag < 0) {
+      return false;
+    }
+    selection[flag] = true;
+  }
+  recordQuantity = selection;
+  return true;
+}
+
+G4String utrOutputTools::getSelection() {
+  stringstream selection;
+  for (G4int i = 0; i < NFLAGS; ++i) {
+    if (recordQuantity[i]) {
+      selection << (selection.tellp() > 0 ? " " : "") << RunAction::GetOutputFlagName(i);
+    }
+  }
+  return selection.str();
+}
+
+void utrOutputTools::book(bool printSelection) {
+  nColumns = 0;
+  for (G4int i = 0; i < NFLAGS; ++i) {
+    if (recordQuantity[i]) {
+      if (isIntQuantity[i]) {
+        RunAction::CreateIntColumn(columnNames[i]);
+      } else {
+        RunAction::CreateRealColumn(columnNames[i]);
+      }
+      fillPlan[nColumns] = fillers[i];
+      ++nColumns;
+    }
+  }
+  particleInPlan = recordQuantity[PARTICLE];
+  positionInPlan = recordQuantity[POSX] || recordQuantity[POSY] || recordQuantity[POSZ];
+  momentumInPlan = recordQuantity[MOMX] || recordQuantity[MOMY] || recordQuantity[MOMZ];
+
+  if (printSelection && G4Threading::IsMasterThread()) {
+    G4cout << "================================================================================" << G4endl;
+    G4cout << "utrOutputTools: The following quantities will be saved to the output file:" << G4endl;
+    for (G4int i = 0; i < NFLAGS; ++i) {
+      if (recordQuantity[i]) {
+        G4cout << RunAction::GetOutputFlagName(i) << G4endl;
+      }
+    }
+    G4cout << "================================================================================" << G4endl;
+  }
+}
+
+void utrOutputTools::fill(const OutputRecord &record) {
+  for (G4int i = 0; i < nColumns; ++i) {
+    fillPlan[i](i, record);
+  }
+  RunAction::AddNtupleRow();
+}
@@ -0,0 +1,189 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "utrPhaseSpaceTools.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include "G4AutoLock.hh"
+#include "G4FileUtilities.hh"
+#include "G4Threading.hh"
+
+// Number of records that a thread buffers before they are written to its part file
+#define PHASESPACE_BUFFER_SIZE 4096
+
+namespace {
+G4Mutex partFilenamesMutex = G4MUTEX_INITIALIZER;
+
+// A phase-space file with missing records would silently bias the second stage, so every write fails loudly
+void writeOrAbort(const void *data, size_t n_bytes, FILE *file, const G4String &filename) {
+  if (fwrite(data, 1, n_bytes, file) != n_bytes) {
+    G4cerr << "ERROR: Failed to write to the phase-space file '" << filename << "'! Aborting..." << G4endl;
+    throw std::exception();
+  }
+}
+} // namespace
+
+utrPhaseSpaceTools::utrPhaseSpaceTools() {}
+utrPhaseSpaceTools::~utrPhaseSpaceTools() {}
+
+G4String utrPhaseSpaceTools::recordFilename = "";
+bool utrPhaseSpaceTools::killRecorded = true;
+
+G4String utrPhaseSpaceTools::replayFilename = "";
+bool utrPhaseSpaceTools::sequentialAccess = true;
+G4int utrPhaseSpaceTools::recycle = 1;
+std::atomic<uint64_t> utrPhaseSpaceTools::sequentialUses(0);
+G4String utrPhaseSpaceTools::replayedFilename = "";
+
+G4long utrPhaseSpaceTools::recordedEvents = 0;
+vector<G4String> utrPhaseSpaceTools::partFilenames = vector<G4String>();
+
+G4ThreadLocal FILE *utrPhaseSpaceTools::partFile = nullptr;
+G4ThreadLocal vector<PhaseSpaceRecord> *utrPhaseSpaceTools::buffer = nullptr;
+
+void utrPhaseSpaceTools::beginRun() {
+  G4FileUtilities fu;
+  if (fu.FileExists(recordFilename)) {
+    G4cerr << "ERROR: Designated phase-space file '" << recordFilename << "' already exists! Aborting..." << G4endl;
+    throw std::exception();
+  }
+  recordedEvents = 0;
+}
+
+void utrPhaseSpaceTools::beginReplay() {
+  // Like the per-thread mapping of the file, the counter continues over the runs with the same file
+  if (replayFilename != replayedFilename) {
+    replayedFilename = replayFilename;
+    sequentialUses = 0;
+  }
+}
+
+void utrPhaseSpaceTools::write(const PhaseSpaceRecord &record) {
+  // The part file is created by the first record of a thread, so threads without records do not leave
+  // empty files
+  if (!partFile) {
+    std::stringstream filename;
+    filename << recordFilename << "_t" << std::max(G4Threading::G4GetThreadId(), 0);
+    partFile = fopen(filename.str().c_str(), "wb");
+    if (!partFile) {
+      G4cerr << "ERROR: Phase-space part file '" << filename.str() << "' could not be created! Aborting..." << G4endl;
+      throw std::exception();
+    }
+    G4AutoLock lock(&partFilenamesMutex);
+    partFilenames.push_back(filename.str());
+  }
+  if (!buffer) {
+    buffer = new vector<PhaseSpaceRecord>();
+    buffer->reserve(PHASESPACE_BUFFER_SIZE);
+  }
+
+  buffer->push_back(record);
+  if (buffer->size() == PHASESPACE_BUFFER_SIZE) {
+    flush();
+  }
+}
+
+void utrPhaseSpaceTools::flush() {
+  if (!buffer->empty() && fwrite(buffer->data(), sizeof(PhaseSpaceRecord), buffer->size(), partFile) != buffer->size()) {
+    G4cerr << "ERROR: Failed to write to the phase-space part file of thread " << G4Threading::G4GetThreadId() << "! Aborting..." << G4endl;
+    throw std::exception();
+  }
+  buffer->clear();
+}
+
+void utrPhaseSpaceTools::endRun(G4int n_events, bool master, bool last_point) {
+  if (master) {
+    recordedEvents += n_events;
+  }
+  if (!last_point) {
+    return;
+  }
+
+  if (partFile) {
+    flush();
+    if (fclose(partFile) != 0) {
+      G4cerr << "ERROR: Failed to write to the phase-space part file of thread " << G4Threading::G4GetThreadId() << "! Aborting..." << G4endl;
+      throw std::exception();
+    }
+    partFile = nullptr;
+  }
+  // The worker threads have finished their runs before the master thread ends its run
+  if (master) {
+    merge();
+  }
+}
+
+void utrPhaseSpaceTools::merge() {
+  FILE *file = fopen(recordFilename.c_str(), "wb");
+  if (!file) {
+    G4cerr << "ERROR: Phase-space file '" << recordFilename << "' could not be created! Aborting..." << G4endl;
+    throw std::exception();
+  }
+
+  PhaseSpaceHeader header;
+  std::memcpy(header.magic, PHASESPACE_MAGIC, sizeof(header.magic));
+  header.version = PHASESPACE_VERSION;
+  header.record_size = sizeof(PhaseSpaceRecord);
+  header.n_records = 0;
+  header.n_primaries = (uint64_t)recordedEvents;
+  // Written again below, when the number of records is known
+  writeOrAbort(&header, sizeof(header), file, recordFilename);
+
+  // The parts are concatenated in the order in which the threads created them. Since the events are
+  // distributed dynamically between the threads, the order of the records is not reproducible anyway.
+  vector<char> chunk(PHASESPACE_BUFFER_SIZE * sizeof(PhaseSpaceRecord));
+  for (const auto &partFilename : partFilenames) {
+    FILE *part = fopen(partFilename.c_str(), "rb");
+    if (!part) {
+      G4cerr << "ERROR: Phase-space part file '" << partFilename << "' could not be opened! Aborting..." << G4endl;
+      throw std::exception();
+    }
+    size_t n_bytes;
+    while ((n_bytes = fread(chunk.data(), 1, chunk.size(), part)) > 0) {
+      writeOrAbort(chunk.data(), n_bytes, file, recordFilename);
+      header.n_records += n_bytes / sizeof(PhaseSpaceRecord);
+    }
+    if (ferror(part)) {
+      G4cerr << "ERROR: Failed to read the phase-space part file '" << partFilename << "'! Aborting..." << G4endl;
+      throw std::exception();
+    }
+    fclose(part);
+    remove(partFilename.c_str());
+  }
+  partFilenames.clear();
+
+  if (fseek(file, 0, SEEK_SET) != 0) {
+    G4cerr << "ERROR: Failed to write to the phase-space file '" << recordFilename << "'! Aborting..." << G4endl;
+    throw std::exception();
+  }
+  writeOrAbort(&header, sizeof(header), file, recordFilename);
+  if (fclose(file) != 0) {
+    G4cerr << "ERROR: Failed to write the phase-space file '" << recordFilename << "'! Aborting..." << G4endl;
+    throw std::exception();
+  }
+
+  G4cout << "Wrote " << header.n_records << " phase-space records of " << header.n_primaries << " events to '" << recordFilename << "'" << G4endl;
+  if (header.n_records == 0) {
+    G4cout << "WARNING: No particles were recorded. Does the geometry contain a PhaseSpaceSD?" << G4endl;
+  }
+}
@@ -0,0 +1,133 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "utrRegionTools.hh"
+
+#include "G4EmParameters.hh"
+#include "G4ProductionCuts.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+#include "G4UnitsTable.hh"
+
+#include "utrConfig.h"
+
+#include <sstream>
+
+utrRegionTools::utrRegionTools() {}
+utrRegionTools::~utrRegionTools() {}
+
+const vector<G4String> utrRegionTools::regionNames = {"detector", "target", "shielding", "infrastructure"};
+
+// With EM_REGIONS, the global EM physics is the fast G4EmStandardPhysics_option1, and the precise low-energy
+// models are only used in the detectors and targets. Secondaries in the shielding and the infrastructure
+// are only produced above a larger cut.
+#ifdef EM_REGIONS
+map<G4String, G4double> utrRegionTools::productionCuts = {{"shielding", 1. * cm}, {"infrastructure", 1. * cm}};
+map<G4String, G4String> utrRegionTools::emPhysics = {{"detector", "G4EmLivermore"}, {"target", "G4EmLivermore"}};
+#else
+map<G4String, G4double> utrRegionTools::productionCuts = map<G4String, G4double>();
+map<G4String, G4String> utrRegionTools::emPhysics = map<G4String, G4String>();
+#endif
+
+bool utrRegionTools::isRegionName(const G4String &region) {
+  for (const auto &name : regionNames) {
+    if (region == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void utrRegionTools::addLogicalVolume(const G4String &region, G4LogicalVolume *logical) {
+  if (!isRegionName(region)) {
+    G4cerr << "ERROR: utrRegionTools: Unknown region '" << region << "' for the logical volume '" << logical->GetName() << "'. Aborting..." << G4endl;
+    throw std::exception();
+  }
+  G4RegionStore::GetInstance()->FindOrCreateRegion(region)->AddRootLogicalVolume(logical);
+}
+
+G4double utrRegionTools::getProductionCut(const G4String &region) {
+  const auto cut = productionCuts.find(region);
+  return cut == productionCuts.end() ? -1. : cut->second;
+}
+
+G4String utrRegionTools::getEmPhysics(const G4String &region) {
+  const auto type = emPhysics.find(region);
+  return type == emPhysics.end() ? "" : type->second;
+}
+
+void utrRegionTools::applyProductionCuts() {
+  // The regions and their cuts are shared by all threads
+  if (!G4Threading::IsMasterThread()) {
+    return;
+  }
+
+  G4ProductionCuts *defaultCuts = G4ProductionCutsTable::GetProductionCutsTable()->GetDefaultProductionCuts();
+  bool anyRegion = false;
+  for (const auto &name : regionNames) {
+    G4Region *region = G4RegionStore::GetInstance()->GetRegion(name, false);
+    if (region == nullptr) {
+      continue;
+    }
+    if (!anyRegion) {
+      G4cout << "================================================================================" << G4endl;
+      G4cout << "utrRegionTools: Regions of the geometry (production cut, EM physics):" << G4endl;
+      anyRegion = true;
+    }
+
+    const G4double cut = getProductionCut(name);
+    std::stringstream cutDescription;
+    if (cut > 0.) {
+      G4ProductionCuts *cuts = region->GetProductionCuts();
+      if (cuts == nullptr || cuts == defaultCuts) {
+        cuts = new G4ProductionCuts();
+        region->SetProductionCuts(cuts);
+      }
+      cuts->SetProductionCut(cut);
+      cutDescription << G4BestUnit(cut, "Length");
+    } else {
+      region->SetProductionCuts(defaultCuts);
+      cutDescription << "global cut";
+    }
+    G4cout << name << ": " << region->GetNumberOfRootVolumes() << " volume(s), " << cutDescription.str() << ", " << (getEmPhysics(name) == "" ? G4String("global EM physics") : getEmPhysics(name)) << G4endl;
+  }
+  if (anyRegion) {
+    G4cout << "================================================================================" << G4endl;
+  }
+}
+
+void utrRegionTools::addEmPhysics() {
+  for (const auto &name : regionNames) {
+    const G4String type = getEmPhysics(name);
+    if (type == "") {
+      continue;
+    }
+    if (G4RegionStore::GetInstance()->GetRegion(name, false) == nullptr) {
+      if (G4Threading::IsMasterThread()) {
+        G4cout << "utrRegionTools: The geometry has no volume in the region '" << name << "', the EM physics " << type << " is not used." << G4endl;
+      }
+      continue;
+    }
+    G4EmParameters::Instance()->AddPhysics(name, type);
+  }
+}
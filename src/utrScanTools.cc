@@ -0,0 +1,119 @@
+/*
+utr - Geant4 simulation of the UTR at HIGS
+Copyright (C) 2017 the developing team (see README.md)
+
+This file is part of utr.
+
+utr is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+utr is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with utr.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "utrScanTools.hh"
+
+#include "G4RunManager.hh"
+#include "G4Timer.hh"
+#include "G4UImanager.hh"
+
+#include <iomanip>
+#include <sstream>
+
+using std::stringstream;
+
+utrScanTools::utrScanTools() {}
+utrScanTools::~utrScanTools() {}
+
+G4String utrScanTools::scanMacro = "";
+vector<vector<std::pair<G4String, G4String>>> utrScanTools::points = vector<vector<std::pair<G4String, G4String>>>();
+bool utrScanTools::scanning = false;
+unsigned int utrScanTools::currentPoint = 0;
+
+bool utrScanTools::addPoint(const G4String &parameters) {
+  vector<std::pair<G4String, G4String>> point;
+  std::istringstream iStrStream(parameters);
+  for (std::string s; iStrStream >> s;) {
+    const size_t pos = s.find('=');
+    if (pos == std::string::npos || pos == 0 || pos + 1 == s.length()) {
+      return false;
+    }
+    point.push_back(std::make_pair(G4String(s.substr(0, pos)), G4String(s.substr(pos + 1))));
+  }
+  if (point.empty()) {
+    return false;
+  }
+  points.push_back(point);
+  return true;
+}
+
+G4String utrScanTools::getPointParameters(size_t point) {
+  stringstream parameters;
+  for (const auto &parameter : points[point]) {
+    parameters << (parameters.tellp() > 0 ? " " : "") << parameter.first << "=" << parameter.second;
+  }
+  return parameters.str();
+}
+
+vector<string> utrScanTools::getOutputPrefixes() {
+  if (!scanning) {
+    return vector<string>(1, "");
+  }
+  vector<string> prefixes;
+  for (size_t i = 0; i < points.size(); ++i) {
+    prefixes.push_back("p" + std::to_string(i) + "_");
+  }
+  return prefixes;
+}
+
+void utrScanTools::beamOn(G4int nevents) {
+  if (points.empty()) {
+    G4cerr << "Error! No scan points were defined with /utr/scan/addPoint!" << G4endl;
+    return;
+  }
+
+  G4UImanager *UImanager = G4UImanager::GetUIpointer();
+  G4RunManager *runManager = G4RunManager::GetRunManager();
+  vector<G4double> realTimes;
+
+  scanning = true;
+  for (currentPoint = 0; currentPoint < points.size(); ++currentPoint) {
+    G4cout << "utrScanTools: Running point p" << currentPoint << " (" << currentPoint + 1 << " of " << points.size() << "): " << getPointParameters(currentPoint) << G4endl;
+    for (const auto &parameter : points[currentPoint]) {
+      UImanager->SetAlias((parameter.first + " " + parameter.second).c_str());
+    }
+    // The output file of the scan is already open after the first point, so a failure can not be skipped
+    if (scanMacro != "" && UImanager->ApplyCommand("/control/execute " + scanMacro) != fCommandSucceeded) {
+      G4cerr << "ERROR: utrScanTools: Execution of the scan macro '" << scanMacro << "' failed for point " << currentPoint << ". Aborting..." << G4endl;
+      throw std::exception();
+    }
+
+    G4Timer timer;
+    timer.Start();
+    runManager->BeamOn(nevents);
+    timer.Stop();
+    realTimes.push_back(timer.GetRealElapsed());
+  }
+  scanning = false;
+  currentPoint = 0;
+
+  G4double totalTime = 0.;
+  const std::streamsize precision = G4cout.precision();
+  G4cout << "================================================================================" << G4endl;
+  G4cout << "utrScanTools: Summary of the scan with " << points.size() << " points of " << nevents << " events" << G4endl;
+  G4cout << std::left << std::setw(8) << "Point" << std::setw(16) << "Real time / s" << std::setw(16) << "Events / s"
+         << "Parameters" << G4endl;
+  for (size_t i = 0; i < points.size(); ++i) {
+    G4cout << std::setw(8) << ("p" + std::to_string(i)) << std::setw(16) << std::setprecision(4) << realTimes[i] << std::setw(16) << std::setprecision(4) << (realTimes[i] > 0. ? nevents / realTimes[i] : 0.) << getPointParameters(i) << G4endl;
+    totalTime += realTimes[i];
+  }
+  G4cout << std::setw(8) << "Total" << std::setprecision(4) << totalTime << G4endl;
+  G4cout << std::right << std::setprecision(precision) << "================================================================================" << G4endl;
+}
@@ -1,6 +1,7 @@
 #include <argp.h>
 #include <iostream>
 #include <stdlib.h>
+#include <vector>
 
 #include <TChain.h>
 #include <TF2.h>
@@ -100,13 +101,17 @@ class W_Function {
     //
     //	END OF USER-DEFINED OUTPUT
     //
-  };
 
-  Double_t operator()(Double_t *x, Double_t *par) {
+    // Look up the angular distribution only once, not for every bin in every fit iteration
     if (is_unpolarized) {
-      return par[0] * sin(x[0]) * (angdist.AngDist(x[0], x[1], states, nstates, mix) + angdist.AngDist(x[0], x[1], alt_states, nstates, mix));
+      kernel = angdist.Resolve(states, alt_states, nstates, mix, 1.);
+    } else {
+      kernel = angdist.Resolve(states, nstates, mix);
     }
-    return par[0] * sin(x[0]) * angdist.AngDist(x[0], x[1], states, nstates, mix);
+  };
+
+  Double_t operator()(Double_t *x, Double_t *par) {
+    return par[0] * sin(x[0]) * kernel(cos(x[0]), x[1]);
   }
 
   double states[4];
@@ -116,6 +121,7 @@ class W_Function {
   bool is_unpolarized;
 
   AngularDistribution angdist;
+  AngularDistributionKernel kernel;
 };
 
 int main(int argc, char *argv[]) {
@@ -213,9 +219,23 @@ int main(int argc, char *argv[]) {
 
     TH2F *residuals = new TH2F("residuals", "(absolute value of) Residuals of momentum distribution in (theta, phi)", nbins_theta, theta_low, theta_up, nbins_phi, phi_low, phi_up);
 
+    // Evaluate the angular distribution for all bins at once
+    const size_t nbins = (size_t)(nbins_theta * nbins_phi);
+    vector<double> cos_theta(nbins), cos_phi(nbins), sin_phi(nbins), w(nbins);
+    for (Int_t th = 0; th < nbins_theta; ++th) {
+      for (Int_t ph = 0; ph < nbins_phi; ++ph) {
+        const size_t bin = (size_t)(th * nbins_phi + ph);
+        cos_theta[bin] = cos(hist->GetXaxis()->GetBinCenter(th));
+        cos_phi[bin] = cos(hist->GetYaxis()->GetBinCenter(ph));
+        sin_phi[bin] = sin(hist->GetYaxis()->GetBinCenter(ph));
+      }
+    }
+    w_function.kernel.Evaluate(nbins, cos_theta.data(), cos_phi.data(), sin_phi.data(), w.data());
+
     for (Int_t th = 0; th < nbins_theta; ++th) {
       for (Int_t ph = 0; ph < nbins_phi; ++ph) {
-        residuals->SetBinContent(th, ph, abs(hist->GetBinContent(th, ph) - ang_dist->Eval(hist->GetXaxis()->GetBinCenter(th), hist->GetYaxis()->GetBinCenter(ph))));
+        const size_t bin = (size_t)(th * nbins_phi + ph);
+        residuals->SetBinContent(th, ph, abs(hist->GetBinContent(th, ph) - ang_dist->GetParameter(0) * sin(hist->GetXaxis()->GetBinCenter(th)) * w[bin]));
       }
     }
 
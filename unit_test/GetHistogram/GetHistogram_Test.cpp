@@ -0,0 +1,358 @@
+#include <argp.h>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include <TFile.h>
+#include <TH1.h>
+#include <TRandom3.h>
+#include <TTree.h>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+static char doc[] = "GetHistogram_Test";
+static char args_doc[] = "Compare the output of the parallel and the sequential mode of getHistogram for random input files";
+
+struct arguments {
+  const char *getHistogram;
+  const char *dir;
+  unsigned int nthreads;
+
+  arguments() : getHistogram("./getHistogram"), dir("."), nthreads(4){};
+};
+
+static struct argp_option options[] = {
+    {0, 'g', "GETHISTOGRAM", 0, "Path to the getHistogram executable (default: ./getHistogram)"},
+    {0, 'd', "DIR", 0, "Directory for the test files (default: .)"},
+    {0, 'T', "THREADS", 0, "Number of threads of the parallel mode (default: 4)"},
+    {0, 0, 0, 0, 0}};
+
+static error_t parse_opt(int key, char *arg, struct argp_state *state) {
+
+  struct arguments *args = (struct arguments *)state->input;
+
+  switch (key) {
+    case ARGP_KEY_ARG:
+      break;
+    case 'g':
+      args->getHistogram = arg;
+      break;
+    case 'd':
+      args->dir = arg;
+      break;
+    case 'T':
+      args->nthreads = (unsigned int)atoi(arg);
+      break;
+    case ARGP_KEY_END:
+      break;
+    default:
+      return ARGP_ERR_UNKNOWN;
+  }
+  return 0;
+}
+
+static struct argp argp = {options, parse_opt, args_doc, doc};
+
+const unsigned int nfiles = 3;
+const unsigned int maxid = 4;
+
+// Writes nfiles files with the tree 'utr', whose entries are grouped into events of one to a few energy depositions.
+// Some entries have a volume ID larger than maxid, which getHistogram has to skip.
+// The weights are multiples of 1/16, so that their sums do not depend on the order of the additions, which is
+// different in the sequential and the parallel mode.
+// With int_columns, 'event' and 'volume' are written as int columns and 'edep' as a float column, like with the
+// EVENT_INT_COLUMNS and EVENT_FLOAT_COLUMNS options of utr.
+void writeFiles(const string &dir, const string &prefix, const bool int_columns, TRandom3 &random) {
+  double event = 0.;
+  for (unsigned int i = 0; i < nfiles; ++i) {
+    stringstream filename;
+    filename << dir << "/" << prefix << "_t" << i << ".root";
+    TFile file(filename.str().c_str(), "RECREATE");
+    TTree tree("utr", "utr");
+
+    double edep_d, volume_d, event_d, weight_d;
+    float edep_f, weight_f;
+    int volume_i, event_i;
+    if (int_columns) {
+      tree.Branch("edep", &edep_f, "edep/F");
+      tree.Branch("volume", &volume_i, "volume/I");
+      tree.Branch("event", &event_i, "event/I");
+      tree.Branch("weight", &weight_f, "weight/F");
+    } else {
+      tree.Branch("edep", &edep_d, "edep/D");
+      tree.Branch("volume", &volume_d, "volume/D");
+      tree.Branch("event", &event_d, "event/D");
+      tree.Branch("weight", &weight_d, "weight/D");
+    }
+
+    // The first entry must have a valid volume ID for the sequential mode
+    const unsigned int nentries = 500 + random.Integer(500);
+    for (unsigned int j = 0; j < nentries; ++j) {
+      // An event may continue in the next file
+      if (random.Rndm() < 0.4) {
+        event += 1.;
+      }
+      edep_d = random.Uniform(0., 2.);
+      volume_d = (i == 0 && j == 0) ? 0. : (double)random.Integer(maxid + 2);
+      event_d = event;
+      weight_d = (double)(1 + random.Integer(32)) / 16.;
+      edep_f = (float)edep_d;
+      weight_f = (float)weight_d;
+      volume_i = (int)volume_d;
+      event_i = (int)event_d;
+      tree.Fill();
+    }
+    tree.Write();
+    file.Close();
+  }
+}
+
+// Writes a single file with ntiny entries in events of one or two energy depositions. In the parallel mode with ntiny threads,
+// each range contains exactly one unit.
+const unsigned int ntiny = 12;
+
+void writeTinyFile(const string &dir, const string &prefix, TRandom3 &random) {
+  const string filename = dir + "/" + prefix + "_t0.root";
+  TFile file(filename.c_str(), "RECREATE");
+  TTree tree("utr", "utr");
+
+  double edep, volume, event = 0., weight;
+  tree.Branch("edep", &edep, "edep/D");
+  tree.Branch("volume", &volume, "volume/D");
+  tree.Branch("event", &event, "event/D");
+  tree.Branch("weight", &weight, "weight/D");
+  for (unsigned int j = 0; j < ntiny; ++j) {
+    if (random.Rndm() < 0.5) {
+      event += 1.;
+    }
+    edep = random.Uniform(0., 2.);
+    volume = (double)random.Integer(maxid + 1);
+    weight = (double)(1 + random.Integer(32)) / 16.;
+    tree.Fill();
+  }
+  tree.Write();
+  file.Close();
+}
+
+// Writes nsmall files with a few entries each, so that every file consists of a single basket that starts at entry 0.
+// Their histograms are written to '<prefix>_expected_hist.root' with the binning of 'getHistogram -b 10 -e 5'.
+// A TChain deletes the tree of a file when it loads the next one, which may get the same address, so a reader that
+// identifies the baskets by the address of the tree would return the entries of the previous file.
+const unsigned int nsmall = 6;
+
+void writeSmallFiles(const string &dir, const string &prefix) {
+  const double binning = 10. / 1000.;
+  const double emin = 0 - binning / 2;
+  const int nbins = (int)ceil((5. - emin) / binning);
+  const double emax = emin + nbins * binning;
+
+  vector<TH1D *> expected;
+  for (unsigned int i = 0; i <= maxid; ++i) {
+    stringstream name;
+    name << "det" << i;
+    expected.push_back(new TH1D(name.str().c_str(), name.str().c_str(), nbins, emin, emax));
+  }
+  TH1D sum("sum", "sum", nbins, emin, emax);
+
+  for (unsigned int i = 0; i < nsmall; ++i) {
+    stringstream filename;
+    filename << dir << "/" << prefix << "_t" << i << ".root";
+    TFile file(filename.str().c_str(), "RECREATE");
+    TTree tree("utr", "utr");
+
+    double edep, volume;
+    tree.Branch("edep", &edep, "edep/D");
+    tree.Branch("volume", &volume, "volume/D");
+    for (unsigned int j = 0; j < 3; ++j) {
+      // Every file has different values
+      edep = 0.5 * (i + 1) + 0.1 * j;
+      volume = (double)((i + j) % (maxid + 1));
+      tree.Fill();
+      expected[(size_t)volume]->Fill(edep);
+      sum.Fill(edep);
+    }
+    tree.Write();
+    file.Close();
+  }
+
+  TFile file((dir + "/" + prefix + "_expected_hist.root").c_str(), "RECREATE");
+  for (auto hist : expected) {
+    hist->Write();
+  }
+  sum.Write();
+  file.Close();
+  for (auto hist : expected) {
+    delete hist;
+  }
+}
+
+// Writes a single file with a tree whose title marks it as written with /utr/mergeNtuples
+void writeMergedFile(const string &dir, const string &prefix) {
+  const string filename = dir + "/" + prefix + "_t0.root";
+  TFile file(filename.c_str(), "RECREATE");
+  TTree tree("utr", "Particle information (merged)");
+
+  double edep, volume, event;
+  tree.Branch("edep", &edep, "edep/D");
+  tree.Branch("volume", &volume, "volume/D");
+  tree.Branch("event", &event, "event/D");
+  for (unsigned int j = 0; j < 10; ++j) {
+    edep = 1.;
+    volume = 0.;
+    event = (double)(j / 2);
+    tree.Fill();
+  }
+  tree.Write();
+  file.Close();
+}
+
+// Returns false if any histogram in the two files has different bin contents or a different number of entries.
+// The other statistics are not compared, since the parallel mode combines them with TH1::Add in a different order.
+bool compareHistograms(const string &filename1, const string &filename2) {
+  TFile file1(filename1.c_str());
+  TFile file2(filename2.c_str());
+  if (file1.IsZombie() || file2.IsZombie()) {
+    cerr << "Error! Could not open '" << filename1 << "' or '" << filename2 << "'." << endl;
+    return false;
+  }
+
+  vector<string> names;
+  for (unsigned int i = 0; i <= maxid; ++i) {
+    stringstream name;
+    name << "det" << i;
+    names.push_back(name.str());
+  }
+  names.push_back("sum");
+
+  for (auto &name : names) {
+    TH1 *hist1 = (TH1 *)file1.Get(name.c_str());
+    TH1 *hist2 = (TH1 *)file2.Get(name.c_str());
+    if (hist1 == nullptr || hist2 == nullptr) {
+      cerr << "Error! Histogram '" << name << "' missing." << endl;
+      return false;
+    }
+    if (hist1->GetNbinsX() != hist2->GetNbinsX() || hist1->GetEntries() != hist2->GetEntries()) {
+      cerr << "Error! Histogram '" << name << "' has a different number of bins or entries." << endl;
+      return false;
+    }
+    for (int bin = 0; bin <= hist1->GetNbinsX() + 1; ++bin) {
+      if (hist1->GetBinContent(bin) != hist2->GetBinContent(bin)) {
+        cerr << "Error! Histogram '" << name << "' differs in bin " << bin << ": " << hist1->GetBinContent(bin) << " != " << hist2->GetBinContent(bin) << endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Runs getHistogram in the sequential and the parallel mode with the given options and compares the histograms
+bool compareModes(const arguments &args, const string &prefix, const string &options, const string &threads) {
+  stringstream sequential, parallel;
+  sequential << args.getHistogram << options << " -o " << prefix << "_seq_hist.root";
+  parallel << args.getHistogram << options << " -T " << threads << " -o " << prefix << "_par_hist.root";
+  if (system(sequential.str().c_str()) != 0 || system(parallel.str().c_str()) != 0) {
+    cerr << "Error! Execution of '" << args.getHistogram << "' failed." << endl;
+    return false;
+  }
+  return compareHistograms(string(args.dir) + "/" + prefix + "_seq_hist.root", string(args.dir) + "/" + prefix + "_par_hist.root");
+}
+
+int main(int argc, char *argv[]) {
+  struct arguments args;
+  argp_parse(&argp, argc, argv, 0, 0, &args);
+
+  TRandom3 random(42);
+  unsigned int nfailed = 0;
+
+  for (bool int_columns : {false, true}) {
+    const string prefix = int_columns ? "gethisttest_int" : "gethisttest_double";
+    writeFiles(args.dir, prefix, int_columns, random);
+
+    for (bool addback : {false, true}) {
+      for (bool weight : {false, true}) {
+        // Weights are only supported without multiplicity
+        for (unsigned int multiplicity = 1; multiplicity <= (weight ? 1u : 3u); ++multiplicity) {
+          stringstream options;
+          options << " -s -d " << args.dir << " -p " << prefix << "_t -n " << maxid << " -m " << multiplicity << " -b 10 -e 5";
+          if (addback) {
+            options << " -a";
+          }
+          if (weight) {
+            options << " -w";
+          }
+          const bool passed = compareModes(args, prefix, options.str(), std::to_string(args.nthreads));
+          cout << (passed ? "PASSED" : "FAILED") << ": " << (int_columns ? "int/float" : "double") << " columns, addback " << (addback ? "on" : "off") << ", weights " << (weight ? "on" : "off") << ", multiplicity " << multiplicity << endl;
+          if (!passed) {
+            nfailed++;
+          }
+        }
+      }
+    }
+  }
+
+  // -T 0 uses as many threads as the hardware supports
+  for (bool addback : {false, true}) {
+    stringstream options;
+    options << " -s -d " << args.dir << " -p gethisttest_double_t -n " << maxid << " -b 10 -e 5" << (addback ? " -a" : "");
+    const bool passed = compareModes(args, "gethisttest_double", options.str(), "0");
+    cout << (passed ? "PASSED" : "FAILED") << ": -T 0, addback " << (addback ? "on" : "off") << endl;
+    if (!passed) {
+      nfailed++;
+    }
+  }
+
+  // With as many threads as entries, each range contains a single unit, which is only stored as the head of the range
+  writeTinyFile(args.dir, "gethisttest_tiny", random);
+  for (bool addback : {false, true}) {
+    for (bool weight : {false, true}) {
+      for (unsigned int multiplicity = 1; multiplicity <= (weight ? 1u : 3u); ++multiplicity) {
+        stringstream options;
+        options << " -s -d " << args.dir << " -p gethisttest_tiny_t -n " << maxid << " -m " << multiplicity << " -b 10 -e 5" << (addback ? " -a" : "") << (weight ? " -w" : "");
+        const bool passed = compareModes(args, "gethisttest_tiny", options.str(), std::to_string(ntiny));
+        cout << (passed ? "PASSED" : "FAILED") << ": single-unit ranges, addback " << (addback ? "on" : "off") << ", weights " << (weight ? "on" : "off") << ", multiplicity " << multiplicity << endl;
+        if (!passed) {
+          nfailed++;
+        }
+      }
+    }
+  }
+
+  // Chains of small files, whose histograms are known
+  writeSmallFiles(args.dir, "gethisttest_small");
+  for (const string threads : {"1", "2"}) {
+    stringstream command;
+    command << args.getHistogram << " -s -d " << args.dir << " -p gethisttest_small_t -n " << maxid << " -b 10 -e 5 -T " << threads << " -o gethisttest_small_hist.root";
+    const bool passed = system(command.str().c_str()) == 0 && compareHistograms(string(args.dir) + "/gethisttest_small_expected_hist.root", string(args.dir) + "/gethisttest_small_hist.root");
+    cout << (passed ? "PASSED" : "FAILED") << ": chain of single-basket files, threads " << threads << endl;
+    if (!passed) {
+      nfailed++;
+    }
+  }
+
+  // Merged ntuples may split events, so getHistogram has to refuse them with addback, but accept them without
+  writeMergedFile(args.dir, "gethisttest_merged");
+  for (bool addback : {false, true}) {
+    stringstream command;
+    command << args.getHistogram << " -s -d " << args.dir << " -p gethisttest_merged_t -n 0 -b 10 -e 5 -o gethisttest_merged_hist.root" << (addback ? " -a" : "") << " > /dev/null 2>&1";
+    const bool succeeded = system(command.str().c_str()) == 0;
+    const bool passed = succeeded != addback;
+    cout << (passed ? "PASSED" : "FAILED") << ": merged ntuple, addback " << (addback ? "on (refused)" : "off") << endl;
+    if (!passed) {
+      nfailed++;
+    }
+  }
+
+  if (nfailed > 0) {
+    cerr << nfailed << " test(s) failed." << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,152 @@
+#include <argp.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <stdlib.h>
+#include <vector>
+
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+#include "G4VSolid.hh"
+
+#include "HPGe_Clover.hh"
+#include "HPGe_Collection.hh"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::vector;
+
+static char doc[] = "HPGe_Clover_Test";
+static char args_doc[] = "Compare the crystal solid of HPGe_Clover with the original one made of subtraction solids, and measure the speed of both";
+
+struct arguments {
+  long npoints;
+  unsigned int seed;
+
+  arguments() : npoints(1000000), seed(42){};
+};
+
+static struct argp_option options[] = {
+    {0, 'n', "NPOINTS", 0, "Number of random points (default: 1000000)"},
+    {0, 's', "SEED", 0, "Random number seed (default: 42)"},
+    {0, 0, 0, 0, 0}};
+
+static error_t parse_opt(int key, char *arg, struct argp_state *state) {
+
+  struct arguments *args = (struct arguments *)state->input;
+
+  switch (key) {
+    case ARGP_KEY_ARG:
+      break;
+    case 'n':
+      args->npoints = atol(arg);
+      break;
+    case 's':
+      args->seed = (unsigned int)atoi(arg);
+      break;
+    case ARGP_KEY_END:
+      break;
+    default:
+      return ARGP_ERR_UNKNOWN;
+  }
+  return 0;
+}
+
+static struct argp argp = {options, parse_opt, args_doc, doc, 0, 0, 0};
+
+// Random points in a box slightly larger than the crystal, half of them close to the flat sides and the anode hole,
+// where the two solids are most likely to differ, and random directions.
+void samplePoints(const HPGe_Clover_Properties &properties, const long npoints, const unsigned int seed, vector<G4ThreeVector> &points, vector<G4ThreeVector> &directions) {
+  std::mt19937_64 generator(seed);
+  std::uniform_real_distribution<double> uniform(0., 1.);
+  std::normal_distribution<double> surface(0., 0.1 * mm);
+
+  const G4double halfWidth = properties.crystal_radius + 1. * mm;
+  const G4double halfLength = 0.5 * properties.crystal_length + 1. * mm;
+  const G4double flatSides[4] = {-22. * mm, 23. * mm, -22. * mm, 23. * mm};
+
+  for (long i = 0; i < npoints; ++i) {
+    G4ThreeVector point((2. * uniform(generator) - 1.) * halfWidth, (2. * uniform(generator) - 1.) * halfWidth, (2. * uniform(generator) - 1.) * halfLength);
+    if (i % 2 == 1) {
+      const unsigned int side = (unsigned int)(uniform(generator) * 6.);
+      if (side < 2) {
+        point.setX(flatSides[side] + surface(generator));
+      } else if (side < 4) {
+        point.setY(flatSides[side] + surface(generator));
+      } else if (side == 4) {
+        point.setPerp(properties.anode_radius + surface(generator));
+      } else {
+        point.setZ(0.5 * properties.crystal_length - properties.anode_length + surface(generator));
+      }
+    }
+    points.push_back(point);
+
+    const G4double cosTheta = 2. * uniform(generator) - 1.;
+    const G4double phi = twopi * uniform(generator);
+    G4ThreeVector direction;
+    direction.setRThetaPhi(1., acos(cosTheta), phi);
+    directions.push_back(direction);
+  }
+}
+
+// Calls the functions that the navigation needs in each step for all points and returns the time per point in ns
+double measure(const G4VSolid &solid, const vector<G4ThreeVector> &points, const vector<G4ThreeVector> &directions, double &checksum) {
+  checksum = 0.;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < points.size(); ++i) {
+    if (solid.Inside(points[i]) == kOutside) {
+      const G4double distance = solid.DistanceToIn(points[i], directions[i]);
+      checksum += (distance == kInfinity) ? 0. : distance;
+    } else {
+      checksum += solid.DistanceToOut(points[i], directions[i]);
+    }
+  }
+  const std::chrono::duration<double, std::nano> nanoseconds = std::chrono::steady_clock::now() - start;
+  return nanoseconds.count() / (double)points.size();
+}
+
+int main(int argc, char *argv[]) {
+  struct arguments args;
+  argp_parse(&argp, argc, argv, 0, 0, &args);
+
+  HPGe_Collection hpge_Collection;
+  HPGe_Clover clover(nullptr, "clover");
+  clover.setProperties(hpge_Collection.HPGe_Clover_Yale);
+  const G4VSolid *crystal = clover.crystal_solid();
+  const G4VSolid *crystal_subtraction = clover.crystal_solid_subtraction();
+
+  vector<G4ThreeVector> points, directions;
+  samplePoints(hpge_Collection.HPGe_Clover_Yale, args.npoints, args.seed, points, directions);
+
+  // Points on the surface within the tolerance of one solid may be inside or outside for the other one
+  long ninside = 0, nsurface = 0, nmismatch = 0;
+  for (const auto &point : points) {
+    const EInside inside = crystal->Inside(point);
+    const EInside inside_subtraction = crystal_subtraction->Inside(point);
+    if (inside == kSurface || inside_subtraction == kSurface) {
+      ++nsurface;
+    } else if (inside != inside_subtraction) {
+      if (nmismatch < 10) {
+        cerr << "Error! Point " << point / mm << " mm is " << (inside == kInside ? "inside" : "outside") << " of crystal_solid, but " << (inside_subtraction == kInside ? "inside" : "outside") << " of crystal_solid_subtraction." << endl;
+      }
+      ++nmismatch;
+    } else if (inside == kInside) {
+      ++ninside;
+    }
+  }
+  cout << "Compared " << points.size() << " points, " << ninside << " inside, " << nsurface << " on the surface, " << nmismatch << " different" << endl;
+
+  double checksum, checksum_subtraction;
+  const double time = measure(*crystal, points, directions, checksum);
+  const double time_subtraction = measure(*crystal_subtraction, points, directions, checksum_subtraction);
+  cout << "crystal_solid            : " << time << " ns per point (checksum " << checksum / mm << " mm)" << endl;
+  cout << "crystal_solid_subtraction: " << time_subtraction << " ns per point (checksum " << checksum_subtraction / mm << " mm)" << endl;
+  cout << "Speedup: " << time_subtraction / time << endl;
+
+  if (nmismatch > 0) {
+    cerr << nmismatch << " point(s) are inside of one solid and outside of the other." << endl;
+    return 1;
+  }
+  return 0;
+}